@@ -0,0 +1,154 @@
+/**
+ * @file bench.h
+ * @brief Shared timing and reporting helpers for the benchmarks in bench/.
+ *
+ * Every benchmark is a standalone program, so these helpers live in the
+ * header. A measurement runs an operation over n elements several times and
+ * prints one row of a whitespace-separated table with the minimum, median and
+ * 99th percentile cost per element, in nanoseconds:
+ *
+ *     container op size reps min_ns median_ns p99_ns
+ *
+ * Small sizes are repeated in batches so that every sample covers enough work
+ * to rise well above the timer resolution. The BENCH_MAX_SIZE environment
+ * variable caps the sizes returned by bench_size() and bench_size_in() for
+ * quicker runs.
+ */
+#ifndef GAME_BENCH_H
+#define GAME_BENCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+    BENCH_MAX_REPS = 31,
+    BENCH_MIN_BATCH_WORK = 1 << 16,
+};
+
+static const size_t BENCH_SIZES[] = {16,    256,     4096,
+                                     65536, 1048576, 10000000};
+
+static const size_t BENCH_SIZE_COUNT =
+    sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]);
+
+/** Sink for results that must not be optimized away. */
+static volatile size_t bench_sink;
+
+/**
+ * @brief An operation to measure; called with a caller-provided context and
+ * the number of elements to process.
+ */
+typedef void (*bench_fn)(void* ctx, size_t n);
+
+/**
+ * @brief Reads a monotonic clock.
+ * @return The current time in nanoseconds.
+ */
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Gets the i-th size of a benchmark's own ascending size list,
+ * honoring BENCH_MAX_SIZE.
+ * @param sizes The size list, in ascending order.
+ * @param count The number of sizes in the list.
+ * @param index The index into the size list.
+ * @return The size, or 0 when the list is exhausted.
+ */
+static inline size_t bench_size_in(const size_t* sizes,
+                                   size_t count,
+                                   size_t index) {
+    const char* limit = getenv("BENCH_MAX_SIZE");
+    size_t max_size = limit ? strtoull(limit, nullptr, 10) : 0;
+
+    if (index >= count || (max_size > 0 && sizes[index] > max_size)) {
+        return 0;
+    }
+
+    return sizes[index];
+}
+
+/**
+ * @brief Gets the i-th benchmark size, honoring BENCH_MAX_SIZE.
+ * @param index The index into the size list.
+ * @return The size, or 0 when the list is exhausted.
+ */
+static inline size_t bench_size(size_t index) {
+    return bench_size_in(BENCH_SIZES, BENCH_SIZE_COUNT, index);
+}
+
+/**
+ * @brief Prints the header row of the result table.
+ */
+static inline void bench_print_header(void) {
+    printf("%-16s %-10s %10s %4s %10s %10s %10s\n", "container", "op", "size",
+           "reps", "min_ns", "median_ns", "p99_ns");
+}
+
+static inline int bench_compare_doubles(const void* lhs, const void* rhs) {
+    double a = *(const double*)lhs;
+    double b = *(const double*)rhs;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Measures an operation and prints its result row.
+ *
+ * Each sample calls setup, then times run, then calls teardown, repeated in a
+ * batch for small sizes. Only run is timed.
+ *
+ * @param container The name printed in the container column.
+ * @param op The name printed in the op column.
+ * @param n The number of elements each call of run processes.
+ * @param setup Prepares ctx before each timed call; may be NULL.
+ * @param run The operation to time.
+ * @param teardown Cleans up ctx after each timed call; may be NULL.
+ * @param ctx The context passed to all three functions.
+ */
+static inline void bench_measure(const char* container,
+                                 const char* op,
+                                 size_t n,
+                                 bench_fn setup,
+                                 bench_fn run,
+                                 bench_fn teardown,
+                                 void* ctx) {
+    size_t reps = BENCH_MAX_REPS;
+    if (n >= 10000000) {
+        reps = 5;
+    } else if (n >= 1000000) {
+        reps = 11;
+    }
+
+    size_t batch = n < BENCH_MIN_BATCH_WORK ? BENCH_MIN_BATCH_WORK / n : 1;
+    double samples[BENCH_MAX_REPS];
+
+    for (size_t rep = 0; rep < reps; rep++) {
+        double elapsed = 0.0;
+        for (size_t i = 0; i < batch; i++) {
+            if (setup) {
+                setup(ctx, n);
+            }
+            double start = bench_now_ns();
+            run(ctx, n);
+            elapsed += bench_now_ns() - start;
+            if (teardown) {
+                teardown(ctx, n);
+            }
+        }
+        samples[rep] = elapsed / (double)(batch * n);
+    }
+
+    qsort(samples, reps, sizeof(double), bench_compare_doubles);
+    size_t p99 = ((reps * 99) + 99) / 100 - 1;
+
+    printf("%-16s %-10s %10zu %4zu %10.2f %10.2f %10.2f\n", container, op, n,
+           reps, samples[0], samples[reps / 2], samples[p99]);
+    (void)fflush(stdout);
+}
+
+#endif
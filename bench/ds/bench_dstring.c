@@ -0,0 +1,58 @@
+/**
+ * Measures appending to a dstring, starting from an empty string, for final
+ * lengths on both sides of the small string buffer. Costs are per appended
+ * byte; append1 appends one byte per call, append8 eight bytes per call.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/ds/dstring.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+static const size_t LENGTHS[] = {8, 15, 16, 32, 256, 4096, 65536, 1048576};
+static const size_t LENGTH_COUNT = sizeof(LENGTHS) / sizeof(LENGTHS[0]);
+
+static const char CHUNK[] = "abcdefgh";
+
+static void init(void* ctx, size_t n) {
+    (void)n;
+    (void)dstring_init(ctx);
+}
+
+static void destroy(void* ctx, size_t n) {
+    (void)n;
+    struct dstring* str = ctx;
+    bench_sink += dstring_get_len(str);
+    dstring_destroy(str);
+}
+
+static void run_append1(void* ctx, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        (void)dstring_append(ctx, &CHUNK[i % 8], 1);
+    }
+}
+
+static void run_append8(void* ctx, size_t n) {
+    for (size_t i = 0; i < n; i += 8) {
+        (void)dstring_append(ctx, CHUNK, n - i < 8 ? n - i : 8);
+    }
+}
+
+int main(void) {
+    bench_print_header();
+
+    struct dstring str;
+    for (size_t i = 0; bench_size_in(LENGTHS, LENGTH_COUNT, i) != 0; i++) {
+        size_t n = bench_size_in(LENGTHS, LENGTH_COUNT, i);
+
+        bench_measure("dstring", "append1", n, init, run_append1, destroy,
+                      &str);
+        bench_measure("dstring", "append8", n, init, run_append8, destroy,
+                      &str);
+    }
+
+    return EXIT_SUCCESS;
+}
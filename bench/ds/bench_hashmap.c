@@ -0,0 +1,323 @@
+/**
+ * Measures insert, lookup hit, lookup miss, remove and iterate on the hashmap,
+ * next to the linear-probing table it replaced. Keys follow the pattern the
+ * world grid produces: packed (x, y) coordinates filling a square around the
+ * origin row by row. Misses use the same rows shifted one square to the east.
+ *
+ * Both tables are called through the same function table, so neither gets
+ * inlined into the benchmark loops.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/ds/hashmap.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+/*
+ * The previous implementation, kept here verbatim (apart from names) as the
+ * baseline: linear probing with a modulo per step and tombstone values.
+ */
+
+static int legacy_tombstone_marker;
+#define LEGACY_TOMBSTONE ((void*)&legacy_tombstone_marker)
+
+struct legacy_map {
+    struct hashmap_entry* entries;
+    size_t len;
+    size_t capacity;
+};
+
+static uint64_t legacy_hash(uint64_t key) {
+    key ^= key >> 33LU;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33LU;
+    key *= 0xc4ceb9fe1a85ec53;
+    key ^= key >> 33LU;
+    return key;
+}
+
+static struct hashmap_entry* legacy_find(struct hashmap_entry* entries,
+                                         size_t capacity,
+                                         uint64_t key) {
+    uint64_t index = legacy_hash(key) % capacity;
+    struct hashmap_entry* tombstone = nullptr;
+
+    for (;;) {
+        struct hashmap_entry* entry = &entries[index];
+
+        if (entry->value == nullptr) {
+            return tombstone != nullptr ? tombstone : entry;
+        }
+
+        if (entry->value == LEGACY_TOMBSTONE) {
+            if (tombstone == nullptr) {
+                tombstone = entry;
+            }
+        } else if (entry->key == key) {
+            return entry;
+        }
+
+        index = (index + 1) % capacity;
+    }
+}
+
+static int legacy_init(void* ctx) {
+    struct legacy_map* map = ctx;
+    map->entries = calloc(16, sizeof(struct hashmap_entry));
+    map->len = 0;
+    map->capacity = 16;
+    return map->entries ? 0 : -1;
+}
+
+static void legacy_destroy(void* ctx) {
+    struct legacy_map* map = ctx;
+    free(map->entries);
+}
+
+static int legacy_set(void* ctx, uint64_t key, void* value) {
+    struct legacy_map* map = ctx;
+    if ((map->len + 1) * 4 > map->capacity * 3) {
+        size_t new_capacity = map->capacity * 2;
+        struct hashmap_entry* new_entries =
+            calloc(new_capacity, sizeof(struct hashmap_entry));
+        if (!new_entries) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < map->capacity; ++i) {
+            struct hashmap_entry* entry = &map->entries[i];
+            if (entry->value != nullptr && entry->value != LEGACY_TOMBSTONE) {
+                *legacy_find(new_entries, new_capacity, entry->key) = *entry;
+            }
+        }
+
+        free(map->entries);
+        map->entries = new_entries;
+        map->capacity = new_capacity;
+    }
+
+    struct hashmap_entry* entry =
+        legacy_find(map->entries, map->capacity, key);
+    if (entry->value == nullptr || entry->value == LEGACY_TOMBSTONE) {
+        map->len++;
+        entry->key = key;
+    }
+
+    entry->value = value;
+    return 0;
+}
+
+static void* legacy_get(void* ctx, uint64_t key) {
+    struct legacy_map* map = ctx;
+    struct hashmap_entry* entry =
+        legacy_find(map->entries, map->capacity, key);
+    if (entry->value == nullptr || entry->value == LEGACY_TOMBSTONE) {
+        return nullptr;
+    }
+
+    return entry->value;
+}
+
+static void* legacy_remove(void* ctx, uint64_t key) {
+    struct legacy_map* map = ctx;
+    struct hashmap_entry* entry =
+        legacy_find(map->entries, map->capacity, key);
+    if (entry->value == nullptr || entry->value == LEGACY_TOMBSTONE) {
+        return nullptr;
+    }
+
+    void* old_value = entry->value;
+    entry->value = LEGACY_TOMBSTONE;
+    map->len--;
+    return old_value;
+}
+
+static size_t legacy_iter_sum(void* ctx) {
+    const struct legacy_map* map = ctx;
+    size_t sum = 0;
+    for (size_t i = 0; i < map->capacity; ++i) {
+        const struct hashmap_entry* entry = &map->entries[i];
+        if (entry->value != nullptr && entry->value != LEGACY_TOMBSTONE) {
+            sum += (size_t)entry->key;
+        }
+    }
+    return sum;
+}
+
+static int swiss_init(void* ctx) {
+    return hashmap_init(ctx);
+}
+
+static void swiss_destroy(void* ctx) {
+    hashmap_destroy(ctx);
+}
+
+static int swiss_set(void* ctx, uint64_t key, void* value) {
+    return hashmap_set(ctx, key, value, nullptr);
+}
+
+static void* swiss_get(void* ctx, uint64_t key) {
+    return hashmap_get(ctx, key);
+}
+
+static void* swiss_remove(void* ctx, uint64_t key) {
+    return hashmap_remove(ctx, key);
+}
+
+static size_t swiss_iter_sum(void* ctx) {
+    size_t sum = 0;
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(ctx, &iter, &key, &value)) {
+        sum += (size_t)key;
+    }
+    return sum;
+}
+
+struct map_ops {
+    const char* name;
+    int (*init)(void* map);
+    void (*destroy)(void* map);
+    int (*set)(void* map, uint64_t key, void* value);
+    void* (*get)(void* map, uint64_t key);
+    void* (*remove)(void* map, uint64_t key);
+    size_t (*iter_sum)(void* map);
+};
+
+static const struct map_ops IMPLEMENTATIONS[] = {
+    {"hashmap", swiss_init, swiss_destroy, swiss_set, swiss_get, swiss_remove,
+     swiss_iter_sum},
+    {"hashmap_linear", legacy_init, legacy_destroy, legacy_set, legacy_get,
+     legacy_remove, legacy_iter_sum},
+};
+
+struct map_bench {
+    const struct map_ops* ops;
+    union {
+        struct hashmap swiss;
+        struct legacy_map legacy;
+    } map;
+    uint64_t* keys;
+    uint64_t* missing_keys;
+};
+
+static int dummy_value;
+
+static void init_empty(void* ctx, size_t n) {
+    (void)n;
+    struct map_bench* bench = ctx;
+    (void)bench->ops->init(&bench->map);
+}
+
+static void init_filled(void* ctx, size_t n) {
+    struct map_bench* bench = ctx;
+    (void)bench->ops->init(&bench->map);
+    for (size_t i = 0; i < n; i++) {
+        (void)bench->ops->set(&bench->map, bench->keys[i], &dummy_value);
+    }
+}
+
+static void destroy(void* ctx, size_t n) {
+    (void)n;
+    struct map_bench* bench = ctx;
+    bench->ops->destroy(&bench->map);
+}
+
+static void run_insert(void* ctx, size_t n) {
+    struct map_bench* bench = ctx;
+    for (size_t i = 0; i < n; i++) {
+        (void)bench->ops->set(&bench->map, bench->keys[i], &dummy_value);
+    }
+}
+
+static void run_hit(void* ctx, size_t n) {
+    struct map_bench* bench = ctx;
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (size_t)(bench->ops->get(&bench->map, bench->keys[i]) !=
+                        nullptr);
+    }
+    bench_sink += sum;
+}
+
+static void run_miss(void* ctx, size_t n) {
+    struct map_bench* bench = ctx;
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (size_t)(bench->ops->get(&bench->map,
+                                        bench->missing_keys[i]) != nullptr);
+    }
+    bench_sink += sum;
+}
+
+static void run_remove(void* ctx, size_t n) {
+    struct map_bench* bench = ctx;
+    for (size_t i = 0; i < n; i++) {
+        (void)bench->ops->remove(&bench->map, bench->keys[i]);
+    }
+}
+
+static void run_iterate(void* ctx, size_t n) {
+    (void)n;
+    struct map_bench* bench = ctx;
+    bench_sink += bench->ops->iter_sum(&bench->map);
+}
+
+static uint64_t grid_key(int32_t x, int32_t y) {
+    return ((uint64_t)(uint32_t)x << 32U) | (uint32_t)y;
+}
+
+int main(void) {
+    bench_print_header();
+
+    for (size_t i = 0; bench_size(i) != 0; i++) {
+        size_t n = bench_size(i);
+        int32_t side = (int32_t)ceil(sqrt((double)n));
+
+        struct map_bench bench = {0};
+        bench.keys = malloc(n * sizeof(uint64_t));
+        bench.missing_keys = malloc(n * sizeof(uint64_t));
+        if (!bench.keys || !bench.missing_keys) {
+            free(bench.keys);
+            free(bench.missing_keys);
+            return EXIT_FAILURE;
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            int32_t x = (int32_t)(k % (size_t)side) - (side / 2);
+            int32_t y = (int32_t)(k / (size_t)side) - (side / 2);
+            bench.keys[k] = grid_key(x, y);
+            bench.missing_keys[k] = grid_key(x + side, y);
+        }
+
+        for (size_t impl = 0;
+             impl < sizeof(IMPLEMENTATIONS) / sizeof(IMPLEMENTATIONS[0]);
+             impl++) {
+            bench.ops = &IMPLEMENTATIONS[impl];
+            const char* name = bench.ops->name;
+
+            bench_measure(name, "insert", n, init_empty, run_insert, destroy,
+                          &bench);
+            bench_measure(name, "remove", n, init_filled, run_remove,
+                          destroy, &bench);
+
+            init_filled(&bench, n);
+            bench_measure(name, "hit", n, nullptr, run_hit, nullptr, &bench);
+            bench_measure(name, "miss", n, nullptr, run_miss, nullptr,
+                          &bench);
+            bench_measure(name, "iterate", n, nullptr, run_iterate, nullptr,
+                          &bench);
+            destroy(&bench, n);
+        }
+
+        free(bench.keys);
+        free(bench.missing_keys);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/**
+ * Measures push, pop, get and set on the vector. Push starts from an empty
+ * vector, so it includes the cost of growing; get and set run on a vector
+ * that is already filled.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/ds/vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+struct vector_bench {
+    struct vector vec;
+};
+
+static int dummy_value;
+
+static void init_empty(void* ctx, size_t n) {
+    (void)n;
+    struct vector_bench* bench = ctx;
+    (void)vector_init(&bench->vec);
+}
+
+static void init_filled(void* ctx, size_t n) {
+    struct vector_bench* bench = ctx;
+    (void)vector_init_with_capacity(&bench->vec, n);
+    for (size_t i = 0; i < n; i++) {
+        (void)vector_push(&bench->vec, &dummy_value);
+    }
+}
+
+static void destroy(void* ctx, size_t n) {
+    (void)n;
+    struct vector_bench* bench = ctx;
+    vector_destroy(&bench->vec);
+}
+
+static void run_push(void* ctx, size_t n) {
+    struct vector_bench* bench = ctx;
+    for (size_t i = 0; i < n; i++) {
+        (void)vector_push(&bench->vec, &dummy_value);
+    }
+}
+
+static void run_pop(void* ctx, size_t n) {
+    struct vector_bench* bench = ctx;
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (size_t)(vector_pop(&bench->vec) != nullptr);
+    }
+    bench_sink += sum;
+}
+
+static void run_get(void* ctx, size_t n) {
+    struct vector_bench* bench = ctx;
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (size_t)(vector_get(&bench->vec, i) != nullptr);
+    }
+    bench_sink += sum;
+}
+
+static void run_set(void* ctx, size_t n) {
+    struct vector_bench* bench = ctx;
+    for (size_t i = 0; i < n; i++) {
+        (void)vector_set(&bench->vec, i, &dummy_value);
+    }
+}
+
+int main(void) {
+    bench_print_header();
+
+    struct vector_bench bench;
+    for (size_t i = 0; bench_size(i) != 0; i++) {
+        size_t n = bench_size(i);
+
+        bench_measure("vector", "push", n, init_empty, run_push, destroy,
+                      &bench);
+        bench_measure("vector", "pop", n, init_filled, run_pop, destroy,
+                      &bench);
+
+        init_filled(&bench, n);
+        bench_measure("vector", "get", n, nullptr, run_get, nullptr, &bench);
+        bench_measure("vector", "set", n, nullptr, run_set, nullptr, &bench);
+        destroy(&bench, n);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,312 @@
+/**
+ * Headless world-generation benchmark. It builds a synthetic room catalog like
+ * tests/world/test_generator.c does, drives the generator along scripted paths
+ * and reports throughput, grid lookup cost, peak RSS and allocation counts.
+ *
+ * Allocation counts cover the game's own code only. They are collected by
+ * wrapping malloc, calloc and realloc at link time, which the Makefile enables
+ * on Linux; elsewhere they are reported as n/a.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "raylib.h"
+
+#include "game/rng.h"
+#include "game/world/generator.h"
+#include "game/world/grid.h"
+#include "game/world/room_def.h"
+
+#include "bench.h"
+
+#define CATALOG_DIR "bench_generator_assets"
+
+enum { SPIRAL_SIDE = 64, DOOR_WALK_STEPS = 8192, LOOKUP_RADIUS = 48 };
+
+// Dead ends and corners are left out so the world keeps growing for the whole
+// path instead of closing itself off after a few dozen rooms.
+static const char* const CATALOG[] = {
+    "starting_room",
+    "hallway_0",
+    "hallway_90",
+    "cross_room_0",
+};
+
+static const size_t CATALOG_SIZE = sizeof(CATALOG) / sizeof(CATALOG[0]);
+
+static size_t alloc_count = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+#endif
+
+struct path_result {
+    size_t steps;
+    size_t rooms;
+    double seconds;
+    size_t allocs;
+};
+
+static double now_seconds(void) {
+    return bench_now_ns() * 1e-9;
+}
+
+static size_t current_allocs(void) {
+    return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+static int write_catalog(void) {
+    (void)mkdir(CATALOG_DIR, 0755);
+
+    for (size_t i = 0; i < CATALOG_SIZE; i++) {
+        char path[256];
+        (void)snprintf(path, sizeof(path), "%s/%s.glb", CATALOG_DIR,
+                       CATALOG[i]);
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            return -1;
+        }
+        (void)fclose(file);
+    }
+
+    return 0;
+}
+
+static void remove_catalog(void) {
+    for (size_t i = 0; i < CATALOG_SIZE; i++) {
+        char path[256];
+        (void)snprintf(path, sizeof(path), "%s/%s.glb", CATALOG_DIR,
+                       CATALOG[i]);
+        (void)remove(path);
+    }
+    (void)rmdir(CATALOG_DIR);
+}
+
+static int start_world(unsigned int seed, enum generator_rng_mode mode) {
+    if (grid_init() != 0 || room_def_load_all(CATALOG_DIR) <= 0) {
+        return -1;
+    }
+
+    generator_set_rng_mode(mode);
+    return generator_init(seed);
+}
+
+static void stop_world(void) {
+    grid_destroy();
+    room_def_unload_all();
+}
+
+static size_t count_rooms(void) {
+    size_t iter = 0;
+    size_t rooms = 0;
+    struct world_cell* cell = nullptr;
+    while (grid_iter(&iter, &cell)) {
+        rooms++;
+    }
+    return rooms;
+}
+
+/**
+ * Visits every cell of a square spiral around the origin, the way a player
+ * sweeping the map would.
+ */
+static void run_spiral(struct path_result* result) {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t dx = 1;
+    int32_t dy = 0;
+    int32_t leg = 1;
+
+    for (size_t step = 0; step < (size_t)SPIRAL_SIDE * SPIRAL_SIDE;) {
+        for (int turn = 0; turn < 2; turn++) {
+            for (int32_t i = 0;
+                 i < leg && step < (size_t)SPIRAL_SIDE * SPIRAL_SIDE; i++) {
+                (void)generator_create_chunk(x, y);
+                x += dx;
+                y += dy;
+                step++;
+            }
+            int32_t temp = dx;
+            dx = -dy;
+            dy = temp;
+        }
+        leg++;
+    }
+
+    result->steps = (size_t)SPIRAL_SIDE * SPIRAL_SIDE;
+}
+
+/**
+ * Walks through doors from room to room, picking a random open door at each
+ * step, the way a player exploring the level would.
+ */
+static void run_door_walk(struct path_result* result) {
+    static const struct {
+        uint8_t door;
+        int32_t dx;
+        int32_t dy;
+    } EXITS[] = {
+        {DOOR_NORTH, 0, 1},
+        {DOOR_SOUTH, 0, -1},
+        {DOOR_EAST, 1, 0},
+        {DOOR_WEST, -1, 0},
+    };
+
+    struct rng rng;
+    rng_init_r(&rng, 7);
+
+    int32_t x = 0;
+    int32_t y = 0;
+
+    for (size_t step = 0; step < DOOR_WALK_STEPS; step++) {
+        (void)generator_create_chunk(x, y);
+
+        const struct world_cell* cell = grid_get_cell(x, y);
+        int first = rng_get_range_r(&rng, 0, 3);
+        for (int i = 0; i < 4; i++) {
+            int exit = (first + i) % 4;
+            if ((cell->template->door_mask & EXITS[exit].door) &&
+                grid_get_cell(x + EXITS[exit].dx, y + EXITS[exit].dy)) {
+                x += EXITS[exit].dx;
+                y += EXITS[exit].dy;
+                break;
+            }
+        }
+    }
+
+    result->steps = DOOR_WALK_STEPS;
+}
+
+static int bench_path(const char* name,
+                      enum generator_rng_mode mode,
+                      void (*run)(struct path_result* result)) {
+    struct path_result result = {0};
+
+    size_t allocs = current_allocs();
+    double start = now_seconds();
+    if (start_world(2024, mode) != 0) {
+        stop_world();
+        return -1;
+    }
+    run(&result);
+    result.seconds = now_seconds() - start;
+    result.allocs = current_allocs() - allocs;
+    result.rooms = count_rooms();
+
+    printf("%-12s %8zu %8zu %10.2f %12.0f %10.0f", name, result.steps,
+           result.rooms, result.seconds * 1e3,
+           (double)result.rooms / result.seconds,
+           result.seconds * 1e9 / (double)result.steps);
+#ifdef BENCH_COUNT_ALLOCS
+    printf(" %10zu %8.2f\n", result.allocs,
+           (double)result.allocs / (double)result.rooms);
+#else
+    printf(" %10s %8s\n", "n/a", "n/a");
+#endif
+
+    stop_world();
+    generator_set_rng_mode(GENERATOR_RNG_SEQUENTIAL);
+    return 0;
+}
+
+static int bench_lookups(void) {
+    if (start_world(2024, GENERATOR_RNG_SEQUENTIAL) != 0) {
+        stop_world();
+        return -1;
+    }
+
+    struct path_result result = {0};
+    run_spiral(&result);
+
+    enum { ROUNDS = 16 };
+    size_t hits = 0;
+    size_t lookups = 0;
+    size_t allocs = current_allocs();
+    double start = now_seconds();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int32_t y = -LOOKUP_RADIUS; y <= LOOKUP_RADIUS; y++) {
+            for (int32_t x = -LOOKUP_RADIUS; x <= LOOKUP_RADIUS; x++) {
+                hits += (size_t)(grid_get_cell(x, y) != nullptr);
+                lookups++;
+            }
+        }
+    }
+    double seconds = now_seconds() - start;
+    allocs = current_allocs() - allocs;
+
+    printf("\ngrid_get_cell: %.2f ns/lookup over %zu lookups (%.0f%% hits, "
+           "%zu allocs)\n",
+           seconds * 1e9 / (double)lookups, lookups,
+           100.0 * (double)hits / (double)lookups, allocs);
+
+    stop_world();
+    return 0;
+}
+
+static long peak_rss_kib(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+int main(void) {
+    SetTraceLogLevel(LOG_WARNING);
+
+    if (write_catalog() != 0) {
+        fprintf(stderr, "Failed to create the synthetic room catalog.\n");
+        remove_catalog();
+        return EXIT_FAILURE;
+    }
+
+    printf("%-12s %8s %8s %10s %12s %10s %10s %8s\n", "path", "steps",
+           "rooms", "ms", "rooms/s", "ns/step", "allocs", "per room");
+
+    int ret = bench_path("spiral", GENERATOR_RNG_SEQUENTIAL, run_spiral);
+    if (ret == 0) {
+        ret = bench_path("spiral-coord", GENERATOR_RNG_COORDINATE, run_spiral);
+    }
+    if (ret == 0) {
+        ret = bench_path("door-walk", GENERATOR_RNG_SEQUENTIAL, run_door_walk);
+    }
+    if (ret == 0) {
+        ret = bench_lookups();
+    }
+
+    printf("peak RSS: %ld KiB\n", peak_rss_kib());
+
+    remove_catalog();
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,18 +2,59 @@
 
 #include "raylib.h"
 
+#include "game/anim_cache.h"
 #include "game/camera.h"
 #include "game/player.h"
+#include "game/profiler.h"
+#include "game/sprite_batch.h"
 #include "game/world/world.h"
 
 int main(void) {
     const int screen_width = 1280;
     const int screen_height = 720;
+    // Texture memory for animations. The player's idle, run and attack clips
+    // are pinned and take about 40 MB; the rest is shared by clips that load
+    // on demand.
+    const size_t anim_budget_bytes = (size_t)64 * 1024 * 1024;
+    const char* save_path = "save.world";
+    const char* rooms_path = "assets/models/rooms";
 
     InitWindow(screen_width, screen_height, "Varázspuli");
 
-    if (world_init(42, "assets/models/rooms") != 0) {
+    // Atlases check for the palette shader when they are uploaded, so the
+    // sprite batch comes before any animation is loaded.
+    if (sprite_batch_init() != 0) {
+        TraceLog(LOG_ERROR, "Failed to initialize sprite batch. Exiting.");
+        CloseWindow();
+        return -1;
+    }
+
+    if (anim_cache_init(anim_budget_bytes) != 0) {
+        TraceLog(LOG_ERROR, "Failed to initialize animation cache. Exiting.");
+        sprite_batch_destroy();
+        CloseWindow();
+        return -1;
+    }
+
+    // The world from the last session is picked up where it was left. A save
+    // that cannot be loaded must not keep the game from starting, so a new
+    // world is generated instead.
+    int world_ret = -1;
+    if (FileExists(save_path)) {
+        world_ret = world_load(save_path, rooms_path);
+        if (world_ret != 0) {
+            TraceLog(LOG_WARNING,
+                     "Failed to load %s (error %d), starting a new world.",
+                     save_path, world_ret);
+        }
+    }
+    if (world_ret != 0) {
+        world_ret = world_init(42, rooms_path);
+    }
+    if (world_ret != 0) {
         TraceLog(LOG_ERROR, "Failed to initialize game world. Exiting.");
+        anim_cache_destroy();
+        sprite_batch_destroy();
         CloseWindow();
         return -1;
     }
@@ -29,8 +70,13 @@ int main(void) {
     SetTargetFPS(60);
 
     while (!WindowShouldClose()) {
+        PROFILE_BEGIN("update_player");
         update_player(&player, &camera);
+        PROFILE_END("update_player");
+
+        PROFILE_BEGIN("world_update");
         world_update(player.position);
+        PROFILE_END("world_update");
 
         Vector3 current_room_center = world_get_room_center(player.position);
 
@@ -41,17 +87,32 @@ int main(void) {
 
         BeginMode3D(camera.camera_m);
 
+        PROFILE_BEGIN("world_draw");
         world_draw();
-        draw_player(&player, camera.camera_m);
+        PROFILE_END("world_draw");
+
+        PROFILE_BEGIN("draw_sprites");
+        sprite_batch_begin(camera.camera_m);
+        draw_player(&player);
+        sprite_batch_end();
+        PROFILE_END("draw_sprites");
         DrawGrid(100, 10.0F);
 
         EndMode3D();
 
         DrawFPS(10, 10);
+        PROFILE_DRAW(10, 40);
 
         EndDrawing();
+        PROFILE_FRAME();
     }
 
+    unload_player(&player);
+    anim_cache_destroy();
+    sprite_batch_destroy();
+    if (world_save(save_path) != 0) {
+        TraceLog(LOG_WARNING, "Failed to save the world.");
+    }
     world_destroy();
 
     CloseWindow();
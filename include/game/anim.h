@@ -1,62 +1,93 @@
-#ifndef ANIM_H
-#define ANIM_H
-
-#include <raylib.h>
-
-/**
- * @file anim.h
- * @brief Provides structures and functions to handle GIF-like animations using
- * Raylib.
- */
-
-/**
- * @struct anim
- * @brief Represents an animation with multiple frames.
- *
- * This structure holds the data required to manage
- * frame-based animations, including the image, texture,
- * current frame index, and timing information.
- */
-struct anim {
-    int frame_count;    /**< Total number of frames in the animation */
-    Image gif_anim;     /**< Loaded image containing all animation frames */
-    Texture2D tex_anim; /**< Texture used for rendering the current frame */
-    unsigned int
-        next_frame_offset; /**< Offset to the next frame in the image data */
-    int current_frame;     /**< Index of the current frame */
-    int frame_delay; /**< Number of updates to wait before switching to the next
-                        frame */
-    int frame_counter; /**< Counter used to track the frame delay */
-};
-
-/**
- * @brief Initializes an animation from a file path.
- *
- * Loads the image from the specified path and prepares the texture and frame
- * data.
- *
- * @param animation Pointer to the animation struct to initialize.
- * @param path Path to the animation file (e.g., GIF or sprite sheet).
- * @param frame_delay Number of update cycles to wait before advancing a frame.
- */
-void init_anim(struct anim* animation, const char* path, int frame_delay);
-
-/**
- * @brief Updates the animation to the next frame if the delay has passed.
- *
- * This function should be called every frame to progress the animation.
- *
- * @param animation Pointer to the animation struct to update.
- */
-void update_anim(struct anim* animation);
-
-/**
- * @brief Unloads the animation resources.
- *
- * Frees the image and texture associated with the animation.
- *
- * @param animation Pointer to the animation struct to unload.
- */
-void unload_anim(struct anim* animation);
-
-#endif  // ANIM_H
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <raylib.h>
+
+#include "game/anim_cache.h"
+
+/**
+ * @file anim.h
+ * @brief Provides structures and functions to handle GIF-like animations using
+ * Raylib.
+ */
+
+/** Directory holding the source GIFs. */
+#define ANIM_SOURCE_DIR "assets/gifs/"
+
+/** Directory the anim_convert tool writes .anim files to. */
+#define ANIM_CONVERTED_DIR "assets/anims/"
+
+/**
+ * @struct anim
+ * @brief Represents an animation with multiple frames.
+ *
+ * This structure holds the data required to manage
+ * frame-based animations. The frames themselves belong to a clip in the
+ * animation cache, which loads them the first time the animation is updated
+ * or drawn; an animation only tracks its clip, the current frame index, and
+ * timing information. Animations of the same file share one clip, so every
+ * entity can have its own animations at the cost of this struct.
+ */
+struct anim {
+    struct anim_clip* clip; /**< Clip holding the animation frames */
+    int current_frame;      /**< Index of the current frame */
+    int frame_delay; /**< Number of updates to wait before switching to the next
+                        frame */
+    int frame_counter; /**< Counter used to track the frame delay */
+};
+
+/**
+ * @brief Initializes an animation from a file path.
+ *
+ * Takes a reference to the file's clip in the animation cache without
+ * loading it. Use anim_cache_preload() on the animation's clip to load it
+ * right away. The animation cache must be initialized.
+ *
+ * For a GIF under ANIM_SOURCE_DIR, the preprocessed .anim file at the same
+ * relative path under ANIM_CONVERTED_DIR is memory-mapped instead, if it
+ * exists (see `make anims`). Otherwise the GIF is decoded.
+ *
+ * @param animation Pointer to the animation struct to initialize.
+ * @param path Path to the animation file (e.g., GIF or sprite sheet).
+ * @param frame_delay Number of update cycles to wait before advancing a frame.
+ * @return 0 on success, or -ENOMEM if the clip cannot be acquired.
+ */
+int init_anim(struct anim* animation, const char* path, int frame_delay);
+
+/**
+ * @brief Releases the animation's reference to its clip.
+ *
+ * The clip's frames are freed once no animation uses them anymore.
+ *
+ * @param animation Pointer to the animation to unload.
+ */
+void unload_anim(struct anim* animation);
+
+/**
+ * @brief Updates the animation to the next frame if the delay has passed.
+ *
+ * This function should be called every frame to progress the animation. It
+ * only advances the frame index; no pixels are uploaded, but the clip is
+ * loaded if it is not resident.
+ *
+ * @param animation Pointer to the animation struct to update.
+ */
+void update_anim(struct anim* animation);
+
+/**
+ * @brief Queues the current frame as a camera-facing sprite.
+ *
+ * The frame is added to the sprite batch and drawn by sprite_batch_end(), so
+ * this must be called between sprite_batch_begin() and sprite_batch_end().
+ *
+ * @param animation Pointer to the animation to draw.
+ * @param position Center of the animation canvas in world space.
+ * @param size Height of the animation canvas in world units.
+ * @param tint Color to multiply the frame by.
+ */
+void draw_anim(const struct anim* animation,
+               Vector3 position,
+               float size,
+               Color tint);
+
+#endif  // ANIM_H
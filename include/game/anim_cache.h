@@ -0,0 +1,134 @@
+/**
+ * @file anim_cache.h
+ * @brief Loads animation clips on demand and keeps them under a memory cap.
+ *
+ * A clip is one animation file, such as the player's run cycle for a single
+ * direction. Clips are shared: every animation playing a file holds a
+ * reference to the same clip, so any number of entities can play it for the
+ * memory of one copy. Acquiring a clip only records its path; its frames are
+ * decoded and uploaded into a clip-sized atlas the first time the clip is
+ * used, and the clip is freed when its last reference is released. Clips
+ * that are needed without delay can be preloaded and pinned, so that their
+ * first use never stalls a frame.
+ *
+ * Preloading several clips at once decodes them on a pool of worker threads,
+ * one per processor core, while the calling thread uploads every clip whose
+ * frames are ready. Only the uploads touch the OpenGL context.
+ *
+ * The cache tracks the texture memory of every loaded clip. When it exceeds
+ * the budget, the least recently used clips that are not pinned are
+ * unloaded until it fits again; they are reloaded transparently on their
+ * next use.
+ */
+#ifndef GAME_ANIM_CACHE_H
+#define GAME_ANIM_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game/atlas.h"
+
+/**
+ * @struct anim_clip
+ * @brief An animation clip shared by every animation that plays it.
+ *
+ * Clips are owned by the cache and stay at the same address while they are
+ * referenced; only their frames come and go.
+ */
+struct anim_clip {
+    char* path;           /**< The .anim or GIF file to load from. */
+    struct atlas atlas;   /**< The frames, while the clip is loaded. */
+    int frame_count;      /**< Number of frames, known after the first load. */
+    size_t texture_bytes; /**< Video memory used while loaded. */
+    uint64_t last_used;   /**< Use counter value of the most recent use. */
+    int refcount;         /**< Number of holders of the clip. */
+    bool is_loaded;       /**< Whether the frames are resident. */
+    bool is_pinned;       /**< Whether the clip is exempt from eviction. */
+    bool is_missing;      /**< Whether loading failed; it is not retried. */
+};
+
+/**
+ * @brief Initializes the animation cache.
+ *
+ * Calling it again while the cache is initialized only changes the budget.
+ * @param budget_bytes The texture memory of all loaded clips above which the
+ * least recently used unpinned clips are evicted.
+ * @return 0 on success, or -ENOMEM if the clip list cannot be allocated.
+ */
+int anim_cache_init(size_t budget_bytes);
+
+/**
+ * @brief Unloads every clip and frees the cache.
+ *
+ * All clip pointers previously returned by this module become invalid, even
+ * those that were never released.
+ */
+void anim_cache_destroy(void);
+
+/**
+ * @brief Takes a reference to a clip without loading it.
+ *
+ * Acquiring a path that is already cached returns the same clip. Every call
+ * must be balanced by anim_cache_release().
+ * @param path Path to a .anim file or a GIF. GIFs are loaded from their
+ * preprocessed .anim file when one exists, as described for init_anim().
+ * @return The clip, or NULL if the cache is not initialized or out of
+ * memory.
+ */
+struct anim_clip* anim_cache_acquire(const char* path);
+
+/**
+ * @brief Releases a reference taken with anim_cache_acquire().
+ *
+ * When the last reference is released, the clip's frames are unloaded, even
+ * if it is pinned, and the clip is freed.
+ * @param clip The clip to release.
+ * @return 0 on success, -EINVAL if clip is NULL, or -ENOENT if it is not
+ * held by the cache.
+ */
+int anim_cache_release(struct anim_clip* clip);
+
+/**
+ * @brief Loads a clip now and pins it, so it is never evicted.
+ * @param clip The clip to preload.
+ * @return 0 on success, or a negative error code if it cannot be loaded.
+ */
+int anim_cache_preload(struct anim_clip* clip);
+
+/**
+ * @brief Loads several clips now, decoding them in parallel, and pins them.
+ *
+ * Must be called on the thread that owns the OpenGL context. The result is
+ * the same as calling anim_cache_preload() on every clip in turn: clips that
+ * are NULL or fail to load are skipped and the others are still pinned.
+ * @param clips The clips to preload. A clip may appear more than once.
+ * @param count The number of clips.
+ * @return 0 on success, -EINVAL if a clip is NULL, -ENOMEM if the work list
+ * cannot be allocated, or the error of a clip that cannot be loaded.
+ */
+int anim_cache_preload_all(struct anim_clip* const* clips, size_t count);
+
+/**
+ * @brief Gets the frames of a clip, loading them if needed.
+ *
+ * Marks the clip as the most recently used one. Loading a clip may evict
+ * others, but never the one being returned.
+ * @param clip The clip to use.
+ * @return The clip's atlas, or NULL if the clip cannot be loaded.
+ */
+const struct atlas* anim_cache_use(struct anim_clip* clip);
+
+/**
+ * @brief Gets the texture memory of all loaded clips.
+ * @return The total in bytes, pinned clips included.
+ */
+size_t anim_cache_get_resident_bytes(void);
+
+/**
+ * @brief Gets the number of loaded clips.
+ * @return The number of clips whose frames are resident.
+ */
+size_t anim_cache_get_loaded_count(void);
+
+#endif
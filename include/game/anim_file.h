@@ -0,0 +1,118 @@
+/**
+ * @file anim_file.h
+ * @brief Reads and writes preprocessed animation files.
+ *
+ * Decoding GIFs at startup is slow: every frame is LZW-compressed and has to
+ * be expanded to a full RGBA canvas before the atlas trims it again. The
+ * anim_convert tool does this work once at build time and stores the result
+ * in a .anim file that can be memory-mapped and copied straight into an
+ * atlas.
+ *
+ * A .anim file is laid out as follows, in the byte order of the machine that
+ * wrote it:
+ *
+ *     struct anim_file_header
+ *     struct anim_file_frame[frame_count]
+ *     RGBA pixel data of every frame
+ *
+ * Every frame is stored trimmed to the bounding box of its visible pixels,
+ * as raw rows of width * 4 bytes without padding.
+ */
+#ifndef GAME_ANIM_FILE_H
+#define GAME_ANIM_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#define ANIM_FILE_MAGIC "GANM"
+
+enum {
+    ANIM_FILE_VERSION = 1, /**< Bumped whenever the layout changes. */
+};
+
+/**
+ * @struct anim_file_header
+ * @brief The fixed-size header at the start of a .anim file.
+ */
+struct anim_file_header {
+    char magic[4];          /**< Always ANIM_FILE_MAGIC. */
+    uint32_t version;       /**< Always ANIM_FILE_VERSION. */
+    uint32_t canvas_width;  /**< Width of an untrimmed frame. */
+    uint32_t canvas_height; /**< Height of an untrimmed frame. */
+    uint32_t frame_count;   /**< Number of entries in the frame index. */
+    uint32_t reserved;      /**< Zero. */
+};
+
+/**
+ * @struct anim_file_frame
+ * @brief An entry of the frame index.
+ */
+struct anim_file_frame {
+    uint16_t x;           /**< Left edge of the trimmed frame on the canvas. */
+    uint16_t y;           /**< Top edge of the trimmed frame on the canvas. */
+    uint16_t width;       /**< Width of the trimmed frame; 0 if empty. */
+    uint16_t height;      /**< Height of the trimmed frame; 0 if empty. */
+    uint32_t delay_ms;    /**< How long the frame is shown, from the GIF. */
+    uint32_t reserved;    /**< Zero. */
+    uint64_t data_offset; /**< Offset of the pixels from the file start. */
+};
+
+/**
+ * @struct anim_file
+ * @brief An opened .anim file.
+ */
+struct anim_file {
+    const unsigned char* data;             /**< The whole file. */
+    size_t size;                           /**< File size in bytes. */
+    const struct anim_file_header* header; /**< Points into data. */
+    const struct anim_file_frame* frames;  /**< Points into data. */
+    bool is_mapped; /**< Whether data is a mapping rather than a copy. */
+};
+
+/**
+ * @brief Opens a .anim file and validates its header and frame index.
+ *
+ * The file is memory-mapped where the platform supports it and read into
+ * memory otherwise.
+ *
+ * @param file The file to open.
+ * @param path Path to the .anim file.
+ * @return 0 on success, -ENOENT if the file cannot be opened or mapped, or
+ * -EINVAL if it is not a valid .anim file of the current version.
+ */
+int anim_file_open(struct anim_file* file, const char* path);
+
+/**
+ * @brief Gets the trimmed pixels of a frame.
+ * @param file An opened file.
+ * @param frame The frame index.
+ * @return width * height RGBA pixels, or NULL if the frame is empty or out of
+ * range.
+ */
+const Color* anim_file_get_pixels(const struct anim_file* file, int frame);
+
+/**
+ * @brief Unmaps or frees an opened file.
+ * @param file The file to close.
+ */
+void anim_file_close(struct anim_file* file);
+
+/**
+ * @brief Trims a strip of frames and writes them as a .anim file.
+ * @param path Path of the file to write.
+ * @param image The frames, laid out as returned by LoadImageAnim().
+ * @param frame_count The number of frames in the image.
+ * @param delays_ms The delay of every frame in milliseconds, or NULL.
+ * @return 0 on success, -EINVAL if the image is not RGBA or too large for
+ * the format, -ENOMEM on allocation failure, or -EIO if the file cannot be
+ * written.
+ */
+int anim_file_write(const char* path,
+                    Image image,
+                    int frame_count,
+                    const int* delays_ms);
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @file atlas.h
+ * @brief Packs the frames of many animations into a few shared textures.
+ *
+ * Sprite animations are authored as full-canvas frames, most of which is
+ * transparent padding around the character. An atlas trims every frame to
+ * the bounding box of its visible pixels, remembers where that box sat on
+ * the canvas, and packs the trimmed frames into texture pages. Drawing a
+ * frame then only selects a source rectangle, so advancing an animation
+ * never uploads pixels, and every animation in the atlas shares the same
+ * texture binds.
+ *
+ * Frames are added with atlas_add_frames() and uploaded once with
+ * atlas_build(), which also frees the CPU copies of the pixels. Frames that
+ * do not fit on one page spill over to further pages; each page is cropped
+ * to the area it actually uses.
+ *
+ * Frames whose trimmed pixels are identical to an earlier frame's, such as
+ * held poses, are stored once: they are recognized by their size and a
+ * content hash when they are added, and share the earlier frame's place in
+ * the atlas while keeping their own canvas offset.
+ *
+ * Sprites converted from GIFs use at most 256 colors. When every frame of an
+ * atlas fits in ATLAS_PALETTE_SIZE colors, its pages are stored as one byte
+ * palette indices plus a small palette texture, and a fragment shader looks
+ * the colors up when drawing. This takes a quarter of the memory of RGBA
+ * pages and draws the same pixels. Atlases with more colors, or built while
+ * the sprite batch has no working palette shader, fall back to RGBA pages.
+ *
+ * The build is split into atlas_pack(), which only touches memory owned by
+ * the atlas and may run on any thread, and atlas_upload(), which creates the
+ * textures and must run on the thread that owns the OpenGL context.
+ */
+#ifndef GAME_ATLAS_H
+#define GAME_ATLAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game/sprite_batch.h"
+#include "raylib.h"
+
+enum {
+    ATLAS_DEFAULT_PAGE_SIZE = 4096, /**< Page edge length, in pixels. */
+    ATLAS_MAX_PAGES = 8,            /**< Pages a single atlas may use. */
+    ATLAS_PADDING = 1,        /**< Transparent gap between packed frames. */
+    ATLAS_PALETTE_SIZE = 256, /**< Colors an indexed atlas can hold. */
+};
+
+/**
+ * @struct atlas_frame
+ * @brief Where a trimmed frame lives in the atlas.
+ */
+struct atlas_frame {
+    int page;         /**< Index of the texture page, or -1 if empty. */
+    Rectangle source; /**< Trimmed frame within the page, in pixels. */
+    Vector2 offset;   /**< Top-left of the trimmed frame on the canvas. */
+};
+
+/**
+ * @struct atlas
+ * @brief A set of frames packed into texture pages.
+ *
+ * Every frame of an atlas is cut from a canvas of the same size, so trimmed
+ * frames can be drawn at the position their untrimmed canvas would have had.
+ */
+struct atlas {
+    int canvas_width;  /**< Width of an untrimmed frame. */
+    int canvas_height; /**< Height of an untrimmed frame. */
+    int page_size;     /**< Maximum page edge length, in pixels. */
+
+    Texture2D pages[ATLAS_MAX_PAGES]; /**< Uploaded texture pages. */
+    int page_count;                   /**< Number of uploaded pages. */
+    Texture2D palette; /**< Colors of indexed pages, ATLAS_PALETTE_SIZE x 1. */
+    bool is_indexed;   /**< Whether pages hold palette indices. */
+
+    struct atlas_frame* frames; /**< Placement of every frame. */
+    int frame_count;            /**< Number of frames added so far. */
+    int frame_capacity;         /**< Allocated length of the frame arrays. */
+
+    Color** pixels;   /**< Trimmed pixels of each frame until packed. */
+    uint64_t* hashes; /**< Hash of each frame's pixels, or 0 if not needed. */
+    int* originals;   /**< First frame with the same pixels, per frame. */
+
+    Image packed_pages[ATLAS_MAX_PAGES]; /**< Composed pages until upload. */
+    Image packed_palette; /**< Palette of indexed pages until upload. */
+    bool is_packed; /**< Whether atlas_pack() has run. */
+    bool is_built;  /**< Whether the pages have been uploaded. */
+};
+
+/**
+ * @brief Initializes an empty atlas.
+ * @param atlas The atlas to initialize.
+ * @param page_size The maximum edge length of a texture page, in pixels, or
+ * 0 for ATLAS_DEFAULT_PAGE_SIZE.
+ * @return 0 on success, or -EINVAL if the page size is negative.
+ */
+int atlas_init(struct atlas* atlas, int page_size);
+
+/**
+ * @brief Trims a strip of frames and adds them to the atlas.
+ *
+ * The image holds frame_count frames of image.width by image.height RGBA
+ * pixels stored one after another, as returned by LoadImageAnim(). The
+ * pixels are copied, so the image may be unloaded afterwards, except for
+ * frames identical to one already in the atlas. All frames of an atlas must
+ * share one canvas size.
+ *
+ * @param atlas The atlas to add the frames to.
+ * @param image The frames, in PIXELFORMAT_UNCOMPRESSED_R8G8B8A8.
+ * @param frame_count The number of frames in the image.
+ * @param[out] first_frame Receives the index of the first added frame; the
+ * others follow it consecutively. May be NULL.
+ * @return 0 on success, -EINVAL if the image is empty, not RGBA, or its size
+ * differs from earlier frames, -EBUSY if the atlas is already built, or
+ * -ENOMEM if the pixels cannot be copied.
+ */
+int atlas_add_frames(struct atlas* atlas,
+                     Image image,
+                     int frame_count,
+                     int* first_frame);
+
+/**
+ * @brief Adds a single frame that has already been trimmed.
+ *
+ * This is how preprocessed animation files skip the trimming pass. An empty
+ * bounds rectangle adds a frame that draws nothing.
+ *
+ * @param atlas The atlas to add the frame to.
+ * @param canvas_width The width of the untrimmed frame.
+ * @param canvas_height The height of the untrimmed frame.
+ * @param bounds The trimmed rectangle on the canvas, as returned by
+ * atlas_trim_bounds().
+ * @param pixels bounds.width by bounds.height RGBA pixels, stored row by row
+ * without padding. They are copied unless an identical frame is already in
+ * the atlas. May be NULL if bounds is empty.
+ * @param[out] frame Receives the index of the added frame. May be NULL.
+ * @return 0 on success, -EINVAL if bounds does not lie on the canvas or the
+ * canvas size differs from earlier frames, -EBUSY if the atlas is already
+ * packed, or -ENOMEM if the pixels cannot be copied.
+ */
+int atlas_add_trimmed(struct atlas* atlas,
+                      int canvas_width,
+                      int canvas_height,
+                      Rectangle bounds,
+                      const Color* pixels,
+                      int* frame);
+
+/**
+ * @brief Finds the bounding box of the visible pixels of a frame.
+ * @param pixels width by height RGBA pixels.
+ * @param width The width of the frame.
+ * @param height The height of the frame.
+ * @return The smallest rectangle holding every pixel with a nonzero alpha, or
+ * an empty rectangle if the frame is fully transparent.
+ */
+Rectangle atlas_trim_bounds(const Color* pixels, int width, int height);
+
+/**
+ * @brief Packs every added frame into texture pages without uploading them.
+ *
+ * Frames are placed on shelves, tallest first, and a new page is started
+ * when one is full. Shelves are about as wide as a square holding every
+ * frame, so an atlas much smaller than a page stays roughly square. The
+ * pages are composed in CPU memory, indexed if the colors fit in a palette,
+ * and the per-frame copies of the pixels are freed. No raylib graphics call
+ * is made, so atlases may be packed on worker threads.
+ *
+ * @param atlas The atlas to pack.
+ * @return 0 on success, -EBUSY if it is already packed, -ENOSPC if a frame is
+ * larger than a page or the frames need more than ATLAS_MAX_PAGES pages, or
+ * -ENOMEM if a page cannot be allocated.
+ */
+int atlas_pack(struct atlas* atlas);
+
+/**
+ * @brief Uploads the pages of a packed atlas and frees their CPU copies.
+ *
+ * Must be called on the thread that owns the OpenGL context. Indexed pages
+ * are expanded to RGBA first unless sprite_batch_has_palette_shader().
+ * @param atlas The packed atlas to upload.
+ * @return 0 on success, -EINVAL if it is not packed yet, -EBUSY if it is
+ * already uploaded, or -ENOMEM if indexed pages cannot be expanded.
+ */
+int atlas_upload(struct atlas* atlas);
+
+/**
+ * @brief Packs the atlas, unless it already is, and uploads it.
+ * @param atlas The atlas to build.
+ * @return 0 on success, or an error code of atlas_pack() or atlas_upload().
+ */
+int atlas_build(struct atlas* atlas);
+
+/**
+ * @brief Describes a frame as a sprite for the sprite batch.
+ *
+ * The sprite is sized and placed as if the whole untrimmed canvas were
+ * drawn with DrawBillboard(): the canvas is size units tall and centered on
+ * position. Only the trimmed part is actually rasterized.
+ *
+ * @param atlas A built atlas.
+ * @param frame The frame index.
+ * @param position The center of the canvas in world space.
+ * @param size The height of the canvas in world units.
+ * @param tint The color to multiply the frame by.
+ * @param[out] sprite Receives the sprite.
+ * @return true if the frame has visible pixels, or false if there is nothing
+ * to draw or the atlas is not built.
+ */
+bool atlas_get_sprite(const struct atlas* atlas,
+                      int frame,
+                      Vector3 position,
+                      float size,
+                      Color tint,
+                      struct sprite* sprite);
+
+/**
+ * @brief Gets the video memory used by the texture pages.
+ * @param atlas The atlas.
+ * @return The size of all uploaded pages and the palette in bytes, or 0
+ * before the build.
+ */
+size_t atlas_get_texture_bytes(const struct atlas* atlas);
+
+/**
+ * @brief Unloads the texture pages and frees the atlas.
+ * @param atlas The atlas to destroy.
+ */
+void atlas_destroy(struct atlas* atlas);
+
+#endif
@@ -3,12 +3,15 @@
  * @brief Public interface for a generic hash map data structure.
  *
  * This file defines the API for a hash map that maps 64-bit unsigned integer
- * keys to `void*` values. It uses open addressing with linear probing for
- * collision resolution.
+ * keys to `void*` values. It is an open-addressing table in the style of Swiss
+ * tables: every slot has a one-byte control tag holding 7 bits of the key's
+ * hash, and lookups compare a whole group of 16 tags at once (with SSE2 where
+ * available, and a portable loop otherwise) before touching any entries.
  */
 #ifndef GAME_DS_HASHMAP_H
 #define GAME_DS_HASHMAP_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -23,16 +26,20 @@ struct hashmap_entry {
 
 /**
  * @struct hashmap
- * @brief A hash map implementation using open addressing with linear probing.
+ * @brief A hash map implementation using open addressing with grouped
+ * control bytes.
  *
  * This hash map stores key-value pairs where the key is a 64-bit unsigned
  * integer and the value is a generic pointer. The map automatically handles
- * resizing when it becomes too full to maintain performance.
+ * resizing when it becomes too full to maintain performance. The capacity is
+ * always a power of two.
  */
 struct hashmap {
     struct hashmap_entry*
         entries;     /**< The dynamically allocated array of entries. */
+    uint8_t* ctrl;   /**< One control byte per slot, after the entries. */
     size_t len;      /**< The current number of elements in the map. */
+    size_t deleted;  /**< The number of slots holding a tombstone. */
     size_t capacity; /**< The total number of available slots in the map. */
 };
 
@@ -86,8 +93,8 @@ void* hashmap_get(const struct hashmap* map, uint64_t key);
 /**
  * @brief Removes a key-value pair from the hash map.
  *
- * The removal is handled using a tombstone mechanism to preserve the integrity
- * of the probing chains.
+ * The slot is marked with a tombstone when a probe sequence may pass over it,
+ * and is freed directly otherwise. Tombstones are cleared on the next resize.
  *
  * @param map A pointer to the hash map.
  * @param key The key of the entry to remove.
@@ -0,0 +1,61 @@
+/**
+ * @file frustum.h
+ * @brief Tests bounding boxes against the volume a camera can see.
+ *
+ * The six planes of the view frustum are extracted from a combined view and
+ * projection matrix, so the test works for any camera raylib can set up,
+ * including orthographic ones. Inside BeginMode3D(), the matrix is
+ * MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()).
+ *
+ * The box test is conservative: a box that lies outside the frustum but
+ * straddles the extension of two planes near a corner is reported as
+ * visible. It never reports a visible box as hidden.
+ */
+#ifndef GAME_FRUSTUM_H
+#define GAME_FRUSTUM_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+/** Index of each plane in frustum.planes. */
+enum frustum_plane {
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT,
+};
+
+/**
+ * @struct frustum
+ * @brief The planes bounding a view volume.
+ *
+ * Each plane is stored as (a, b, c, d), with the normal (a, b, c) pointing
+ * into the volume, so a point p is on the inner side when
+ * a * p.x + b * p.y + c * p.z + d >= 0. The planes are not normalized.
+ */
+struct frustum {
+    Vector4 planes[FRUSTUM_PLANE_COUNT]; /**< Planes, see frustum_plane. */
+};
+
+/**
+ * @brief Extracts the frustum planes from a view-projection matrix.
+ * @param view_projection The view matrix multiplied by the projection
+ * matrix, in raylib's MatrixMultiply() order.
+ * @return The frustum of the matrix.
+ */
+struct frustum frustum_from_matrix(Matrix view_projection);
+
+/**
+ * @brief Checks whether any part of a box may be inside the frustum.
+ * @param frustum The frustum.
+ * @param box An axis-aligned box in world space.
+ * @return false if the box lies fully outside one of the planes, true
+ * otherwise.
+ */
+bool frustum_intersects_box(const struct frustum* frustum, BoundingBox box);
+
+#endif
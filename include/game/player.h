@@ -78,7 +78,10 @@ struct player {
  * @brief Initializes a player with position, speed, and health.
  *
  * This function sets up the player's initial position, speed, health, state,
- * and loads the animations.
+ * and animations. Idle, run and attack animations are loaded right away; the
+ * others are loaded the first time they are needed. The animation cache must
+ * be initialized, and its clips are shared with any other entity that plays
+ * the same files.
  *
  * @param player Pointer to the player to initialize
  * @param position Initial world position of the player
@@ -101,17 +104,16 @@ void init_player(struct player* player,
 void update_player(struct player* player, const struct camera* camera);
 
 /**
- * @brief Draws the player in the 3D world using the provided camera.
+ * @brief Queues the player's current frame in the sprite batch.
  *
  * @param player Pointer to the player to draw
- * @param camera Camera3D object for rendering
  */
-void draw_player(struct player* player, Camera3D camera);
+void draw_player(struct player* player);
 
 /**
  * @brief Unloads the player's resources.
  *
- * Frees any textures or animations associated with the player.
+ * Releases the player's animations. Clips no other entity uses are freed.
  *
  * @param player Pointer to the player to unload
  */
@@ -0,0 +1,108 @@
+/**
+ * @file profiler.h
+ * @brief A lightweight frame profiler with named zones and an overlay.
+ *
+ * Code is instrumented with PROFILE_BEGIN()/PROFILE_END() pairs around the
+ * work to be measured, PROFILE_FRAME() once per frame, and PROFILE_DRAW() to
+ * show the results on screen. Zones are identified by name; every zone's time
+ * is accumulated per frame, and the last PROFILER_HISTORY frames are kept in a
+ * ring buffer for the overlay's averages and frame-time graph.
+ *
+ * The macros only do something when the game is built with GAME_PROFILE
+ * defined (`make PROFILE=1`); otherwise they expand to nothing and the
+ * instrumentation has no cost. The functions behind them are always built.
+ *
+ * The profiler is not thread-safe and must only be used from the main thread.
+ */
+#ifndef GAME_PROFILER_H
+#define GAME_PROFILER_H
+
+enum {
+    PROFILER_MAX_ZONES = 32,  /**< Distinct zone names that can be tracked. */
+    PROFILER_HISTORY = 120,   /**< Frames kept in the ring buffer. */
+};
+
+#ifdef GAME_PROFILE
+#define PROFILE_BEGIN(name) profiler_begin(name)
+#define PROFILE_END(name) profiler_end(name)
+#define PROFILE_FRAME() profiler_end_frame()
+#define PROFILE_DRAW(x, y) profiler_draw(x, y)
+#else
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_DRAW(x, y) ((void)0)
+#endif
+
+/**
+ * @brief Starts timing a zone.
+ *
+ * The zone is registered on first use. Zones may be nested, but a zone must
+ * be ended before it is begun again. Once PROFILER_MAX_ZONES names are
+ * registered, new names are ignored.
+ * @param name The zone name. It must stay valid for the program's lifetime,
+ * e.g. a string literal.
+ */
+void profiler_begin(const char* name);
+
+/**
+ * @brief Stops timing a zone and adds the elapsed time to the current frame.
+ * @param name The zone name passed to profiler_begin().
+ */
+void profiler_end(const char* name);
+
+/**
+ * @brief Closes the current frame and stores it in the ring buffer.
+ *
+ * Call this once per frame. The frame time is the time since the previous
+ * call.
+ */
+void profiler_end_frame(void);
+
+/**
+ * @brief Gets a zone's time in the last completed frame.
+ * @param name The zone name.
+ * @return The time in milliseconds, or 0 if the zone is unknown.
+ */
+double profiler_get_zone_ms(const char* name);
+
+/**
+ * @brief Gets the duration of the last completed frame.
+ * @return The frame time in milliseconds, or 0 before the second frame.
+ */
+double profiler_get_frame_ms(void);
+
+/**
+ * @brief Gets the average frame duration over the history.
+ *
+ * Frames without a duration, such as the first one, are left out.
+ * @return The average in milliseconds, or 0 before the second frame.
+ */
+double profiler_get_average_frame_ms(void);
+
+/**
+ * @brief Gets a zone's average time per frame over the history.
+ *
+ * Uses the same frames as profiler_get_average_frame_ms().
+ * @param name The zone name.
+ * @return The average in milliseconds, or 0 if the zone is unknown.
+ */
+double profiler_get_average_zone_ms(const char* name);
+
+/**
+ * @brief Draws the overlay: the average time of every zone over the history
+ * and a graph of recent frame times.
+ *
+ * Must be called between BeginDrawing() and EndDrawing(), outside of any 3D
+ * mode.
+ * @param x The left edge of the overlay, in pixels.
+ * @param y The top edge of the overlay, in pixels.
+ */
+void profiler_draw(int x, int y);
+
+/**
+ * @brief Forgets every zone and all recorded frames.
+ */
+void profiler_reset(void);
+
+#endif
@@ -8,6 +8,17 @@
  * rand(). This is intended for all procedural generation tasks (world layout,
  * item placement) to ensure worlds can be reproduced from a seed.
  *
+ * The global functions draw from a hidden state shared by the whole program.
+ * Subsystems and threads that need their own sequence keep a struct rng and
+ * use the *_r variants instead; rng_jump() and rng_long_jump() split one
+ * seeded context into non-overlapping streams.
+ *
+ * Besides the sequential generator, the module offers counter-based streams:
+ * a stream is identified by a 64-bit key (typically derived from a seed and a
+ * pair of grid coordinates with rng_hash_coords()), and its n-th value is a
+ * pure function of the key and n. Streams have no shared state, so they give
+ * the same numbers regardless of call order or thread.
+ *
  * For non-deterministic randomness (e.g., enemy AI, particle effects),
  * use Raylib's GetRandomValue() directly.
  */
@@ -16,6 +27,16 @@
 
 #include <stdint.h>
 
+/**
+ * @brief The state of an independent xoshiro256** generator.
+ *
+ * A context is not thread-safe by itself, but separate contexts can be used
+ * from separate threads without any locking.
+ */
+struct rng {
+    uint64_t s[4];
+};
+
 /**
  * @brief Initializes the global random number generator state with a seed.
  *
@@ -45,4 +66,85 @@ uint64_t rng_next_u64(void);
  */
 int rng_get_range(int min, int max);
 
+/**
+ * @brief Initializes a generator context with a seed.
+ *
+ * A context seeded with the same value as rng_init() produces the same
+ * sequence as the global generator.
+ * @param rng The context to initialize.
+ * @param seed The initial 64-bit seed for the random sequence.
+ */
+void rng_init_r(struct rng* rng, uint64_t seed);
+
+/**
+ * @brief Generates the next 64-bit unsigned integer from a context.
+ * @param rng The context to draw from.
+ * @return A pseudo-random 64-bit integer.
+ */
+uint64_t rng_next_u64_r(struct rng* rng);
+
+/**
+ * @brief Generates an unbiased integer within an inclusive range from a
+ * context.
+ * @param rng The context to draw from.
+ * @param min The minimum inclusive value of the range.
+ * @param max The maximum inclusive value of the range.
+ * @return A pseudo-random integer within the specified range.
+ */
+int rng_get_range_r(struct rng* rng, int min, int max);
+
+/**
+ * @brief Advances a context by 2^128 draws.
+ *
+ * Copying a context and jumping the original after each copy gives up to 2^128
+ * streams that never overlap, e.g. one per worker thread.
+ * @param rng The context to advance.
+ */
+void rng_jump(struct rng* rng);
+
+/**
+ * @brief Advances a context by 2^192 draws.
+ *
+ * Use this to hand out top-level streams (e.g. one per world instance), each
+ * of which can then be split further with rng_jump().
+ * @param rng The context to advance.
+ */
+void rng_long_jump(struct rng* rng);
+
+/**
+ * @brief Derives a stream key from a seed and a pair of grid coordinates.
+ *
+ * The result is a pure function of its inputs, and neighbouring coordinates
+ * map to unrelated keys.
+ * @param seed The world seed.
+ * @param x The grid x-coordinate.
+ * @param y The grid y-coordinate.
+ * @return A 64-bit key suitable for rng_stream_u64() and rng_stream_range().
+ */
+uint64_t rng_hash_coords(uint64_t seed, int32_t x, int32_t y);
+
+/**
+ * @brief Gets a value from a counter-based random stream.
+ *
+ * This does not touch the global generator state and is safe to call from
+ * any thread.
+ * @param key The key identifying the stream.
+ * @param counter The position in the stream.
+ * @return The pseudo-random 64-bit value at that position.
+ */
+uint64_t rng_stream_u64(uint64_t key, uint64_t counter);
+
+/**
+ * @brief Draws an unbiased integer in an inclusive range from a stream.
+ *
+ * Values are read from the stream starting at *counter, which is advanced
+ * past every value consumed (rejection sampling may consume more than one).
+ * @param key The key identifying the stream.
+ * @param[in,out] counter The current position in the stream.
+ * @param min The minimum inclusive value of the range.
+ * @param max The maximum inclusive value of the range.
+ * @return A pseudo-random integer within the specified range.
+ */
+int rng_stream_range(uint64_t key, uint64_t* counter, int min, int max);
+
 #endif
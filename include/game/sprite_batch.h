@@ -0,0 +1,115 @@
+/**
+ * @file sprite_batch.h
+ * @brief Collects camera-facing sprites and draws them in few draw calls.
+ *
+ * Drawing billboards one at a time binds a texture, and for palette-indexed
+ * atlas pages switches shaders, for every sprite. The sprite batch instead
+ * collects every sprite of a frame between sprite_batch_begin() and
+ * sprite_batch_end(), sorts them so that sprites sharing a texture and
+ * palette are adjacent, and emits them as quads into rlgl's vertex buffer,
+ * which raylib submits with one draw call per texture run.
+ *
+ * Sprites are drawn with shaders that discard fully transparent texels, so
+ * the empty parts of a sprite do not write depth and opaque sprites can be
+ * drawn in any order. Opaque sprites are sorted by palette and texture, then
+ * front to back to save overdraw. Sprites with a translucent tint still need
+ * blending in order and are drawn last, back to front.
+ *
+ * The batch must only be used from the thread that owns the OpenGL context.
+ */
+#ifndef GAME_SPRITE_BATCH_H
+#define GAME_SPRITE_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+/**
+ * @struct sprite
+ * @brief A textured quad that faces the camera.
+ *
+ * The fields mirror the arguments of DrawBillboardPro() without rotation,
+ * with the quad's up direction fixed to the world's Y axis.
+ */
+struct sprite {
+    Texture2D texture; /**< Texture, or palette-indexed page, to draw. */
+    Texture2D palette; /**< Palette of an indexed texture, or an id of 0. */
+    Rectangle source;  /**< Region of the texture to draw, in pixels. */
+    Vector3 position;  /**< Anchor point in world space. */
+    Vector2 size;      /**< Width and height of the quad in world units. */
+    Vector2 origin;    /**< Anchor relative to the bottom-left corner. */
+    Color tint;        /**< Color to multiply the texture by. */
+};
+
+/**
+ * @brief Loads the sprite shaders.
+ *
+ * Must be called after InitWindow(). If the palette shader cannot be
+ * compiled, palette-indexed atlases fall back to RGBA pages.
+ * @return 0 on success, -ENOMEM if the sprite list cannot be allocated, or
+ * -EIO if the sprite shader cannot be compiled.
+ */
+int sprite_batch_init(void);
+
+/**
+ * @brief Unloads the shaders and frees the batch.
+ */
+void sprite_batch_destroy(void);
+
+/**
+ * @brief Checks whether palette-indexed textures can be drawn.
+ * @return true if the batch is initialized and its palette shader works.
+ */
+bool sprite_batch_has_palette_shader(void);
+
+/**
+ * @brief Turns drawing palette-indexed textures on or off.
+ *
+ * Off behaves as if the palette shader were unavailable, for example to
+ * compare against RGBA pages: sprite_batch_has_palette_shader() returns
+ * false, atlases uploaded from then on use RGBA pages, and queued sprites
+ * that still have a palette are skipped. On by default.
+ * @param enabled Whether palette-indexed textures are drawn.
+ */
+void sprite_batch_set_palette_enabled(bool enabled);
+
+/**
+ * @brief Starts collecting the sprites of a frame.
+ *
+ * Call inside BeginMode3D() with the same camera.
+ * @param camera The camera the sprites face.
+ */
+void sprite_batch_begin(Camera3D camera);
+
+/**
+ * @brief Queues a sprite to be drawn by sprite_batch_end().
+ * @param sprite The sprite. It is copied.
+ * @return 0 on success, -EINVAL if sprite is NULL, -ECANCELED if the batch
+ * is not between sprite_batch_begin() and sprite_batch_end(), or -ENOMEM if
+ * the sprite list cannot grow.
+ */
+int sprite_batch_add(const struct sprite* sprite);
+
+/**
+ * @brief Sorts and draws every queued sprite, then empties the batch.
+ */
+void sprite_batch_end(void);
+
+/**
+ * @brief Gets the number of sprites drawn by the last sprite_batch_end().
+ * @return The sprite count.
+ */
+size_t sprite_batch_get_sprite_count(void);
+
+/**
+ * @brief Gets the number of texture or shader changes in the last batch.
+ *
+ * Every change starts a new draw call, so this is the number of draw calls
+ * the batch needed, not counting the ones rlgl adds when its vertex buffer
+ * fills up.
+ * @return The batch count.
+ */
+size_t sprite_batch_get_batch_count(void);
+
+#endif
@@ -5,21 +5,77 @@
  * This module is responsible for the logic of creating the room layout.
  * It uses the world grid as a canvas and the room templates as a palette
  * to build the world deterministically based on a seed.
+ *
+ * Chunks can be generated synchronously with generator_create_chunk(), or
+ * handed to a background worker thread with generator_request_chunk(). The
+ * worker runs the same algorithm against its own copy of the rooms it placed,
+ * falling back to the grid for the rest, and queues the resulting
+ * placements, which the main thread applies to the grid with
+ * generator_commit(). Requests are processed in order, so for a given
+ * seed and sequence of requests the worker produces exactly the same world as
+ * the synchronous path.
+ *
+ * By default every choice is drawn from the generator's sequential context, so
+ * the world depends on the order in which chunks are generated. In
+ * GENERATOR_RNG_COORDINATE mode the room chosen for a cell is drawn from a
+ * stream keyed by (seed, x, y) instead, which makes it a function of the seed,
+ * the coordinates and the doors of the already placed neighbours only. Which
+ * neighbours are placed still depends on the order chunks are generated in,
+ * so a cell reached from another direction can get another room. Rooms are
+ * never generated twice, though: paged-out regions are restored from their
+ * records, see grid_page_out(), so eviction does not change the world.
  */
 #ifndef GAME_WORLD_GENERATOR_H
 #define GAME_WORLD_GENERATOR_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "game/rng.h"
+
+/**
+ * @brief Selects where the generator's random choices come from.
+ */
+enum generator_rng_mode {
+    /** Draws from the generator's rng context; the default. */
+    GENERATOR_RNG_SEQUENTIAL,
+    /** Draws from a per-cell stream keyed by the seed and grid coordinates. */
+    GENERATOR_RNG_COORDINATE,
+};
+
+/**
+ * @struct generator_state
+ * @brief Everything that decides which rooms the generator places next.
+ */
+struct generator_state {
+    uint64_t seed;                /**< The seed of the coordinate streams. */
+    struct rng rng;               /**< The sequential context. */
+    enum generator_rng_mode mode; /**< Where choices are drawn from. */
+};
+
+/**
+ * @brief Sets the random mode used by the generator.
+ *
+ * Must be called before generator_init() and not changed afterwards, since
+ * the two modes produce different worlds for the same seed. In coordinate
+ * mode frontier cells are filled in row-major order instead of a shuffled
+ * order, so no draws are taken from the sequential context at all.
+ * @param mode The mode to use.
+ */
+void generator_set_rng_mode(enum generator_rng_mode mode);
+
 /**
  * @brief Initializes the generator and the world's starting state.
  *
  * This function must be called once at the start of the game. It performs
  * two critical actions:
- * 1. It seeds the deterministic random number generator (`rng` module).
+ * 1. It seeds the generator's own random context (`rng` module), which is
+ *    separate from the global one, so other users of the rng module cannot
+ *    change the generated world.
  * 2. It places the 'starting_room' at grid coordinate (0, 0) and generates
  *    the initial chunk of rooms around it, ensuring the player spawns into
- *    a populated area.
+ *    a populated area. This step is skipped if the grid already has a room
+ *    at (0, 0), as it does when a save is attached.
  *
  * @param seed The seed for the entire world generation process.
  */
@@ -32,12 +88,111 @@ int generator_init(unsigned int seed);
  * a 5x5 area around the center point, identifies empty cells adjacent to
  * existing rooms, and fills them with compatible rooms from the template list.
  * This is designed to be called by the game world as the player moves to
-
  * generate the world dynamically.
  *
+ * Must not be called while the background worker is running.
+ *
  * @param center_x The center grid x-coordinate of the chunk to generate.
  * @param center_y The center grid y-coordinate of the chunk to generate.
  */
 int generator_create_chunk(int32_t center_x, int32_t center_y);
 
+/**
+ * @brief Starts the background generation worker.
+ *
+ * The worker keeps its own copy of the rooms it places, so it rarely has to
+ * touch the grid. Every other room, whether resident, paged out or still
+ * only in an attached save, is read with grid_get_saved_template(), which
+ * locks. Call this after generator_init(). From now on, the main thread must
+ * only place rooms through generator_commit(); paging regions out with
+ * grid_page_out() is fine.
+ *
+ * @return 0 on success, -ENOMEM if the layout copy cannot be allocated, or
+ * -EAGAIN if the thread cannot be started.
+ */
+int generator_start_worker(void);
+
+/**
+ * @brief Stops the background worker and drops any unfinished work.
+ *
+ * Pending chunk requests and uncommitted placements are discarded. Call
+ * generator_flush() first to keep them.
+ */
+void generator_stop_worker(void);
+
+/**
+ * @brief Queues a chunk for generation on the background worker.
+ *
+ * The call returns immediately. The generated rooms appear on the grid after
+ * a later call to generator_commit(). If the worker is not running, the chunk
+ * is generated synchronously instead.
+ *
+ * @param center_x The center grid x-coordinate of the chunk to generate.
+ * @param center_y The center grid y-coordinate of the chunk to generate.
+ * @return 0 on success, or -ENOMEM on allocation failure.
+ */
+int generator_request_chunk(int32_t center_x, int32_t center_y);
+
+/**
+ * @brief Lets the worker forget the rooms it placed far from a point.
+ *
+ * Call this after grid_page_out(), so the worker's copy of the layout stays
+ * bounded like the grid. The worker drops its copies of committed rooms more
+ * than distance cells away on either axis, and reads them back from the
+ * grid's paged-out records if it needs them again. The request is queued
+ * behind the pending chunk requests and never changes what they generate.
+ * Without a running worker this does nothing.
+ *
+ * @param center_x The grid x-coordinate to measure from, usually the
+ * player's.
+ * @param center_y The grid y-coordinate to measure from.
+ * @param distance How far rooms may be and stay in the worker's copy.
+ * @return 0 on success, -EINVAL if distance is negative, or -ENOMEM on
+ * allocation failure.
+ */
+int generator_page_out(int32_t center_x, int32_t center_y, int32_t distance);
+
+/**
+ * @brief Applies the rooms finished by the worker to the grid.
+ *
+ * Must be called from the main thread, typically at the start of each frame.
+ * It never waits for the worker.
+ * @return The number of rooms placed on the grid.
+ */
+size_t generator_commit(void);
+
+/**
+ * @brief Waits until the worker has finished all queued chunks, then commits
+ * them.
+ * @return The number of rooms placed on the grid.
+ */
+size_t generator_flush(void);
+
+/**
+ * @brief Gets the number of rooms in the worker's copy of the layout.
+ *
+ * The worker changes its copy while it works, so only call this while it is
+ * idle, for example right after generator_flush().
+ * @return The number of rooms, or 0 if the worker is not running.
+ */
+size_t generator_get_shadow_count(void);
+
+/**
+ * @brief Gets the generator's current state, to be saved with the world.
+ *
+ * The worker draws from the same state, so it must be idle, for example
+ * right after generator_flush().
+ * @param[out] state Receives the state.
+ */
+void generator_get_state(struct generator_state* state);
+
+/**
+ * @brief Restores a state returned by generator_get_state().
+ *
+ * Call after generator_init() and before generator_start_worker(), so the
+ * generator continues exactly where the saved session left off.
+ * @param state The state to restore.
+ */
+void generator_set_state(const struct generator_state* state);
+
 #endif
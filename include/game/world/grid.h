@@ -5,8 +5,13 @@
  * This module acts as the logical map of the game world. It uses a hash map
  * to store which room exists at any given (x, y) coordinate, making it
  * efficient for sparse, procedurally generated environments. It is responsible
- * for the lifecycle of WorldCell data and the loading/unloading of their
- * associated 3D models.
+ * for the lifecycle of WorldCell data and for acquiring and releasing their
+ * associated 3D models through the shared model cache.
+ *
+ * To keep memory bounded in an endless world, regions far from the player can
+ * be paged out into compact records and are restored on demand. A saved world
+ * is attached the same way: its regions are read from the mapped file the
+ * first time they are touched.
  */
 #ifndef GAME_WORLD_GRID_H
 #define GAME_WORLD_GRID_H
@@ -15,6 +20,11 @@
 
 #include "game/world/room_def.h"
 
+/** Edge length, in cells, of the square regions the grid pages out. */
+enum { GRID_REGION_SIZE = 16 };
+
+struct world_file;
+
 /**
  * @struct world_cell
  * @brief Represents a single cell in the world grid containing a room.
@@ -22,26 +32,30 @@
 struct world_cell {
     const struct room_def* template; /**< Pointer to the room's blueprint.
                                       */
-    Model model;                     /**< The loaded Raylib 3D model. */
-    bool is_model_loaded; /**< True if the 3D model is currently in VRAM. */
-    int32_t grid_x;       /**< The cell's X coordinate on the grid. */
-    int32_t grid_y;       /**< The cell's Y coordinate on the grid. */
+    Model model;                     /**< Shared model cache handle. */
+    bool is_model_loaded;    /**< True if the 3D model is currently in VRAM. */
+    bool is_model_requested; /**< True while a model reference is held. */
+    int32_t grid_x;          /**< The cell's X coordinate on the grid. */
+    int32_t grid_y;          /**< The cell's Y coordinate on the grid. */
+    uint32_t visit_stamp;    /**< Last visibility pass that reached it. */
 };
 
 /**
  * @brief Initializes the world grid system.
  *
- * Must be called before any other functions in this module.
- * @return 0 on success, or -ENOMEM if the underlying hash map cannot be
- * initialized.
+ * Must be called before any other functions in this module. This also
+ * initializes the shared model cache.
+ * @return 0 on success, or -ENOMEM if the underlying hash map or the model
+ * cache cannot be initialized.
  */
 int grid_init(void);
 
 /**
  * @brief Frees all memory used by the world grid.
  *
- * This function iterates through all placed rooms, unloads any loaded models,
- * frees all WorldCell memory, and destroys the underlying hash map.
+ * This function iterates through all placed rooms, releases any loaded models,
+ * frees all WorldCell memory, and destroys the underlying hash map and the
+ * model cache.
  */
 void grid_destroy(void);
 
@@ -62,6 +76,10 @@ int grid_place_room(int32_t x, int32_t y, const struct room_def* room_template);
 
 /**
  * @brief Retrieves a cell from the grid.
+ *
+ * If the cell's region has been paged out, the whole region is restored
+ * first, which may allocate; a region that cannot be restored reads as
+ * empty.
  * @param x The grid x-coordinate.
  * @param y The grid y-coordinate.
  * @return A pointer to the WorldCell, or NULL if no room exists at that
@@ -69,22 +87,157 @@ int grid_place_room(int32_t x, int32_t y, const struct room_def* room_template);
  */
 struct world_cell* grid_get_cell(int32_t x, int32_t y);
 
+/**
+ * @brief Pages out the regions of the grid far from a point.
+ *
+ * The grid is split into GRID_REGION_SIZE by GRID_REGION_SIZE regions. Every
+ * region whose nearest cell is more than distance cells from (center_x,
+ * center_y) on either axis has its cells released and freed, and its rooms
+ * kept as a record of template ids and offsets, four bytes per room.
+ * grid_get_cell() and grid_place_room() restore a region the first time one
+ * of its coordinates is touched again, so the layout never changes; only the
+ * WorldCell pointers of paged-out rooms become invalid.
+ *
+ * Rooms whose template was not loaded by room_def_load_all() have no id to be
+ * found again by and always stay resident.
+ * @param center_x The grid x-coordinate to measure from, usually the
+ * player's.
+ * @param center_y The grid y-coordinate to measure from.
+ * @param distance How far regions may be and stay resident.
+ * @return The number of rooms paged out, -ECANCELED before grid_init(),
+ * -EINVAL if distance is negative, or -ENOMEM if a record cannot grow, in
+ * which case the remaining cells stay resident.
+ */
+int grid_page_out(int32_t center_x, int32_t center_y, int32_t distance);
+
+/**
+ * @brief Gets the number of cells currently resident in the grid.
+ * @return The number of WorldCells, not counting paged-out rooms.
+ */
+size_t grid_get_resident_count(void);
+
+/**
+ * @brief Gets the number of rooms currently paged out.
+ * @return The number of rooms kept in region records.
+ */
+size_t grid_get_paged_count(void);
+
+/**
+ * @brief Makes the rooms of a saved world part of the grid.
+ *
+ * Nothing is read up front. The first time grid_get_cell() or
+ * grid_place_room() touches a coordinate, the rooms of its region are
+ * inserted from the file, after which the region behaves like any other and
+ * may be paged out and restored from memory. Must be called on an empty grid;
+ * the file and the template table must stay valid until grid_destroy().
+ * @param file An opened save.
+ * @param templates The template for each entry of the file's name table, or
+ * NULL for names that are not in the catalog; their rooms are dropped.
+ * @return 0 on success, -ECANCELED before grid_init(), -EINVAL if an argument
+ * is NULL, -EBUSY if the grid is not empty or already has a save, or -ENOMEM
+ * on allocation failure.
+ */
+int grid_attach_save(const struct world_file* file,
+                     const struct room_def* const* templates);
+
+/**
+ * @brief Looks up a room without restoring anything.
+ *
+ * Resident cells are checked first, then paged-out records, then the
+ * attached save. The grid is read under the lock its main-thread changes
+ * hold, so unlike the rest of this module this may be called from any thread
+ * between grid_init() and grid_destroy(). Rooms are never replaced once
+ * placed, so a result that is not NULL stays valid.
+ * @param x The grid x-coordinate.
+ * @param y The grid y-coordinate.
+ * @return The room's template, or NULL if there is no room at (x, y) yet.
+ */
+const struct room_def* grid_get_saved_template(int32_t x, int32_t y);
+
+/**
+ * @brief Visits every room on the grid, including paged-out ones.
+ *
+ * Resident cells come first, then paged-out rooms, then rooms of the
+ * attached save whose region was never faulted in. Nothing is restored, and
+ * visit must not modify the grid.
+ * @param visit Called with the coordinates and template of each room.
+ * Returning nonzero stops the walk.
+ * @param context Passed through to visit.
+ * @return 0 once every room was visited, the first nonzero value returned by
+ * visit, or -EINVAL before grid_init() or if visit is NULL.
+ */
+int grid_for_each_room(int (*visit)(int32_t x,
+                                    int32_t y,
+                                    const struct room_def* room_template,
+                                    void* context),
+                       void* context);
+
+/**
+ * @brief Iterates over every cell resident in the grid.
+ *
+ * Works like hashmap_iter(): initialize a size_t iterator to 0 and call this
+ * function in a loop until it returns false. Paged-out rooms are not visited.
+ * The grid must not be modified during the iteration, and grid_get_cell()
+ * counts as a modification, since it may restore a region.
+ *
+ * @param[in,out] iterator Tracks the iteration state. Must be initialized to
+ * 0 for the first call.
+ * @param[out] cell Receives the next cell.
+ * @return true if a cell was found, false if the iteration is complete.
+ */
+bool grid_iter(size_t* iterator, struct world_cell** cell);
+
 /**
  * @brief Ensures the 3D model for a room is loaded into memory.
  *
- * If the model is already loaded, this function succeeds immediately.
+ * The model is acquired from the shared model cache, so cells built from the
+ * same template share a single copy of its meshes. If the model is already
+ * loaded, this function succeeds immediately; if it is still streaming in, it
+ * is finished synchronously.
  * @param cell A pointer to the WorldCell whose model should be loaded.
- * @return 0 on success, or -EINVAL if cell is NULL.
+ * @return 0 on success, -EINVAL if cell is NULL, or a negative error code from
+ * model_cache_acquire().
  */
 int grid_load_model(struct world_cell* cell);
 
+/**
+ * @brief Streams the 3D model for a room in without blocking.
+ *
+ * The first call takes a reference in the model cache and queues the model on
+ * the streaming worker. Later calls check whether the upload has finished and
+ * mark the cell as loaded once it has. The call is cheap and idempotent, so it
+ * can be repeated every frame for every cell that should be visible.
+ * @param cell A pointer to the WorldCell whose model should be streamed in.
+ * @return 0 on success, -EINVAL if cell is NULL, or a negative error code from
+ * model_cache_request().
+ */
+int grid_request_model(struct world_cell* cell);
+
 /**
  * @brief Ensures the 3D model for a room is unloaded from memory.
  *
- * If the model is not loaded, this function succeeds immediately.
+ * This releases the cell's reference in the model cache; the shared model
+ * stays cached while other cells use it, and after that until the cache's
+ * budget needs the memory. A pending streaming request is
+ * cancelled the same way. If the model is neither loaded nor requested, this
+ * function succeeds immediately.
  * @param cell A pointer to the WorldCell whose model should be unloaded.
  * @return 0 on success, or -EINVAL if cell is NULL.
  */
 int grid_unload_model(struct world_cell* cell);
 
+/**
+ * @brief Updates how far every cached room model is from the viewer.
+ *
+ * Each model's distance becomes the Chebyshev distance, in cells, from the
+ * given coordinate to the nearest resident cell built from its template.
+ * Models that no resident cell uses anymore count as furthest away. Idle
+ * models are evicted furthest first, see model_cache_set_distance(), so call
+ * this whenever the viewer changes cells, before releasing the models that
+ * went out of range.
+ * @param center_x The viewer's grid x-coordinate.
+ * @param center_y The viewer's grid y-coordinate.
+ */
+void grid_update_model_distances(int32_t center_x, int32_t center_y);
+
 #endif
@@ -0,0 +1,212 @@
+/**
+ * @file model_cache.h
+ * @brief Shares loaded room models between all cells that use them.
+ *
+ * Many resident world cells are built from the same room template, and every
+ * one of them renders the same .glb file. This module loads the model of each
+ * template only once and hands out shallow copies of the resulting Model
+ * handle. A reference count is kept per template, so parsing cost and VRAM
+ * use scale with the number of distinct templates instead of the number of
+ * cells.
+ *
+ * When the last cell using a model releases it, the model stays loaded but
+ * idle, so a player pacing across the edge of the loaded area does not
+ * unload and reload it every few steps. Idle models are only unloaded once
+ * the estimated memory of every loaded model exceeds the budget set with
+ * model_cache_set_budget(). The models whose cells were furthest from the
+ * viewer go first, then the least recently used ones.
+ *
+ * Models can also be streamed in. model_cache_request() queues the template's
+ * file on a background worker thread that reads and parses it, and
+ * model_cache_update() later uploads the parsed meshes on the main thread
+ * within a per-frame time budget. Only the upload has to stay on the main
+ * thread, because it needs the OpenGL context.
+ */
+#ifndef GAME_WORLD_MODEL_CACHE_H
+#define GAME_WORLD_MODEL_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+#include "game/world/room_def.h"
+
+/**
+ * @brief Initializes the model cache.
+ *
+ * Must be called before any other function in this module. Calling it again
+ * while the cache is initialized does nothing. This starts the streaming
+ * worker thread.
+ * @return 0 on success, -ENOMEM if the underlying hash map cannot be
+ * initialized, or -EAGAIN if the worker thread cannot be started.
+ */
+int model_cache_init(void);
+
+/**
+ * @brief Unloads every cached model and frees the cache.
+ *
+ * The streaming worker is stopped and any unfinished requests are dropped.
+ * Models that are still referenced are unloaded as well, so all handles
+ * previously returned by this module become invalid.
+ */
+void model_cache_destroy(void);
+
+/**
+ * @brief Acquires a shared reference to the model of a room template.
+ *
+ * The model is loaded from the template's model path on the first
+ * acquisition; later calls only increase its reference count. If the model is
+ * still streaming in, it is finished synchronously. The returned Model is a
+ * shallow copy that shares its meshes and materials with every other holder,
+ * so it must never be passed to UnloadModel() directly. Call
+ * model_cache_release() instead.
+ *
+ * @param def The room template whose model is requested.
+ * @param[out] out_model Receives the shared model handle.
+ * @return 0 on success, -EINVAL if an argument is NULL, -ECANCELED if the
+ * cache is not initialized, or -ENOMEM on allocation failure.
+ */
+int model_cache_acquire(const struct room_def* def, Model* out_model);
+
+/**
+ * @brief Takes a reference to a template's model without waiting for it.
+ *
+ * If the model is not cached yet, its file is queued on the streaming worker
+ * and the call returns immediately. Use model_cache_get() to find out when the
+ * model is ready. The reference is released with model_cache_release() like
+ * one taken by model_cache_acquire().
+ *
+ * @param def The room template whose model is requested.
+ * @return 0 on success, -EINVAL if def is NULL, -ECANCELED if the cache is not
+ * initialized, or -ENOMEM on allocation failure.
+ */
+int model_cache_request(const struct room_def* def);
+
+/**
+ * @brief Gets a template's model if it has finished loading.
+ *
+ * This does not change the reference count.
+ * @param def The room template to query.
+ * @param[out] out_model Receives the shared model handle if it is ready.
+ * @return true if the model is ready, false if it is still streaming in or is
+ * not cached at all.
+ */
+bool model_cache_get(const struct room_def* def, Model* out_model);
+
+/**
+ * @brief Gets the bounding box of a template's model if it has finished
+ * loading.
+ *
+ * The box is computed once when the model is loaded, in the model's own
+ * space with its root transform applied.
+ * @param def The room template to query.
+ * @param[out] out_bounds Receives the bounding box if the model is ready.
+ * @return true if the model is ready, false if it is still streaming in or is
+ * not cached at all.
+ */
+bool model_cache_get_bounds(const struct room_def* def,
+                            BoundingBox* out_bounds);
+
+/**
+ * @brief Finishes loading a requested model synchronously.
+ *
+ * This does not change the reference count.
+ * @param def The room template whose model should be finished.
+ * @param[out] out_model Receives the shared model handle.
+ * @return 0 on success, -EINVAL if an argument is NULL, or -ENOENT if the
+ * template has no cached model.
+ */
+int model_cache_wait(const struct room_def* def, Model* out_model);
+
+/**
+ * @brief Uploads streamed models that the worker has finished parsing.
+ *
+ * Must be called from the main thread, typically once per frame. Meshes of
+ * the models the worker has parsed are uploaded one at a time until the time
+ * budget is spent, so a model with many meshes can take several calls. At
+ * least one mesh is uploaded per call when any is waiting, so streaming
+ * always makes progress.
+ *
+ * @param budget_seconds The time budget for this call, in seconds.
+ * @return The number of models that became ready during this call.
+ */
+size_t model_cache_update(double budget_seconds);
+
+/**
+ * @brief Releases a reference previously taken with model_cache_acquire() or
+ * model_cache_request().
+ *
+ * When the last reference is released, the model becomes idle and may be
+ * unloaded to stay within the budget. A model that is still streaming in is
+ * dropped once its file has been read.
+ * @param def The room template whose model is released.
+ * @return 0 on success, -EINVAL if def is NULL, or -ENOENT if the template has
+ * no cached model or no outstanding reference.
+ */
+int model_cache_release(const struct room_def* def);
+
+/**
+ * @brief Sets how much memory loaded models may use before idle ones are
+ * unloaded.
+ *
+ * Idle models over the new budget are unloaded immediately. Models in use
+ * are never unloaded, so the budget can be exceeded while they are needed.
+ * The default of 0 unloads every model as soon as it becomes idle.
+ * @param budget_bytes The budget, in bytes of estimated RAM and VRAM.
+ */
+void model_cache_set_budget(size_t budget_bytes);
+
+/**
+ * @brief Records how far the cells using a template are from the viewer.
+ *
+ * This is a hint for the order of eviction: among idle models, the ones
+ * furthest away are unloaded first. Models start with a distance of 0.
+ * @param def The room template.
+ * @param distance The distance, in any unit the caller uses consistently.
+ */
+void model_cache_set_distance(const struct room_def* def, float distance);
+
+/**
+ * @brief Sets the distance of every cached model at once.
+ *
+ * Together with model_cache_lower_distance(), this recomputes every distance
+ * from scratch: reset them all to the furthest value, then lower each one for
+ * every cell that uses its template.
+ * @param distance The distance to give every model.
+ */
+void model_cache_reset_distances(float distance);
+
+/**
+ * @brief Lowers the distance of a template's model, see
+ * model_cache_set_distance().
+ *
+ * The model keeps the smaller of its current distance and the given one, so
+ * a model shared by several cells ends up with the distance of the nearest.
+ * @param def The room template.
+ * @param distance The distance of one of the cells using the template.
+ */
+void model_cache_lower_distance(const struct room_def* def, float distance);
+
+/**
+ * @brief Gets the estimated memory of every loaded model, idle or in use.
+ * @return The size in bytes.
+ */
+size_t model_cache_get_resident_bytes(void);
+
+/**
+ * @brief Gets the number of distinct models currently held by the cache.
+ *
+ * Idle models that have not been evicted yet are included.
+ * @return The number of resident models, or 0 if the cache is not initialized.
+ */
+size_t model_cache_get_count(void);
+
+/**
+ * @brief Gets the number of outstanding references to a template's model.
+ * @param def The room template to query.
+ * @return The reference count, or 0 if the template has no cached model.
+ */
+int model_cache_get_refcount(const struct room_def* def);
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * @file model_file.h
+ * @brief Parses room models without uploading them.
+ *
+ * raylib's LoadModel() parses a .glb file and uploads its meshes to the GPU
+ * in the same call, so all of it has to run on the thread that owns the
+ * OpenGL context. This module only does the parsing. It makes no OpenGL
+ * calls, so the model cache can run it on its streaming worker and leave
+ * nothing but the UploadMesh() calls to the main thread.
+ *
+ * Only what the room models need is supported: binary glTF 2.0 with all of
+ * its data in the embedded buffer, triangle primitives with float positions,
+ * normals and texture coordinates, and materials with a base color factor.
+ * Textures are not loaded.
+ */
+#ifndef GAME_WORLD_MODEL_FILE_H
+#define GAME_WORLD_MODEL_FILE_H
+
+#include <stddef.h>
+
+#include "raylib.h"
+
+/**
+ * @brief Parses a .glb file into a model whose meshes are not uploaded yet.
+ *
+ * As with LoadModel(), every triangle primitive of every node becomes one
+ * mesh with the node's world transform applied to its vertices, and material
+ * 0 is the default material. Each mesh must be passed to UploadMesh() on the
+ * main thread before it is drawn. UnloadModel() frees the model whether or
+ * not its meshes have been uploaded.
+ *
+ * This can be called from any thread once the window is open.
+ * @param data The contents of the file.
+ * @param size The size of data in bytes.
+ * @param[out] out_model Receives the model. It is zeroed on failure.
+ * @return 0 on success, -EINVAL if the data is not a .glb file of the
+ * supported kind, or -ENOMEM on allocation failure.
+ */
+int model_file_parse(const unsigned char* data, size_t size, Model* out_model);
+
+#endif
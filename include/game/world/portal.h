@@ -0,0 +1,76 @@
+/**
+ * @file portal.h
+ * @brief Finds the rooms that can be seen from a cell through its doorways.
+ *
+ * Where rooms are closed boxes, with walls and a ceiling, they only open
+ * onto their neighbors through the doors in their template's door_mask. The
+ * visibility pass then starts at the viewer's cell and flood-fills the grid
+ * breadth first, crossing from a room into a neighbor only where both rooms
+ * have a door on their shared wall and that doorway lies at least partly
+ * inside the camera frustum. Rooms behind walls, or whose doorways are out of
+ * view, are never reached, so the number of rooms drawn tracks what is
+ * visible rather than the size of the loaded area.
+ *
+ * Doorways are tested as the whole shared wall, because templates only
+ * record which walls have doors, not where on the wall they are. The test
+ * may therefore let a few hidden rooms through, but as long as the walls
+ * really occlude, it never hides a visible one.
+ *
+ * Open-topped rooms, see room_def.is_open_topped, are seen into from above
+ * over their walls, like all of the game's rooms under its overhead camera.
+ * After the flood fill, every open-topped room within the radius whose cell
+ * lies at least partly inside the frustum is added as well, reached through
+ * a doorway or not. Roofed rooms are only ever seen through doorways.
+ *
+ * A view whose walls do not occlude at all skips both passes and returns
+ * every cell within the radius, leaving all culling to the caller.
+ */
+#ifndef GAME_WORLD_PORTAL_H
+#define GAME_WORLD_PORTAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game/frustum.h"
+#include "game/world/grid.h"
+
+/**
+ * @struct portal_view
+ * @brief Where the visibility pass starts and how far it may go.
+ */
+struct portal_view {
+    int32_t origin_x;              /**< Grid x of the viewer's cell. */
+    int32_t origin_y;              /**< Grid y of the viewer's cell. */
+    int32_t radius;                /**< Furthest cell on either axis. */
+    float cell_size;               /**< Edge length of a cell. */
+    float cell_height;             /**< Room height, centered on y = 0. */
+    const struct frustum* frustum; /**< Camera frustum, or NULL for none. */
+    bool walls_occlude; /**< Whether rooms hide what lies behind them. */
+};
+
+/**
+ * @brief Collects the cells visible from the viewer's cell.
+ *
+ * If view->walls_occlude is set, the viewer's cell is always visible and
+ * comes first; the other cells follow in the order they were reached through
+ * doorways, then the open-topped rooms in view that no doorway led to. Cell
+ * (x, y) is centered on (x * cell_size, 0, y * cell_size) in world space,
+ * with DOOR_NORTH facing +z and DOOR_EAST facing +x. Without a viewer's cell
+ * only the open-topped rooms in view are returned.
+ *
+ * Otherwise every cell within the radius that holds a room is returned, the
+ * viewer's cell first if it exists, and the frustum is not used.
+ *
+ * @param view The starting cell, range and frustum.
+ * @param[out] cells Receives the visible cells.
+ * @param capacity The length of cells. Holding every cell within the
+ * radius, (2 * radius + 1) squared, is always enough; the pass stops early
+ * when cells is full.
+ * @return The number of cells written.
+ */
+size_t portal_find_visible(const struct portal_view* view,
+                           struct world_cell** cells,
+                           size_t capacity);
+
+#endif
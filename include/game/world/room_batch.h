@@ -0,0 +1,95 @@
+/**
+ * @file room_batch.h
+ * @brief Draws every visible room built from the same template at once.
+ *
+ * Neighboring cells are often built from the same room template and render
+ * the same shared model at different translations. Instead of one DrawModel()
+ * call per cell, the room batch collects the visible rooms of a frame between
+ * room_batch_begin() and room_batch_end(), groups them by template, and draws
+ * each mesh of a group with a single DrawMeshInstanced() call that takes the
+ * transforms of every room in the group. A larger view radius then adds
+ * instances, not draw calls.
+ *
+ * Instancing needs a vertex shader that reads the per-instance transform.
+ * If it cannot be compiled, the batch falls back to drawing every mesh of
+ * every room with DrawMesh(), as DrawModel() would.
+ *
+ * The batch must only be used from the thread that owns the OpenGL context.
+ */
+#ifndef GAME_WORLD_ROOM_BATCH_H
+#define GAME_WORLD_ROOM_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+#include "game/world/room_def.h"
+
+/**
+ * @brief Loads the instancing shader.
+ *
+ * Must be called after InitWindow(). Calling it again while the batch is
+ * initialized does nothing.
+ * @return 0 on success, or -ENOMEM if the instance list cannot be allocated.
+ */
+int room_batch_init(void);
+
+/**
+ * @brief Unloads the shader and frees the batch.
+ */
+void room_batch_destroy(void);
+
+/**
+ * @brief Checks whether rooms are drawn with instancing.
+ * @return true if the batch is initialized and its instancing shader works.
+ */
+bool room_batch_is_instanced(void);
+
+/**
+ * @brief Starts collecting the rooms of a frame.
+ *
+ * Call inside BeginMode3D().
+ */
+void room_batch_begin(void);
+
+/**
+ * @brief Queues a room to be drawn by room_batch_end().
+ *
+ * Rooms with the same template must pass the same shared model, as handed
+ * out by the model cache.
+ * @param def The template the room is built from.
+ * @param model The template's model.
+ * @param position Where the model's origin is placed in world space.
+ * @param scale The uniform scale of the model.
+ * @return 0 on success, -EINVAL if def is NULL, -ECANCELED if the batch is
+ * not between room_batch_begin() and room_batch_end(), or -ENOMEM if the
+ * instance list cannot grow.
+ */
+int room_batch_add(const struct room_def* def,
+                   Model model,
+                   Vector3 position,
+                   float scale);
+
+/**
+ * @brief Draws every queued room, one template at a time, then empties the
+ * batch.
+ */
+void room_batch_end(void);
+
+/**
+ * @brief Gets the number of rooms drawn by the last room_batch_end().
+ * @return The room count.
+ */
+size_t room_batch_get_room_count(void);
+
+/**
+ * @brief Gets the number of mesh draw calls made by the last room_batch_end().
+ *
+ * With instancing, this is the number of meshes of every distinct template
+ * drawn, independent of how many rooms use each template.
+ * @return The draw call count.
+ */
+size_t room_batch_get_draw_count(void);
+
+#endif
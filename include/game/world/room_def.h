@@ -1,9 +1,12 @@
 #ifndef GAME_WORLD_ROOM_DEF_H
 #define GAME_WORLD_ROOM_DEF_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "game/rng.h"
+
 /**
  * @brief Bitmask representing the four cardinal door directions.
  *
@@ -27,6 +30,9 @@ struct room_def {
     uint8_t door_mask; /**< Bitmask of door connections using DOOR_* flags. */
     int weight; /**< The probability weight for procedural generation. Higher is
                    more common. */
+    uint16_t id; /**< Stable index among the loaded templates. */
+    bool is_open_topped; /**< Whether it has no ceiling, so it can be seen
+                            into over its walls. */
 };
 
 /**
@@ -35,6 +41,7 @@ struct room_def {
  * This function scans the specified directory for .glb files, parses their
  * filenames to determine their door configurations, and stores them in an
  * internal list. It must be called before any other functions in this module.
+ * Rooms are open-topped unless their filename contains "_roofed".
  *
  * @param directory_path The path to the directory containing room models.
  * @return The number of templates successfully loaded on success.
@@ -64,6 +71,19 @@ size_t room_def_get_count(void);
  */
 const struct room_def* room_def_get_by_index(size_t index);
 
+/**
+ * @brief Retrieves a room template by its stable id.
+ *
+ * Ids are assigned in load order and stay valid until room_def_unload_all(),
+ * including for templates taken out of the generation pool with
+ * room_def_remove(). They are small enough to stand in for a template pointer
+ * in compact records.
+ * @param id The id of the template to retrieve.
+ * @return A constant pointer to the struct room_def, or NULL if no template
+ * has that id.
+ */
+const struct room_def* room_def_get_by_id(uint16_t id);
+
 /**
  * @brief Finds a random room template that satisfies both required and
  * forbidden door constraints.
@@ -76,6 +96,11 @@ const struct room_def* room_def_get_by_index(size_t index);
  * 1. It contains all doors specified in the `required_doors` mask.
  * 2. It contains none of the doors specified in the `forbidden_doors` mask.
  *
+ * The matches for every combination of masks are precomputed when the
+ * templates are loaded, so a lookup is a table index plus one random draw
+ * and never allocates. Bits outside the four door flags cannot be satisfied
+ * in `required_doors` and are ignored in `forbidden_doors`.
+ *
  * @param required_doors A bitmask of doors the room must have to be considered
  * a match.
  * @param forbidden_doors A bitmask of doors the room must NOT have to be
@@ -86,6 +111,37 @@ const struct room_def* room_def_get_by_index(size_t index);
 const struct room_def* room_def_find_constrained(uint8_t required_doors,
                                                  uint8_t forbidden_doors);
 
+/**
+ * @brief Finds a room template like room_def_find_constrained(), but draws
+ * from the given generator context instead of the global one.
+ *
+ * @param required_doors A bitmask of doors the room must have.
+ * @param forbidden_doors A bitmask of doors the room must NOT have.
+ * @param rng The generator context to draw from.
+ * @return A constant pointer to a suitable template, or nullptr if no template
+ * satisfies the constraints.
+ */
+const struct room_def* room_def_find_constrained_r(uint8_t required_doors,
+                                                   uint8_t forbidden_doors,
+                                                   struct rng* rng);
+
+/**
+ * @brief Finds a room template like room_def_find_constrained(), but draws
+ * from a counter-based stream instead of the global generator.
+ *
+ * The result is a pure function of the constraints, the key and the current
+ * template pool, so it does not depend on any earlier calls.
+ *
+ * @param required_doors A bitmask of doors the room must have.
+ * @param forbidden_doors A bitmask of doors the room must NOT have.
+ * @param key The stream key, usually from rng_hash_coords().
+ * @return A constant pointer to a suitable template, or nullptr if no template
+ * satisfies the constraints.
+ */
+const struct room_def* room_def_find_constrained_keyed(uint8_t required_doors,
+                                                       uint8_t forbidden_doors,
+                                                       uint64_t key);
+
 /**
  * @brief Removes a room definition from the available generation pool.
  *
@@ -93,6 +149,9 @@ const struct room_def* room_def_find_constrained(uint8_t required_doors,
  * room) from being procedurally generated after they have been manually placed.
  * It efficiently removes the specified template from the internal list using a
  * "swap and pop" operation.
+ * The constraint table used by room_def_find_constrained() is rebuilt
+ * afterwards. The template itself stays loaded, keeps its id, and is freed by
+ * room_def_unload_all() with the others.
  *
  * @param room_to_remove A constant pointer to the room definition to remove. If
  *                       the pointer is not found in the list, the function does
@@ -10,16 +10,25 @@
 #ifndef GAME_WORLD_WORLD_H
 #define GAME_WORLD_WORLD_H
 
+#include <stdint.h>
+
 #include "raylib.h"
 
 #include "game/world/grid.h"
 
+/** Largest radius world_set_load_radius() accepts. */
+enum { WORLD_MAX_LOAD_RADIUS = 16 };
+
+/** Smallest distance world_set_page_distance() accepts. */
+enum { WORLD_MIN_PAGE_DISTANCE = 2 * WORLD_MAX_LOAD_RADIUS };
+
 /**
  * @brief Initializes the entire world system.
  *
  * This function orchestrates the initialization of all underlying world
- * modules: it loads room templates, initializes the world grid, and calls the
- * generator to create the starting area.
+ * modules: it loads room templates, initializes the world grid, calls the
+ * generator to create the starting area, and starts the background
+ * generation worker.
  *
  * @param seed The seed for the world generation.
  * @param assets_path The path to the directory containing room models.
@@ -27,6 +36,41 @@
  */
 int world_init(unsigned int seed, const char* assets_path);
 
+/**
+ * @brief Initializes the world from a save written by world_save().
+ *
+ * Works like world_init(), but the rooms come from the save and the
+ * generator continues from the saved state, so the world keeps growing
+ * exactly as it would have in the session that saved it. The save is
+ * memory-mapped and its regions are read as the player reaches them, see
+ * grid_attach_save(); it stays open until world_destroy(). Rooms whose
+ * template is no longer in assets_path are dropped.
+ *
+ * @param save_path The path to the save.
+ * @param assets_path The path to the directory containing room models.
+ * If the save cannot be loaded, everything set up so far is released again,
+ * so the caller can fall back to world_init().
+ *
+ * @return 0 on success, -ENOENT if the save cannot be opened, -EINVAL if it
+ * is not a valid save, or another negative error code if initialization
+ * fails.
+ */
+int world_load(const char* save_path, const char* assets_path);
+
+/**
+ * @brief Saves every room placed so far, and the generator's state.
+ *
+ * Waits for the background generator to finish its queued chunks first.
+ * Rooms that are paged out or were never read from a loaded save are saved
+ * too, without being restored. The save may be written over the one the
+ * world was loaded from.
+ *
+ * @param path The path to write the save to.
+ * @return 0 on success, -EINVAL if the world is not initialized or path is
+ * NULL, or a negative error code from world_file_write().
+ */
+int world_save(const char* path);
+
 /**
  * @brief Cleans up and destroys the world, freeing all associated resources.
  */
@@ -35,15 +79,28 @@ void world_destroy(void);
 /**
  * @brief Updates the state of the game world.
  *
- * Called every frame, this function tracks the player's position, triggers
- * new chunk generation when the player moves to a new grid cell, and manages
+ * Called every frame, this function applies the rooms finished by the
+ * background generator, tracks the player's position, queues new chunk
+ * generation when the player moves to a new grid cell, and manages
  * the loading/unloading of room models based on proximity to the player.
+ * Models are streamed in asynchronously: each call uploads meshes of the
+ * models the streaming worker has finished parsing, within the budget set by
+ * world_set_stream_budget(), so crossing into a new cell never stalls the
+ * frame on file I/O or glTF parsing.
  * @param player_pos The player's current 3D world position.
  */
 int world_update(Vector3 player_pos);
 
 /**
  * @brief Draws all visible and loaded rooms in the world.
+ *
+ * Must be called inside BeginMode3D(). Rooms within the load radius are drawn
+ * if their bounding box intersects the camera frustum and, unless they are
+ * open-topped, a chain of doorways leads to them from the player's room, see
+ * portal.h. Rooms whose models are still streaming in are skipped until they
+ * are ready.
+ * Rooms built from the same template are drawn together with instancing, see
+ * room_batch.h.
  */
 int world_draw(void);
 
@@ -65,4 +122,47 @@ Vector3 world_get_room_center(Vector3 pos);
  */
 Vector3 world_get_spawn_position(void);
 
+/**
+ * Sets how much time world_update() may spend per frame uploading streamed
+ * room models, in milliseconds. At least one mesh of a parsed model is
+ * uploaded per frame regardless of the budget. The default is 2 ms.
+ */
+void world_set_stream_budget(double milliseconds);
+
+/**
+ * Sets how many cells around the player, along each axis, are streamed in
+ * and considered for drawing. Cells that fall outside the new radius are
+ * unloaded and cells that fall inside are requested immediately. Only rooms
+ * in view are drawn, so a larger radius mostly costs memory and streaming,
+ * not draw calls. The default is 2, which matches the area generated around
+ * the player.
+ * @param radius The new radius, from 0 to WORLD_MAX_LOAD_RADIUS.
+ * @return 0 on success, -EINVAL if the radius is out of range, or -ENOMEM if
+ * the list of visible cells cannot grow.
+ */
+int world_set_load_radius(int32_t radius);
+
+/**
+ * Returns the current load radius, see world_set_load_radius().
+ */
+int32_t world_get_load_radius(void);
+
+/**
+ * @brief Sets how far from the player rooms stay resident in the grid.
+ *
+ * Whenever the player changes cells, grid regions lying entirely beyond this
+ * many cells are paged out into compact records, see grid_page_out(), so a
+ * long session in an endless world keeps a bounded working set. Paged-out
+ * rooms come back unchanged when the player returns. The default is 64.
+ * @param distance The new distance, at least WORLD_MIN_PAGE_DISTANCE so
+ * paging never touches the rooms being streamed in or out.
+ * @return 0 on success, or -EINVAL if the distance is too small.
+ */
+int world_set_page_distance(int32_t distance);
+
+/**
+ * Returns the current page distance, see world_set_page_distance().
+ */
+int32_t world_get_page_distance(void);
+
 #endif
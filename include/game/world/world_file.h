@@ -0,0 +1,199 @@
+/**
+ * @file world_file.h
+ * @brief Reads and writes saved worlds.
+ *
+ * The layout of a sequentially generated world depends on the order its
+ * chunks were generated in, so a seed alone cannot bring it back. A .world
+ * file stores every placed room instead, together with the generator state
+ * needed to keep generating where the session left off.
+ *
+ * A .world file is laid out as follows, in the byte order of the machine
+ * that wrote it:
+ *
+ *     struct world_file_header
+ *     struct world_file_name[template_count]
+ *     struct world_file_region[region_count]
+ *     struct world_file_room[room_count]
+ *
+ * Rooms refer to their template by index into the name table, which holds
+ * template file names rather than load order, so a save survives templates
+ * being added to the catalog. Rooms are grouped by the grid region they lie
+ * in; regions are sorted by (y, x), and the rooms of a region by their
+ * offset within it, (offset_y, offset_x). The file is memory-mapped and
+ * searched in place, so opening it costs the same for any number of rooms
+ * and only the regions that are actually visited are ever paged in.
+ */
+#ifndef GAME_WORLD_WORLD_FILE_H
+#define GAME_WORLD_WORLD_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WORLD_FILE_MAGIC "GWLD"
+
+enum {
+    WORLD_FILE_VERSION = 1,    /**< Bumped whenever the layout changes. */
+    WORLD_FILE_NAME_SIZE = 64, /**< Size of a name, including the NUL. */
+};
+
+/**
+ * @struct world_file_header
+ * @brief The fixed-size header at the start of a .world file.
+ */
+struct world_file_header {
+    char magic[4];           /**< Always WORLD_FILE_MAGIC. */
+    uint32_t version;        /**< Always WORLD_FILE_VERSION. */
+    uint64_t seed;           /**< The seed the world was generated from. */
+    uint64_t rng_state[4];   /**< The generator's sequential context. */
+    uint32_t rng_mode;       /**< An enum generator_rng_mode. */
+    uint32_t region_size;    /**< Always GRID_REGION_SIZE. */
+    uint32_t template_count; /**< Number of entries in the name table. */
+    uint32_t region_count;   /**< Number of entries in the region index. */
+    uint64_t room_count;     /**< Number of room records. */
+};
+
+/**
+ * @struct world_file_name
+ * @brief An entry of the name table: a template's file name.
+ */
+struct world_file_name {
+    char name[WORLD_FILE_NAME_SIZE]; /**< NUL-terminated and NUL-padded. */
+};
+
+/**
+ * @struct world_file_region
+ * @brief An entry of the region index.
+ */
+struct world_file_region {
+    int32_t x;           /**< Region x, grid x divided by the region size. */
+    int32_t y;           /**< Region y, grid y divided by the region size. */
+    uint64_t first_room; /**< Index of the region's first room record. */
+    uint32_t room_count; /**< Number of room records in the region. */
+    uint32_t reserved;   /**< Zero. */
+};
+
+/**
+ * @struct world_file_room
+ * @brief A placed room.
+ */
+struct world_file_room {
+    uint8_t offset_x;        /**< Grid x minus the region's first x. */
+    uint8_t offset_y;        /**< Grid y minus the region's first y. */
+    uint16_t template_index; /**< Index into the name table. */
+};
+
+/**
+ * @struct world_file
+ * @brief An opened .world file.
+ */
+struct world_file {
+    const unsigned char* data;               /**< The whole file. */
+    size_t size;                             /**< File size in bytes. */
+    const struct world_file_header* header;  /**< Points into data. */
+    const struct world_file_name* names;     /**< Points into data. */
+    const struct world_file_region* regions; /**< Points into data. */
+    const struct world_file_room* rooms;     /**< Points into data. */
+    bool is_mapped; /**< Whether data is a mapping rather than a copy. */
+};
+
+/**
+ * @struct world_file_info
+ * @brief Everything besides the rooms that world_file_write() stores.
+ */
+struct world_file_info {
+    uint64_t seed;            /**< The seed the world was generated from. */
+    uint64_t rng_state[4];    /**< The generator's sequential context. */
+    uint32_t rng_mode;        /**< An enum generator_rng_mode. */
+    const char* const* names; /**< Template file names, by template index. */
+    size_t template_count;    /**< The length of names. */
+};
+
+/**
+ * @struct world_file_entry
+ * @brief A room handed to world_file_write().
+ */
+struct world_file_entry {
+    int32_t x;               /**< The room's grid x-coordinate. */
+    int32_t y;               /**< The room's grid y-coordinate. */
+    uint16_t template_index; /**< Index into world_file_info.names. */
+};
+
+/**
+ * @brief Opens a .world file and validates its header.
+ *
+ * The file is memory-mapped where the platform supports it and read into
+ * memory otherwise. Only the header and the sizes of the tables are checked
+ * here; the region index and the rooms are checked as they are looked up.
+ *
+ * @param file The file to open.
+ * @param path Path to the .world file.
+ * @return 0 on success, -ENOENT if the file cannot be opened or mapped, or
+ * -EINVAL if it is not a valid .world file of the current version.
+ */
+int world_file_open(struct world_file* file, const char* path);
+
+/**
+ * @brief Finds the entry of a region in the region index.
+ *
+ * This is a binary search over the mapped index and never allocates, so it
+ * can be called from any thread while the file is open.
+ * @param file An opened file.
+ * @param region_x The region's x-coordinate.
+ * @param region_y The region's y-coordinate.
+ * @return The region's entry, or NULL if the file holds no rooms in it.
+ */
+const struct world_file_region* world_file_find_region(
+    const struct world_file* file,
+    int32_t region_x,
+    int32_t region_y);
+
+/**
+ * @brief Gets the room records of a region.
+ * @param file An opened file.
+ * @param region An entry of the file's region index.
+ * @return region->room_count records, or NULL if the entry points outside
+ * the file.
+ */
+const struct world_file_room* world_file_get_rooms(
+    const struct world_file* file,
+    const struct world_file_region* region);
+
+/**
+ * @brief Gets a name from the name table.
+ * @param file An opened file.
+ * @param template_index The index of the name.
+ * @return The name, or NULL if the index is out of range or the entry is
+ * not NUL-terminated.
+ */
+const char* world_file_get_name(const struct world_file* file,
+                                uint16_t template_index);
+
+/**
+ * @brief Unmaps or frees an opened file.
+ * @param file The file to close.
+ */
+void world_file_close(struct world_file* file);
+
+/**
+ * @brief Sorts rooms by region and writes them as a .world file.
+ *
+ * The file is written next to path and renamed over it once complete, so a
+ * mapping of the previous file at path stays valid and a failed write never
+ * leaves a truncated save behind.
+ *
+ * @param path Path of the file to write.
+ * @param info The generator state and the name table.
+ * @param rooms The rooms to store, at most one per coordinate. Sorted in
+ * place.
+ * @param room_count The number of rooms.
+ * @return 0 on success, -EINVAL if a name does not fit the name table or a
+ * room refers to a missing name, -ENOMEM on allocation failure, or -EIO if
+ * the file cannot be written.
+ */
+int world_file_write(const char* path,
+                     const struct world_file_info* info,
+                     struct world_file_entry* rooms,
+                     size_t room_count);
+
+#endif
@@ -1,35 +1,56 @@
-#include "../include/game/anim.h"
-
-void init_anim(struct anim* animation, const char* path, int frame_delay) {
-    animation->gif_anim = LoadImageAnim(path, &animation->frame_count);
-    animation->tex_anim = LoadTextureFromImage(animation->gif_anim);
-    animation->next_frame_offset = 0;
-    animation->current_frame = 0;
-    animation->frame_delay = frame_delay;
-    animation->frame_counter = 0;
-}
-
-void update_anim(struct anim* animation) {
-    animation->frame_counter++;
-    if (animation->frame_counter >= animation->frame_delay) {
-        animation->current_frame++;
-        if (animation->current_frame >= animation->frame_count) {
-            animation->current_frame = 0;
-        }
-
-        animation->next_frame_offset = animation->gif_anim.width *
-                                       animation->gif_anim.height * 4 *
-                                       animation->current_frame;
-
-        UpdateTexture(animation->tex_anim,
-                      ((unsigned char*)animation->gif_anim.data +
-                       animation->next_frame_offset));
-
-        animation->frame_counter = 0;
-    }
-}
-
-void unload_anim(struct anim* animation) {
-    UnloadTexture(animation->tex_anim);
-    UnloadImage(animation->gif_anim);
-}
+#include "../include/game/anim.h"
+
+#include <errno.h>
+
+int init_anim(struct anim* animation, const char* path, int frame_delay) {
+    animation->clip = anim_cache_acquire(path);
+    animation->current_frame = 0;
+    animation->frame_delay = frame_delay;
+    animation->frame_counter = 0;
+
+    if (!animation->clip) {
+        TraceLog(LOG_WARNING, "ANIM: Failed to acquire animation: %s", path);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+void unload_anim(struct anim* animation) {
+    if (animation->clip) {
+        (void)anim_cache_release(animation->clip);
+        animation->clip = nullptr;
+    }
+}
+
+void update_anim(struct anim* animation) {
+    if (!anim_cache_use(animation->clip)) {
+        return;
+    }
+
+    animation->frame_counter++;
+    if (animation->frame_counter >= animation->frame_delay) {
+        animation->current_frame++;
+        if (animation->current_frame >= animation->clip->frame_count) {
+            animation->current_frame = 0;
+        }
+
+        animation->frame_counter = 0;
+    }
+}
+
+void draw_anim(const struct anim* animation,
+               Vector3 position,
+               float size,
+               Color tint) {
+    const struct atlas* atlas = anim_cache_use(animation->clip);
+    if (!atlas) {
+        return;
+    }
+
+    struct sprite sprite;
+    if (atlas_get_sprite(atlas, animation->current_frame, position, size,
+                         tint, &sprite)) {
+        sprite_batch_add(&sprite);
+    }
+}
@@ -0,0 +1,494 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/anim_cache.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "raylib.h"
+
+#include "game/anim.h"
+#include "game/anim_file.h"
+#include "game/ds/vector.h"
+#include "game/profiler.h"
+
+enum { CONVERTED_PATH_SIZE = 256, MAX_DECODE_WORKERS = 16 };
+
+/**
+ * Clips being preloaded together. Workers claim clips by index and report
+ * them back in the order they finish, so the preloading thread can upload
+ * each one as soon as its frames are ready.
+ */
+struct decode_queue {
+    struct anim_clip** clips;
+    int* results;
+    size_t* decoded;
+    size_t count;
+    size_t next_clip;
+    size_t decoded_count;
+    pthread_mutex_t lock;
+    pthread_cond_t clip_decoded;
+};
+
+static struct vector clips;
+static bool is_initialized = false;
+static size_t budget = 0;
+static size_t resident_bytes = 0;
+static size_t loaded_count = 0;
+static uint64_t use_clock = 0;
+
+static int load_clip(struct anim_clip* clip);
+static int decode_clip(struct anim_clip* clip);
+static int upload_clip(struct anim_clip* clip, int decode_result);
+static size_t get_worker_count(size_t clip_count);
+static void load_clips_parallel(struct decode_queue* queue);
+static void* decode_worker(void* arg);
+static void unload_clip(struct anim_clip* clip);
+static void free_clip(struct anim_clip* clip);
+static void evict_clips(const struct anim_clip* keep);
+static int load_frames(struct atlas* atlas, const char* path);
+static bool has_extension(const char* path, const char* extension);
+static int get_converted_path(const char* path, char* buffer, size_t size);
+static int load_converted(struct atlas* atlas, const char* path);
+static int load_gif(struct atlas* atlas, const char* path);
+
+int anim_cache_init(size_t budget_bytes) {
+    budget = budget_bytes;
+    if (is_initialized) {
+        evict_clips(nullptr);
+        return 0;
+    }
+
+    if (vector_init(&clips) != 0) {
+        TraceLog(LOG_ERROR,
+                 "ANIM_CACHE: Failed to initialize vector (out of memory).");
+        return -ENOMEM;
+    }
+
+    resident_bytes = 0;
+    loaded_count = 0;
+    use_clock = 0;
+    is_initialized = true;
+
+    return 0;
+}
+
+void anim_cache_destroy(void) {
+    if (!is_initialized) {
+        return;
+    }
+
+    for (size_t i = 0; i < vector_len(&clips); i++) {
+        struct anim_clip* clip = vector_get(&clips, i);
+        if (clip->refcount > 0) {
+            TraceLog(LOG_WARNING,
+                     "ANIM_CACHE: Destroying clip with %d live references: %s",
+                     clip->refcount, clip->path);
+        }
+        free_clip(clip);
+    }
+
+    vector_destroy(&clips);
+    is_initialized = false;
+}
+
+struct anim_clip* anim_cache_acquire(const char* path) {
+    if (!is_initialized || !path) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < vector_len(&clips); i++) {
+        struct anim_clip* clip = vector_get(&clips, i);
+        if (strcmp(clip->path, path) == 0) {
+            clip->refcount++;
+            return clip;
+        }
+    }
+
+    struct anim_clip* clip = calloc(1, sizeof(struct anim_clip));
+    if (!clip) {
+        return nullptr;
+    }
+
+    clip->path = strdup(path);
+    if (!clip->path || vector_push(&clips, clip) != 0) {
+        free(clip->path);
+        free(clip);
+        return nullptr;
+    }
+
+    clip->refcount = 1;
+    return clip;
+}
+
+int anim_cache_release(struct anim_clip* clip) {
+    if (!clip) {
+        return -EINVAL;
+    }
+
+    size_t count = is_initialized ? vector_len(&clips) : 0;
+    size_t index = 0;
+    while (index < count && vector_get(&clips, index) != clip) {
+        index++;
+    }
+    if (index == count) {
+        return -ENOENT;
+    }
+
+    if (--clip->refcount > 0) {
+        return 0;
+    }
+
+    // Order does not matter, so the last clip fills the gap.
+    struct anim_clip* last = vector_pop(&clips);
+    if (last != clip) {
+        (void)vector_set(&clips, index, last);
+    }
+    free_clip(clip);
+
+    return 0;
+}
+
+int anim_cache_preload(struct anim_clip* clip) {
+    return anim_cache_preload_all(&clip, 1);
+}
+
+int anim_cache_preload_all(struct anim_clip* const* clips, size_t count) {
+    struct decode_queue queue = {
+        .clips = malloc((count + 1) * sizeof(struct anim_clip*)),
+        .results = malloc((count + 1) * sizeof(int)),
+        .decoded = malloc((count + 1) * sizeof(size_t)),
+    };
+    if (!queue.clips || !queue.results || !queue.decoded) {
+        free((void*)queue.clips);
+        free(queue.results);
+        free(queue.decoded);
+        return -ENOMEM;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct anim_clip* clip = clips[i];
+        if (!clip) {
+            ret = -EINVAL;
+            continue;
+        }
+
+        bool is_queued = false;
+        for (size_t j = 0; j < queue.count && !is_queued; j++) {
+            is_queued = queue.clips[j] == clip;
+        }
+        if (!clip->is_loaded && !clip->is_missing && !is_queued) {
+            queue.clips[queue.count++] = clip;
+        }
+    }
+
+    load_clips_parallel(&queue);
+
+    for (size_t i = 0; i < queue.count && ret == 0; i++) {
+        ret = queue.results[i];
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct anim_clip* clip = clips[i];
+        if (!clip) {
+            continue;
+        }
+
+        clip->last_used = ++use_clock;
+        if (clip->is_loaded) {
+            clip->is_pinned = true;
+        } else if (ret == 0) {
+            ret = -ENOENT;
+        }
+    }
+    evict_clips(nullptr);
+
+    free((void*)queue.clips);
+    free(queue.results);
+    free(queue.decoded);
+
+    return ret;
+}
+
+const struct atlas* anim_cache_use(struct anim_clip* clip) {
+    if (!clip || clip->is_missing) {
+        return nullptr;
+    }
+
+    clip->last_used = ++use_clock;
+    if (!clip->is_loaded) {
+        // Clips that were not preloaded are decoded inside the frame.
+        PROFILE_BEGIN("anim_cache_load");
+        int ret = load_clip(clip);
+        PROFILE_END("anim_cache_load");
+        if (ret != 0) {
+            return nullptr;
+        }
+        evict_clips(clip);
+    }
+
+    return &clip->atlas;
+}
+
+size_t anim_cache_get_resident_bytes(void) {
+    return resident_bytes;
+}
+
+size_t anim_cache_get_loaded_count(void) {
+    return loaded_count;
+}
+
+static int load_clip(struct anim_clip* clip) {
+    if (clip->is_missing) {
+        return -ENOENT;
+    }
+
+    return upload_clip(clip, decode_clip(clip));
+}
+
+static int decode_clip(struct anim_clip* clip) {
+    (void)atlas_init(&clip->atlas, 0);
+
+    int ret = load_frames(&clip->atlas, clip->path);
+    if (ret == 0) {
+        ret = atlas_pack(&clip->atlas);
+    }
+
+    return ret;
+}
+
+static int upload_clip(struct anim_clip* clip, int decode_result) {
+    int ret = decode_result;
+    if (ret == 0) {
+        PROFILE_BEGIN("anim_upload");
+        ret = atlas_upload(&clip->atlas);
+        PROFILE_END("anim_upload");
+    }
+
+    if (ret != 0) {
+        TraceLog(LOG_WARNING, "ANIM_CACHE: Failed to load clip: %s",
+                 clip->path);
+        atlas_destroy(&clip->atlas);
+        clip->is_missing = true;
+        return ret;
+    }
+
+    clip->frame_count = clip->atlas.frame_count;
+    clip->texture_bytes = atlas_get_texture_bytes(&clip->atlas);
+    clip->is_loaded = true;
+    resident_bytes += clip->texture_bytes;
+    loaded_count++;
+
+    return 0;
+}
+
+static size_t get_worker_count(size_t clip_count) {
+#ifdef _WIN32
+    long cores = pthread_num_processors_np();
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    size_t count = cores > 0 ? (size_t)cores : 1;
+
+    count = count < clip_count ? count : clip_count;
+    return count < MAX_DECODE_WORKERS ? count : MAX_DECODE_WORKERS;
+}
+
+static void load_clips_parallel(struct decode_queue* queue) {
+    pthread_mutex_init(&queue->lock, nullptr);
+    pthread_cond_init(&queue->clip_decoded, nullptr);
+
+    // A single clip is decoded right here; spawning a thread would only add
+    // latency.
+    pthread_t workers[MAX_DECODE_WORKERS];
+    size_t worker_count = queue->count > 1 ? get_worker_count(queue->count) : 0;
+    size_t started = 0;
+    while (started < worker_count &&
+           pthread_create(&workers[started], nullptr, decode_worker, queue) ==
+               0) {
+        started++;
+    }
+
+    if (started == 0) {
+        (void)decode_worker(queue);
+    }
+
+    // Textures can only be created on this thread, so it uploads clips in the
+    // order the workers finish them while the rest are still being decoded.
+    for (size_t uploaded = 0; uploaded < queue->count; uploaded++) {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->decoded_count <= uploaded) {
+            pthread_cond_wait(&queue->clip_decoded, &queue->lock);
+        }
+        size_t index = queue->decoded[uploaded];
+        pthread_mutex_unlock(&queue->lock);
+
+        queue->results[index] =
+            upload_clip(queue->clips[index], queue->results[index]);
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(workers[i], nullptr);
+    }
+
+    pthread_cond_destroy(&queue->clip_decoded);
+    pthread_mutex_destroy(&queue->lock);
+}
+
+static void* decode_worker(void* arg) {
+    struct decode_queue* queue = arg;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->next_clip < queue->count) {
+        size_t index = queue->next_clip++;
+        pthread_mutex_unlock(&queue->lock);
+
+        int ret = decode_clip(queue->clips[index]);
+
+        pthread_mutex_lock(&queue->lock);
+        queue->results[index] = ret;
+        queue->decoded[queue->decoded_count++] = index;
+        pthread_cond_signal(&queue->clip_decoded);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return nullptr;
+}
+
+static void unload_clip(struct anim_clip* clip) {
+    atlas_destroy(&clip->atlas);
+    resident_bytes -= clip->texture_bytes;
+    loaded_count--;
+    clip->texture_bytes = 0;
+    clip->is_loaded = false;
+}
+
+static void free_clip(struct anim_clip* clip) {
+    if (clip->is_loaded) {
+        unload_clip(clip);
+    }
+    free(clip->path);
+    free(clip);
+}
+
+static void evict_clips(const struct anim_clip* keep) {
+    while (resident_bytes > budget) {
+        struct anim_clip* oldest = nullptr;
+        for (size_t i = 0; i < vector_len(&clips); i++) {
+            struct anim_clip* clip = vector_get(&clips, i);
+            if (!clip->is_loaded || clip->is_pinned || clip == keep) {
+                continue;
+            }
+            if (!oldest || clip->last_used < oldest->last_used) {
+                oldest = clip;
+            }
+        }
+
+        if (!oldest) {
+            return;
+        }
+
+        unload_clip(oldest);
+    }
+}
+
+static int load_frames(struct atlas* atlas, const char* path) {
+    if (has_extension(path, ".anim")) {
+        return load_converted(atlas, path);
+    }
+
+    char converted_path[CONVERTED_PATH_SIZE];
+    if (get_converted_path(path, converted_path, sizeof(converted_path)) ==
+            0 &&
+        load_converted(atlas, converted_path) == 0) {
+        return 0;
+    }
+
+    // A converted file that failed halfway may have left frames behind.
+    atlas_destroy(atlas);
+    (void)atlas_init(atlas, 0);
+
+    TraceLog(LOG_INFO, "ANIM_CACHE: No converted animation, decoding GIF: %s",
+             path);
+    return load_gif(atlas, path);
+}
+
+// raylib's file name helpers share static buffers, so clips decoded on
+// worker threads check their extension here instead.
+static bool has_extension(const char* path, const char* extension) {
+    const char* dot = strrchr(path, '.');
+    return dot && strcmp(dot, extension) == 0;
+}
+
+static int get_converted_path(const char* path, char* buffer, size_t size) {
+    size_t prefix_len = strlen(ANIM_SOURCE_DIR);
+    if (strncmp(path, ANIM_SOURCE_DIR, prefix_len) != 0) {
+        return -EINVAL;
+    }
+
+    const char* relative = path + prefix_len;
+    const char* extension = strrchr(relative, '.');
+    int stem_len =
+        (int)(extension ? (size_t)(extension - relative) : strlen(relative));
+
+    int written = snprintf(buffer, size, "%s%.*s.anim", ANIM_CONVERTED_DIR,
+                           stem_len, relative);
+    if (written < 0 || (size_t)written >= size) {
+        return -ENAMETOOLONG;
+    }
+
+    return 0;
+}
+
+static int load_converted(struct atlas* atlas, const char* path) {
+    struct anim_file file;
+    int ret = anim_file_open(&file, path);
+    if (ret != 0) {
+        return ret;
+    }
+
+    int frame_count = (int)file.header->frame_count;
+    for (int i = 0; i < frame_count && ret == 0; i++) {
+        const struct anim_file_frame* frame = &file.frames[i];
+        Rectangle bounds = {(float)frame->x, (float)frame->y,
+                            (float)frame->width, (float)frame->height};
+
+        ret = atlas_add_trimmed(atlas, (int)file.header->canvas_width,
+                                (int)file.header->canvas_height, bounds,
+                                anim_file_get_pixels(&file, i), nullptr);
+    }
+
+    anim_file_close(&file);
+    return ret;
+}
+
+static int load_gif(struct atlas* atlas, const char* path) {
+    int data_size = 0;
+    unsigned char* data = LoadFileData(path, &data_size);
+    if (!data) {
+        return -ENOENT;
+    }
+
+    // LoadImageAnim() would look at the extension through raylib's shared
+    // text buffers as well; decoding from memory stays off them.
+    int frame_count = 0;
+    Image gif_anim =
+        LoadImageAnimFromMemory(".gif", data, data_size, &frame_count);
+    UnloadFileData(data);
+    if (!gif_anim.data) {
+        return -ENOENT;
+    }
+
+    int ret = atlas_add_frames(atlas, gif_anim, frame_count, nullptr);
+    UnloadImage(gif_anim);
+
+    return ret;
+}
@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/anim_file.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "raylib.h"
+
+#include "game/atlas.h"
+
+static_assert(sizeof(struct anim_file_header) == 24,
+              "anim_file_header must not contain padding");
+static_assert(sizeof(struct anim_file_frame) == 24,
+              "anim_file_frame must not contain padding");
+
+static int map_file(struct anim_file* file, const char* path);
+static bool is_valid(const struct anim_file* file);
+static int write_frames(FILE* out,
+                        Image image,
+                        int frame_count,
+                        const struct anim_file_frame* frames);
+
+int anim_file_open(struct anim_file* file, const char* path) {
+    memset(file, 0, sizeof(*file));
+
+    int ret = map_file(file, path);
+    if (ret != 0) {
+        return ret;
+    }
+
+    file->header = (const struct anim_file_header*)file->data;
+    file->frames = (const struct anim_file_frame*)(file->header + 1);
+
+    if (!is_valid(file)) {
+        TraceLog(LOG_WARNING, "ANIM_FILE: Invalid or outdated file: %s",
+                 path);
+        anim_file_close(file);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+const Color* anim_file_get_pixels(const struct anim_file* file, int frame) {
+    if (frame < 0 || (uint32_t)frame >= file->header->frame_count) {
+        return nullptr;
+    }
+
+    const struct anim_file_frame* entry = &file->frames[frame];
+    if (entry->width == 0 || entry->height == 0) {
+        return nullptr;
+    }
+
+    return (const Color*)(file->data + entry->data_offset);
+}
+
+void anim_file_close(struct anim_file* file) {
+    if (file->data) {
+#ifndef _WIN32
+        munmap((void*)file->data, file->size);
+#else
+        UnloadFileData((unsigned char*)file->data);
+#endif
+    }
+
+    memset(file, 0, sizeof(*file));
+}
+
+int anim_file_write(const char* path,
+                    Image image,
+                    int frame_count,
+                    const int* delays_ms) {
+    if (!image.data || frame_count <= 0 || image.width <= 0 ||
+        image.height <= 0 || image.width > UINT16_MAX ||
+        image.height > UINT16_MAX ||
+        image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        return -EINVAL;
+    }
+
+    struct anim_file_frame* frames =
+        calloc(frame_count, sizeof(struct anim_file_frame));
+    if (!frames) {
+        return -ENOMEM;
+    }
+
+    size_t frame_pixels = (size_t)image.width * image.height;
+    uint64_t offset = sizeof(struct anim_file_header) +
+                      (frame_count * sizeof(struct anim_file_frame));
+
+    for (int i = 0; i < frame_count; i++) {
+        const Color* canvas = (const Color*)image.data + (i * frame_pixels);
+        Rectangle bounds =
+            atlas_trim_bounds(canvas, image.width, image.height);
+
+        frames[i] = (struct anim_file_frame){
+            .x = (uint16_t)bounds.x,
+            .y = (uint16_t)bounds.y,
+            .width = (uint16_t)bounds.width,
+            .height = (uint16_t)bounds.height,
+            .delay_ms = delays_ms ? (uint32_t)delays_ms[i] : 0,
+            .data_offset = offset,
+        };
+        offset += (uint64_t)frames[i].width * frames[i].height * sizeof(Color);
+    }
+
+    struct anim_file_header header = {
+        .version = ANIM_FILE_VERSION,
+        .canvas_width = (uint32_t)image.width,
+        .canvas_height = (uint32_t)image.height,
+        .frame_count = (uint32_t)frame_count,
+    };
+    memcpy(header.magic, ANIM_FILE_MAGIC, sizeof(header.magic));
+
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        free(frames);
+        return -EIO;
+    }
+
+    int ret = 0;
+    if (fwrite(&header, sizeof(header), 1, out) != 1 ||
+        fwrite(frames, sizeof(struct anim_file_frame), frame_count, out) !=
+            (size_t)frame_count ||
+        write_frames(out, image, frame_count, frames) != 0) {
+        ret = -EIO;
+    }
+
+    if (fclose(out) != 0) {
+        ret = -EIO;
+    }
+    free(frames);
+
+    if (ret != 0) {
+        (void)remove(path);
+    }
+
+    return ret;
+}
+
+static int map_file(struct anim_file* file, const char* path) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -ENOENT;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return -ENOENT;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+                      fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -ENOENT;
+    }
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    file->is_mapped = true;
+#else
+    if (!FileExists(path)) {
+        return -ENOENT;
+    }
+
+    int size = 0;
+    unsigned char* data = LoadFileData(path, &size);
+    if (!data || size <= 0) {
+        UnloadFileData(data);
+        return -ENOENT;
+    }
+
+    file->data = data;
+    file->size = (size_t)size;
+    file->is_mapped = false;
+#endif
+
+    return 0;
+}
+
+static bool is_valid(const struct anim_file* file) {
+    const struct anim_file_header* header = file->header;
+    if (file->size < sizeof(*header) ||
+        memcmp(header->magic, ANIM_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ANIM_FILE_VERSION || header->canvas_width == 0 ||
+        header->canvas_height == 0) {
+        return false;
+    }
+
+    size_t table_capacity =
+        (file->size - sizeof(*header)) / sizeof(struct anim_file_frame);
+    if (header->frame_count == 0 || header->frame_count > table_capacity) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header->frame_count; i++) {
+        const struct anim_file_frame* frame = &file->frames[i];
+        if ((uint32_t)frame->x + frame->width > header->canvas_width ||
+            (uint32_t)frame->y + frame->height > header->canvas_height) {
+            return false;
+        }
+
+        uint64_t bytes = (uint64_t)frame->width * frame->height * sizeof(Color);
+        if (bytes > 0 && (frame->data_offset > file->size ||
+                          bytes > file->size - frame->data_offset)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int write_frames(FILE* out,
+                        Image image,
+                        int frame_count,
+                        const struct anim_file_frame* frames) {
+    size_t frame_pixels = (size_t)image.width * image.height;
+
+    for (int i = 0; i < frame_count; i++) {
+        const Color* canvas = (const Color*)image.data + (i * frame_pixels);
+        const struct anim_file_frame* frame = &frames[i];
+
+        for (int y = 0; y < frame->height; y++) {
+            const Color* row =
+                canvas + (((size_t)frame->y + y) * image.width) + frame->x;
+            if (fwrite(row, sizeof(Color), frame->width, out) !=
+                frame->width) {
+                return -EIO;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,770 @@
+#include "game/atlas.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+
+enum {
+    INITIAL_FRAME_CAPACITY = 64,
+    PALETTE_TABLE_BITS = 10,
+    PALETTE_TABLE_SIZE = 1 << PALETTE_TABLE_BITS,
+};
+
+/**
+ * The colors of an indexed atlas and a hash table from color to slot. Slot 0
+ * is transparent black, which is also what the gaps between frames are
+ * cleared to. Every fully transparent pixel uses it: blending ignores the
+ * color of such pixels, so merging them does not change what is drawn.
+ */
+struct palette {
+    uint32_t keys[PALETTE_TABLE_SIZE];
+    uint8_t slots[PALETTE_TABLE_SIZE];
+    Color colors[ATLAS_PALETTE_SIZE];
+    int count;
+};
+
+/** A frame waiting to be placed, ordered by size for shelf packing. */
+struct placement {
+    int frame;
+    int width;
+    int height;
+};
+
+static int reserve_frames(struct atlas* atlas, int count);
+static int add_frame(struct atlas* atlas,
+                     int canvas_width,
+                     int canvas_height,
+                     Rectangle bounds,
+                     const Color* pixels,
+                     int stride,
+                     int* index);
+static uint64_t hash_pixels(const Color* pixels,
+                            int width,
+                            int height,
+                            int stride);
+static int find_duplicate(struct atlas* atlas,
+                          const Color* pixels,
+                          int width,
+                          int height,
+                          int stride);
+static int compare_placements(const void* lhs, const void* rhs);
+static int place_frames(struct atlas* atlas,
+                        int* page_width,
+                        int* page_height);
+static int build_palette(const struct atlas* atlas, struct palette* palette);
+static size_t find_bucket(const struct palette* palette, uint32_t key);
+static uint8_t find_slot(const struct palette* palette, Color color);
+static int compose_page(struct atlas* atlas,
+                        int page,
+                        int width,
+                        int height,
+                        const struct palette* palette);
+static int pack_palette(struct atlas* atlas, const struct palette* palette);
+static int expand_page(Image* page, const Color* colors);
+static void free_pixels(struct atlas* atlas);
+static void free_packed_pages(struct atlas* atlas);
+
+int atlas_init(struct atlas* atlas, int page_size) {
+    if (page_size < 0) {
+        return -EINVAL;
+    }
+
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->page_size = page_size > 0 ? page_size : ATLAS_DEFAULT_PAGE_SIZE;
+
+    return 0;
+}
+
+int atlas_add_frames(struct atlas* atlas,
+                     Image image,
+                     int frame_count,
+                     int* first_frame) {
+    if (!image.data || frame_count <= 0 ||
+        image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        return -EINVAL;
+    }
+
+    int first = atlas->frame_count;
+    size_t frame_pixels = (size_t)image.width * (size_t)image.height;
+
+    for (int i = 0; i < frame_count; i++) {
+        const Color* canvas = (const Color*)image.data + (i * frame_pixels);
+        Rectangle bounds =
+            atlas_trim_bounds(canvas, image.width, image.height);
+        const Color* pixels =
+            canvas + (((size_t)bounds.y * image.width) + (size_t)bounds.x);
+
+        int ret = add_frame(atlas, image.width, image.height, bounds, pixels,
+                            image.width, nullptr);
+        if (ret != 0) {
+            for (int j = first; j < atlas->frame_count; j++) {
+                free(atlas->pixels[j]);
+                atlas->pixels[j] = nullptr;
+            }
+            atlas->frame_count = first;
+            return ret;
+        }
+    }
+
+    if (first_frame) {
+        *first_frame = first;
+    }
+
+    return 0;
+}
+
+int atlas_add_trimmed(struct atlas* atlas,
+                      int canvas_width,
+                      int canvas_height,
+                      Rectangle bounds,
+                      const Color* pixels,
+                      int* frame) {
+    return add_frame(atlas, canvas_width, canvas_height, bounds, pixels,
+                     (int)bounds.width, frame);
+}
+
+Rectangle atlas_trim_bounds(const Color* pixels, int width, int height) {
+    int min_x = width;
+    int min_y = height;
+    int max_x = -1;
+    int max_y = -1;
+
+    for (int y = 0; y < height; y++) {
+        const Color* row = pixels + ((size_t)y * width);
+        for (int x = 0; x < width; x++) {
+            if (row[x].a == 0) {
+                continue;
+            }
+            min_x = x < min_x ? x : min_x;
+            max_x = x > max_x ? x : max_x;
+            min_y = y < min_y ? y : min_y;
+            max_y = y;
+        }
+    }
+
+    if (max_x < 0) {
+        return (Rectangle){0};
+    }
+
+    return (Rectangle){(float)min_x, (float)min_y, (float)(max_x - min_x + 1),
+                       (float)(max_y - min_y + 1)};
+}
+
+int atlas_pack(struct atlas* atlas) {
+    if (atlas->is_packed) {
+        return -EBUSY;
+    }
+
+    int page_width[ATLAS_MAX_PAGES] = {0};
+    int page_height[ATLAS_MAX_PAGES] = {0};
+    int ret = place_frames(atlas, page_width, page_height);
+    if (ret != 0) {
+        return ret;
+    }
+
+    struct palette* palette = malloc(sizeof(struct palette));
+    if (!palette) {
+        return -ENOMEM;
+    }
+    bool is_indexed = page_width[0] > 0 && build_palette(atlas, palette) == 0;
+
+    for (int page = 0; page < ATLAS_MAX_PAGES && page_width[page] > 0;
+         page++) {
+        ret = compose_page(atlas, page, page_width[page], page_height[page],
+                           is_indexed ? palette : nullptr);
+        if (ret != 0) {
+            break;
+        }
+    }
+
+    if (ret == 0 && is_indexed) {
+        ret = pack_palette(atlas, palette);
+    }
+    free(palette);
+
+    if (ret != 0) {
+        free_packed_pages(atlas);
+        return ret;
+    }
+
+    free_pixels(atlas);
+    atlas->is_indexed = is_indexed;
+    atlas->is_packed = true;
+
+    return 0;
+}
+
+int atlas_upload(struct atlas* atlas) {
+    if (!atlas->is_packed) {
+        return -EINVAL;
+    }
+    if (atlas->is_built) {
+        return -EBUSY;
+    }
+
+    if (atlas->is_indexed && !sprite_batch_has_palette_shader()) {
+        for (int page = 0; page < ATLAS_MAX_PAGES; page++) {
+            if (!atlas->packed_pages[page].data) {
+                break;
+            }
+            int ret = expand_page(&atlas->packed_pages[page],
+                                  atlas->packed_palette.data);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        atlas->is_indexed = false;
+    }
+
+    for (int page = 0; page < ATLAS_MAX_PAGES; page++) {
+        if (!atlas->packed_pages[page].data) {
+            break;
+        }
+        atlas->pages[page] = LoadTextureFromImage(atlas->packed_pages[page]);
+        atlas->page_count++;
+    }
+    if (atlas->is_indexed) {
+        atlas->palette = LoadTextureFromImage(atlas->packed_palette);
+    }
+
+    free_packed_pages(atlas);
+    atlas->is_built = true;
+
+    return 0;
+}
+
+int atlas_build(struct atlas* atlas) {
+    if (atlas->is_built) {
+        return -EBUSY;
+    }
+
+    if (!atlas->is_packed) {
+        int ret = atlas_pack(atlas);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return atlas_upload(atlas);
+}
+
+bool atlas_get_sprite(const struct atlas* atlas,
+                      int frame,
+                      Vector3 position,
+                      float size,
+                      Color tint,
+                      struct sprite* sprite) {
+    if (frame < 0 || frame >= atlas->frame_count || !atlas->is_built) {
+        return false;
+    }
+
+    const struct atlas_frame* placed = &atlas->frames[frame];
+    if (placed->page < 0) {
+        return false;
+    }
+
+    // A sprite's bottom-left corner sits at position - origin, with origin.y
+    // pointing up. Measuring it from the trimmed frame to the canvas center
+    // keeps the frame where it was drawn on the untrimmed canvas.
+    float scale = size / (float)atlas->canvas_height;
+    *sprite = (struct sprite){
+        .texture = atlas->pages[placed->page],
+        .palette = atlas->is_indexed ? atlas->palette : (Texture2D){0},
+        .source = placed->source,
+        .position = position,
+        .size = {placed->source.width * scale,
+                 placed->source.height * scale},
+        .origin = {((0.5F * (float)atlas->canvas_width) - placed->offset.x) *
+                       scale,
+                   (placed->offset.y + placed->source.height -
+                    (0.5F * (float)atlas->canvas_height)) *
+                       scale},
+        .tint = tint,
+    };
+
+    return true;
+}
+
+size_t atlas_get_texture_bytes(const struct atlas* atlas) {
+    size_t bytes = 0;
+    for (int i = 0; i < atlas->page_count; i++) {
+        const Texture2D* page = &atlas->pages[i];
+        bytes += (size_t)GetPixelDataSize(page->width, page->height,
+                                          page->format);
+    }
+
+    if (atlas->is_built && atlas->is_indexed) {
+        bytes += (size_t)ATLAS_PALETTE_SIZE * sizeof(Color);
+    }
+
+    return bytes;
+}
+
+void atlas_destroy(struct atlas* atlas) {
+    for (int i = 0; i < atlas->page_count; i++) {
+        UnloadTexture(atlas->pages[i]);
+    }
+
+    if (atlas->is_built && atlas->is_indexed) {
+        UnloadTexture(atlas->palette);
+    }
+
+    free_pixels(atlas);
+    free_packed_pages(atlas);
+    free((void*)atlas->pixels);
+    free(atlas->hashes);
+    free(atlas->originals);
+    free(atlas->frames);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+static int reserve_frames(struct atlas* atlas, int count) {
+    if (count <= atlas->frame_capacity) {
+        return 0;
+    }
+
+    int capacity = atlas->frame_capacity > 0 ? atlas->frame_capacity
+                                             : INITIAL_FRAME_CAPACITY;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    struct atlas_frame* frames =
+        realloc(atlas->frames, capacity * sizeof(struct atlas_frame));
+    if (!frames) {
+        return -ENOMEM;
+    }
+    atlas->frames = frames;
+
+    Color** pixels = realloc((void*)atlas->pixels, capacity * sizeof(Color*));
+    if (!pixels) {
+        return -ENOMEM;
+    }
+    atlas->pixels = pixels;
+
+    uint64_t* hashes = realloc(atlas->hashes, capacity * sizeof(uint64_t));
+    if (!hashes) {
+        return -ENOMEM;
+    }
+    atlas->hashes = hashes;
+
+    int* originals = realloc(atlas->originals, capacity * sizeof(int));
+    if (!originals) {
+        return -ENOMEM;
+    }
+    atlas->originals = originals;
+
+    atlas->frame_capacity = capacity;
+    return 0;
+}
+
+static int add_frame(struct atlas* atlas,
+                     int canvas_width,
+                     int canvas_height,
+                     Rectangle bounds,
+                     const Color* pixels,
+                     int stride,
+                     int* index) {
+    if (atlas->is_packed) {
+        return -EBUSY;
+    }
+
+    if (canvas_width <= 0 || canvas_height <= 0 || bounds.x < 0.0F ||
+        bounds.y < 0.0F || bounds.width < 0.0F || bounds.height < 0.0F ||
+        bounds.x + bounds.width > (float)canvas_width ||
+        bounds.y + bounds.height > (float)canvas_height) {
+        return -EINVAL;
+    }
+
+    if (atlas->frame_count == 0) {
+        atlas->canvas_width = canvas_width;
+        atlas->canvas_height = canvas_height;
+    } else if (canvas_width != atlas->canvas_width ||
+               canvas_height != atlas->canvas_height) {
+        return -EINVAL;
+    }
+
+    if (reserve_frames(atlas, atlas->frame_count + 1) != 0) {
+        return -ENOMEM;
+    }
+
+    int width = (int)bounds.width;
+    int height = (int)bounds.height;
+    int next = atlas->frame_count;
+    Color* copy = nullptr;
+    int original = -1;
+
+    if (width > 0 && height > 0) {
+        if (!pixels) {
+            return -EINVAL;
+        }
+
+        original = find_duplicate(atlas, pixels, width, height, stride);
+    }
+
+    // Duplicates keep no pixels of their own; they are placed where their
+    // original is.
+    if (width > 0 && height > 0 && original < 0) {
+        copy = malloc((size_t)width * height * sizeof(Color));
+        if (!copy) {
+            return -ENOMEM;
+        }
+
+        for (int y = 0; y < height; y++) {
+            memcpy(copy + ((size_t)y * width), pixels + ((size_t)y * stride),
+                   width * sizeof(Color));
+        }
+    }
+
+    struct atlas_frame* frame = &atlas->frames[next];
+    frame->page = -1;
+    frame->source = (Rectangle){0.0F, 0.0F, (float)width, (float)height};
+    frame->offset = (Vector2){bounds.x, bounds.y};
+    atlas->pixels[next] = copy;
+    atlas->hashes[next] = 0;
+    atlas->originals[next] = original >= 0 ? original : next;
+
+    if (index) {
+        *index = next;
+    }
+    atlas->frame_count++;
+
+    return 0;
+}
+
+static uint64_t hash_pixels(const Color* pixels,
+                            int width,
+                            int height,
+                            int stride) {
+    // FNV-1a over whole pixels. Matching hashes are confirmed by comparing
+    // the pixels, so collisions only cost a comparison.
+    uint64_t hash = 14695981039346656037ULL;
+    hash = (hash ^ (uint64_t)width) * 1099511628211ULL;
+    hash = (hash ^ (uint64_t)height) * 1099511628211ULL;
+
+    for (int y = 0; y < height; y++) {
+        const Color* row = pixels + ((size_t)y * stride);
+        for (int x = 0; x < width; x++) {
+            uint32_t value = 0;
+            memcpy(&value, &row[x], sizeof(value));
+            hash = (hash ^ value) * 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+static int find_duplicate(struct atlas* atlas,
+                          const Color* pixels,
+                          int width,
+                          int height,
+                          int stride) {
+    // Only frames of the same trimmed size can match, and most frames have
+    // none, so hashes are computed the first time they are needed.
+    uint64_t hash = 0;
+
+    for (int i = 0; i < atlas->frame_count; i++) {
+        const Color* candidate = atlas->pixels[i];
+        if (!candidate || (int)atlas->frames[i].source.width != width ||
+            (int)atlas->frames[i].source.height != height) {
+            continue;
+        }
+
+        if (hash == 0) {
+            hash = hash_pixels(pixels, width, height, stride);
+        }
+        if (atlas->hashes[i] == 0) {
+            atlas->hashes[i] = hash_pixels(candidate, width, height, width);
+        }
+        if (atlas->hashes[i] != hash) {
+            continue;
+        }
+
+        bool is_equal = true;
+        for (int y = 0; y < height && is_equal; y++) {
+            is_equal = memcmp(candidate + ((size_t)y * width),
+                              pixels + ((size_t)y * stride),
+                              width * sizeof(Color)) == 0;
+        }
+        if (is_equal) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int compare_placements(const void* lhs, const void* rhs) {
+    const struct placement* a = lhs;
+    const struct placement* b = rhs;
+
+    if (a->height != b->height) {
+        return b->height - a->height;
+    }
+    if (a->width != b->width) {
+        return b->width - a->width;
+    }
+    return a->frame - b->frame;
+}
+
+static int place_frames(struct atlas* atlas,
+                        int* page_width,
+                        int* page_height) {
+    struct placement* order =
+        malloc((atlas->frame_count + 1) * sizeof(struct placement));
+    if (!order) {
+        return -ENOMEM;
+    }
+
+    int count = 0;
+    int widest = 0;
+    double area = 0.0;
+    for (int i = 0; i < atlas->frame_count; i++) {
+        if (!atlas->pixels[i]) {
+            continue;
+        }
+        struct placement* next = &order[count++];
+        *next = (struct placement){
+            .frame = i,
+            .width = (int)atlas->frames[i].source.width,
+            .height = (int)atlas->frames[i].source.height,
+        };
+        widest = next->width > widest ? next->width : widest;
+        area += (double)next->width * next->height;
+    }
+    qsort(order, count, sizeof(struct placement), compare_placements);
+
+    // Shelves only as wide as a square holding every frame keep the last,
+    // partly filled shelf short, so small atlases do not waste a page width.
+    int shelf_width = (int)ceil(sqrt(area));
+    shelf_width = shelf_width < widest ? widest : shelf_width;
+    shelf_width =
+        shelf_width > atlas->page_size ? atlas->page_size : shelf_width;
+
+    int page = 0;
+    int x = 0;
+    int y = 0;
+    int shelf_height = 0;
+
+    for (int i = 0; i < count; i++) {
+        const struct placement* next = &order[i];
+        if (next->width > atlas->page_size ||
+            next->height > atlas->page_size) {
+            free(order);
+            return -ENOSPC;
+        }
+
+        if (x + next->width > shelf_width) {
+            y += shelf_height + ATLAS_PADDING;
+            x = 0;
+            shelf_height = 0;
+        }
+
+        if (y + next->height > atlas->page_size) {
+            page++;
+            x = 0;
+            y = 0;
+            shelf_height = 0;
+        }
+
+        if (page >= ATLAS_MAX_PAGES) {
+            free(order);
+            return -ENOSPC;
+        }
+
+        struct atlas_frame* frame = &atlas->frames[next->frame];
+        frame->page = page;
+        frame->source.x = (float)x;
+        frame->source.y = (float)y;
+
+        x += next->width;
+        shelf_height =
+            next->height > shelf_height ? next->height : shelf_height;
+        if (x > page_width[page]) {
+            page_width[page] = x;
+        }
+        if (y + shelf_height > page_height[page]) {
+            page_height[page] = y + shelf_height;
+        }
+        x += ATLAS_PADDING;
+    }
+
+    for (int i = 0; i < atlas->frame_count; i++) {
+        const struct atlas_frame* original =
+            &atlas->frames[atlas->originals[i]];
+        atlas->frames[i].page = original->page;
+        atlas->frames[i].source = original->source;
+    }
+
+    free(order);
+    return 0;
+}
+
+static int build_palette(const struct atlas* atlas, struct palette* palette) {
+    memset(palette, 0, sizeof(*palette));
+    palette->count = 1;
+
+    uint32_t previous = 0;
+    for (int i = 0; i < atlas->frame_count; i++) {
+        const Color* pixels = atlas->pixels[i];
+        size_t pixel_count = (size_t)atlas->frames[i].source.width *
+                             (size_t)atlas->frames[i].source.height;
+
+        for (size_t p = 0; p < pixel_count && pixels; p++) {
+            uint32_t key = 0;
+            if (pixels[p].a != 0) {
+                memcpy(&key, &pixels[p], sizeof(key));
+            }
+            // Sprites have long runs of one color, mostly transparent.
+            if (key == previous) {
+                continue;
+            }
+            previous = key;
+
+            size_t bucket = find_bucket(palette, key);
+            if (palette->keys[bucket] == key) {
+                continue;
+            }
+            if (palette->count == ATLAS_PALETTE_SIZE) {
+                return -ENOSPC;
+            }
+
+            palette->keys[bucket] = key;
+            palette->slots[bucket] = (uint8_t)palette->count;
+            palette->colors[palette->count++] = pixels[p];
+        }
+    }
+
+    return 0;
+}
+
+static size_t find_bucket(const struct palette* palette, uint32_t key) {
+    // Key 0 is transparent black, which marks empty buckets; it never needs
+    // one because it always maps to slot 0.
+    size_t bucket = (size_t)((key * 2654435761U) >> (32 - PALETTE_TABLE_BITS));
+    while (palette->keys[bucket] != 0 && palette->keys[bucket] != key) {
+        bucket = (bucket + 1) & (PALETTE_TABLE_SIZE - 1);
+    }
+
+    return bucket;
+}
+
+static uint8_t find_slot(const struct palette* palette, Color color) {
+    if (color.a == 0) {
+        return 0;
+    }
+
+    uint32_t key = 0;
+    memcpy(&key, &color, sizeof(key));
+    return palette->slots[find_bucket(palette, key)];
+}
+
+static int compose_page(struct atlas* atlas,
+                        int page,
+                        int width,
+                        int height,
+                        const struct palette* palette) {
+    size_t pixel_size = palette ? 1 : sizeof(Color);
+    unsigned char* canvas = calloc((size_t)width * height, pixel_size);
+    if (!canvas) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < atlas->frame_count; i++) {
+        const struct atlas_frame* frame = &atlas->frames[i];
+        if (frame->page != page || !atlas->pixels[i]) {
+            continue;
+        }
+
+        int frame_width = (int)frame->source.width;
+        for (int y = 0; y < (int)frame->source.height; y++) {
+            const Color* source = atlas->pixels[i] + ((size_t)y * frame_width);
+            size_t offset = (((size_t)frame->source.y + y) * width) +
+                            (size_t)frame->source.x;
+
+            if (!palette) {
+                memcpy(canvas + (offset * pixel_size), source,
+                       frame_width * sizeof(Color));
+                continue;
+            }
+            Color run_color = {0};
+            uint8_t run_slot = 0;
+            for (int x = 0; x < frame_width; x++) {
+                if (memcmp(&source[x], &run_color, sizeof(Color)) != 0) {
+                    run_color = source[x];
+                    run_slot = find_slot(palette, run_color);
+                }
+                canvas[offset + x] = run_slot;
+            }
+        }
+    }
+
+    atlas->packed_pages[page] = (Image){
+        .data = canvas,
+        .width = width,
+        .height = height,
+        .mipmaps = 1,
+        .format = palette ? PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+                          : PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+
+    return 0;
+}
+
+static int pack_palette(struct atlas* atlas, const struct palette* palette) {
+    Color* colors = calloc(ATLAS_PALETTE_SIZE, sizeof(Color));
+    if (!colors) {
+        return -ENOMEM;
+    }
+    memcpy(colors, palette->colors, palette->count * sizeof(Color));
+
+    atlas->packed_palette = (Image){
+        .data = colors,
+        .width = ATLAS_PALETTE_SIZE,
+        .height = 1,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+
+    return 0;
+}
+
+static int expand_page(Image* page, const Color* colors) {
+    size_t pixel_count = (size_t)page->width * page->height;
+    Color* expanded = malloc(pixel_count * sizeof(Color));
+    if (!expanded) {
+        return -ENOMEM;
+    }
+
+    const uint8_t* slots = page->data;
+    for (size_t i = 0; i < pixel_count; i++) {
+        expanded[i] = colors[slots[i]];
+    }
+
+    free(page->data);
+    page->data = expanded;
+    page->format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    return 0;
+}
+
+static void free_pixels(struct atlas* atlas) {
+    for (int i = 0; i < atlas->frame_count; i++) {
+        free(atlas->pixels[i]);
+        atlas->pixels[i] = nullptr;
+    }
+}
+
+static void free_packed_pages(struct atlas* atlas) {
+    for (int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        free(atlas->packed_pages[i].data);
+        atlas->packed_pages[i] = (Image){0};
+    }
+
+    free(atlas->packed_palette.data);
+    atlas->packed_palette = (Image){0};
+}
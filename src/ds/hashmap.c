@@ -4,42 +4,63 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASHMAP_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * Every slot has a control byte. The high bit is set for empty and deleted
+ * slots; a full slot stores the low 7 bits of its key's hash (H2), so most
+ * mismatches are rejected without touching the entry array.
+ */
+enum {
+    CTRL_EMPTY = 0x80,
+    CTRL_DELETED = 0xFE,
+    GROUP_WIDTH = 16,
+};
 
-static int g_tombstone_marker;
-#define TOMBSTONE ((void*)&g_tombstone_marker)
+static const size_t HASHMAP_INITIAL_CAPACITY = 16;
 
-#define IS_EMPTY(entry) ((entry)->value == nullptr)
+static const size_t HASHMAP_LOAD_FACTOR_NUMERATOR = 7;
+static const size_t HASHMAP_LOAD_FACTOR_DENOMINATOR = 8;
 
-#define IS_TOMBSTONE(entry) ((entry)->value == TOMBSTONE)
+#define HASHMAP_NEEDS_RESIZE(used, capacity)          \
+    (((used) + 1) * HASHMAP_LOAD_FACTOR_DENOMINATOR > \
+     (capacity) * HASHMAP_LOAD_FACTOR_NUMERATOR)
 
-static const size_t HASHMAP_INITIAL_CAPACITY = 16;
+#define IS_FULL(ctrl) (((ctrl) & CTRL_EMPTY) == 0)
 
-static const size_t HASHMAP_LOAD_FACTOR_NUMERATOR = 3;
-static const size_t HASHMAP_LOAD_FACTOR_DENOMINATOR = 4;
+#define H1(hash) ((hash) >> 7U)
+#define H2(hash) ((uint8_t)((hash) & 0x7FU))
 
-#define HASHMAP_NEEDS_RESIZE(len, capacity)          \
-    (((len) + 1) * HASHMAP_LOAD_FACTOR_DENOMINATOR > \
-     (capacity) * HASHMAP_LOAD_FACTOR_NUMERATOR)
+static const size_t NOT_FOUND = SIZE_MAX;
 
-static struct hashmap_entry* find_entry(struct hashmap_entry* entries,
-                                        size_t capacity,
-                                        uint64_t key);
-static uint64_t hash_key(uint64_t key);
+static size_t find_slot(const struct hashmap* map, uint64_t key);
+static size_t find_insert_slot(const struct hashmap* map, uint64_t hash);
+static void set_ctrl(struct hashmap* map, size_t index, uint8_t ctrl);
+static int allocate_slots(struct hashmap* map, size_t capacity);
 static int hashmap_resize(struct hashmap* map, size_t new_capacity);
+static uint32_t group_match(const uint8_t* group, uint8_t ctrl);
+static uint32_t group_match_empty(const uint8_t* group);
+static uint32_t group_match_empty_or_deleted(const uint8_t* group);
+static inline unsigned int lowest_bit(uint32_t mask);
+static inline unsigned int leading_zeros(uint32_t mask);
+static uint64_t hash_key(uint64_t key);
 
 int hashmap_init(struct hashmap* map) {
     if (!map) {
         return -EINVAL;
     }
 
-    map->entries =
-        calloc(HASHMAP_INITIAL_CAPACITY, sizeof(struct hashmap_entry));
-    if (!map->entries) {
+    if (allocate_slots(map, HASHMAP_INITIAL_CAPACITY) != 0) {
         return -ENOMEM;
     }
 
     map->len = 0;
-    map->capacity = HASHMAP_INITIAL_CAPACITY;
     return 0;
 }
 
@@ -51,7 +72,9 @@ void hashmap_destroy(struct hashmap* map) {
     free(map->entries);
 
     map->entries = nullptr;
+    map->ctrl = nullptr;
     map->len = 0;
+    map->deleted = 0;
     map->capacity = 0;
 }
 
@@ -63,26 +86,41 @@ int hashmap_set(struct hashmap* map,
         return -EINVAL;
     }
 
-    if (HASHMAP_NEEDS_RESIZE(map->len, map->capacity)) {
-        size_t new_capacity = map->capacity * 2;
+    size_t index = find_slot(map, key);
+    if (index != NOT_FOUND) {
+        if (old_value) {
+            *old_value = map->entries[index].value;
+        }
+        map->entries[index].value = value;
+        return 0;
+    }
+
+    if (HASHMAP_NEEDS_RESIZE(map->len + map->deleted, map->capacity)) {
+        // Rehashing at the same size is enough to clear out tombstones when
+        // the map is mostly deleted slots.
+        size_t new_capacity = (map->len + 1) * 2 > map->capacity
+                                  ? map->capacity * 2
+                                  : map->capacity;
         if (hashmap_resize(map, new_capacity) != 0) {
             return -ENOMEM;
         }
     }
 
-    struct hashmap_entry* entry = find_entry(map->entries, map->capacity, key);
-    bool is_new_key = IS_EMPTY(entry) || IS_TOMBSTONE(entry);
-
-    if (old_value) {
-        *old_value = (int)is_new_key ? nullptr : entry->value;
+    uint64_t hash = hash_key(key);
+    index = find_insert_slot(map, hash);
+    if (map->ctrl[index] == CTRL_DELETED) {
+        map->deleted--;
     }
 
-    if (is_new_key) {
-        map->len++;
-        entry->key = key;
+    set_ctrl(map, index, H2(hash));
+    map->entries[index].key = key;
+    map->entries[index].value = value;
+    map->len++;
+
+    if (old_value) {
+        *old_value = nullptr;
     }
 
-    entry->value = value;
     return 0;
 }
 
@@ -91,13 +129,8 @@ void* hashmap_get(const struct hashmap* map, uint64_t key) {
         return nullptr;
     }
 
-    const struct hashmap_entry* entry =
-        find_entry(map->entries, map->capacity, key);
-    if (IS_EMPTY(entry) || IS_TOMBSTONE(entry)) {
-        return nullptr;
-    }
-
-    return entry->value;
+    size_t index = find_slot(map, key);
+    return index != NOT_FOUND ? map->entries[index].value : nullptr;
 }
 
 void* hashmap_remove(struct hashmap* map, uint64_t key) {
@@ -105,15 +138,31 @@ void* hashmap_remove(struct hashmap* map, uint64_t key) {
         return nullptr;
     }
 
-    struct hashmap_entry* entry = find_entry(map->entries, map->capacity, key);
-    if (IS_EMPTY(entry) || IS_TOMBSTONE(entry)) {
+    size_t index = find_slot(map, key);
+    if (index == NOT_FOUND) {
         return nullptr;
     }
 
-    void* old_value = entry->value;
-    entry->value = TOMBSTONE;
+    void* old_value = map->entries[index].value;
+    map->entries[index].value = nullptr;
     map->len--;
 
+    // A slot can go straight back to empty if no probe sequence can have
+    // passed over it: that is the case when the run of full or deleted slots
+    // around it is shorter than a group, so every group covering it also
+    // contains an empty slot.
+    size_t mask = map->capacity - 1;
+    uint32_t empty_before =
+        group_match_empty(&map->ctrl[(index - GROUP_WIDTH) & mask]);
+    uint32_t empty_after = group_match_empty(&map->ctrl[index]);
+    if (empty_before != 0 && empty_after != 0 &&
+        leading_zeros(empty_before) + lowest_bit(empty_after) < GROUP_WIDTH) {
+        set_ctrl(map, index, CTRL_EMPTY);
+    } else {
+        set_ctrl(map, index, CTRL_DELETED);
+        map->deleted++;
+    }
+
     return old_value;
 }
 
@@ -134,12 +183,11 @@ bool hashmap_iter(const struct hashmap* map,
     }
 
     while (*iterator < map->capacity) {
-        struct hashmap_entry* entry = &map->entries[*iterator];
-        (*iterator)++;
+        size_t index = (*iterator)++;
 
-        if (!IS_EMPTY(entry) && !IS_TOMBSTONE(entry)) {
-            *key = entry->key;
-            *value = entry->value;
+        if (IS_FULL(map->ctrl[index])) {
+            *key = map->entries[index].key;
+            *value = map->entries[index].value;
             return true;
         }
     }
@@ -148,54 +196,137 @@ bool hashmap_iter(const struct hashmap* map,
 }
 
 static int hashmap_resize(struct hashmap* map, size_t new_capacity) {
-    struct hashmap_entry* new_entries =
-        calloc(new_capacity, sizeof(struct hashmap_entry));
-    if (!new_entries) {
+    struct hashmap old = *map;
+
+    if (allocate_slots(map, new_capacity) != 0) {
+        *map = old;
         return -ENOMEM;
     }
 
-    for (size_t i = 0; i < map->capacity; ++i) {
-        struct hashmap_entry* entry = &map->entries[i];
-        if (!IS_EMPTY(entry) && !IS_TOMBSTONE(entry)) {
-            struct hashmap_entry* dest =
-                find_entry(new_entries, new_capacity, entry->key);
-            dest->key = entry->key;
-            dest->value = entry->value;
+    for (size_t i = 0; i < old.capacity; ++i) {
+        if (IS_FULL(old.ctrl[i])) {
+            uint64_t hash = hash_key(old.entries[i].key);
+            size_t index = find_insert_slot(map, hash);
+            set_ctrl(map, index, H2(hash));
+            map->entries[index] = old.entries[i];
         }
     }
 
-    free(map->entries);
-    map->entries = new_entries;
-    map->capacity = new_capacity;
+    free(old.entries);
+    return 0;
+}
+
+static int allocate_slots(struct hashmap* map, size_t capacity) {
+    // The control bytes live right after the entries. The first group is
+    // mirrored past the end so that a group can be loaded from any slot
+    // without wrapping.
+    size_t entries_size = capacity * sizeof(struct hashmap_entry);
+    unsigned char* block = malloc(entries_size + capacity + GROUP_WIDTH);
+    if (!block) {
+        return -ENOMEM;
+    }
+
+    map->entries = (struct hashmap_entry*)block;
+    map->ctrl = block + entries_size;
+    map->capacity = capacity;
+    map->deleted = 0;
+    memset(map->ctrl, CTRL_EMPTY, capacity + GROUP_WIDTH);
 
     return 0;
 }
 
-static struct hashmap_entry* find_entry(struct hashmap_entry* entries,
-                                        size_t capacity,
-                                        uint64_t key) {
-    uint64_t index = hash_key(key) % capacity;
-    struct hashmap_entry* tombstone = nullptr;
+static size_t find_slot(const struct hashmap* map, uint64_t key) {
+    uint64_t hash = hash_key(key);
+    uint8_t h2 = H2(hash);
+    size_t mask = map->capacity - 1;
+    size_t position = H1(hash) & mask;
 
-    for (;;) {
-        struct hashmap_entry* entry = &entries[index];
+    for (size_t stride = GROUP_WIDTH;; stride += GROUP_WIDTH) {
+        const uint8_t* group = &map->ctrl[position];
 
-        if (IS_EMPTY(entry)) {
-            return tombstone != nullptr ? tombstone : entry;
+        for (uint32_t matches = group_match(group, h2); matches != 0;
+             matches &= matches - 1) {
+            size_t index = (position + lowest_bit(matches)) & mask;
+            if (map->entries[index].key == key) {
+                return index;
+            }
         }
 
-        if (IS_TOMBSTONE(entry)) {
-            if (tombstone == nullptr) {
-                tombstone = entry;
-            }
-        } else if (entry->key == key) {
-            return entry;
+        if (group_match_empty(group) != 0) {
+            return NOT_FOUND;
         }
 
-        index = (index + 1) % capacity;
+        position = (position + stride) & mask;
     }
 }
 
+static size_t find_insert_slot(const struct hashmap* map, uint64_t hash) {
+    size_t mask = map->capacity - 1;
+    size_t position = H1(hash) & mask;
+
+    for (size_t stride = GROUP_WIDTH;; stride += GROUP_WIDTH) {
+        uint32_t free_slots =
+            group_match_empty_or_deleted(&map->ctrl[position]);
+        if (free_slots != 0) {
+            return (position + lowest_bit(free_slots)) & mask;
+        }
+
+        position = (position + stride) & mask;
+    }
+}
+
+static void set_ctrl(struct hashmap* map, size_t index, uint8_t ctrl) {
+    map->ctrl[index] = ctrl;
+    if (index < GROUP_WIDTH) {
+        map->ctrl[map->capacity + index] = ctrl;
+    }
+}
+
+#ifdef HASHMAP_USE_SSE2
+
+static uint32_t group_match(const uint8_t* group, uint8_t ctrl) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)group);
+    __m128i pattern = _mm_set1_epi8((char)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, pattern));
+}
+
+static uint32_t group_match_empty_or_deleted(const uint8_t* group) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(bytes);
+}
+
+#else
+
+static uint32_t group_match(const uint8_t* group, uint8_t ctrl) {
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (uint32_t)(group[i] == ctrl) << i;
+    }
+    return mask;
+}
+
+static uint32_t group_match_empty_or_deleted(const uint8_t* group) {
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (uint32_t)((group[i] & CTRL_EMPTY) != 0) << i;
+    }
+    return mask;
+}
+
+#endif
+
+static uint32_t group_match_empty(const uint8_t* group) {
+    return group_match(group, CTRL_EMPTY);
+}
+
+static inline unsigned int lowest_bit(uint32_t mask) {
+    return (unsigned int)__builtin_ctz(mask);
+}
+
+static inline unsigned int leading_zeros(uint32_t mask) {
+    return (unsigned int)__builtin_clz(mask) - (32U - GROUP_WIDTH);
+}
+
 static uint64_t hash_key(uint64_t key) {
     key ^= key >> 33LU;
     key *= 0xff51afd7ed558ccd;
@@ -0,0 +1,52 @@
+#include "game/frustum.h"
+
+#include "raylib.h"
+
+struct frustum frustum_from_matrix(Matrix view_projection) {
+    const Matrix* m = &view_projection;
+
+    // raylib transforms a point p to clip space as
+    // (m0 p.x + m4 p.y + m8 p.z + m12, m1 p.x + ..., ...), so these are the
+    // rows of the clip transform. A point is inside when -w <= x, y, z <= w.
+    Vector4 x = {m->m0, m->m4, m->m8, m->m12};
+    Vector4 y = {m->m1, m->m5, m->m9, m->m13};
+    Vector4 z = {m->m2, m->m6, m->m10, m->m14};
+    Vector4 w = {m->m3, m->m7, m->m11, m->m15};
+
+    struct frustum frustum;
+    frustum.planes[FRUSTUM_LEFT] =
+        (Vector4){w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w};
+    frustum.planes[FRUSTUM_RIGHT] =
+        (Vector4){w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w};
+    frustum.planes[FRUSTUM_BOTTOM] =
+        (Vector4){w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w};
+    frustum.planes[FRUSTUM_TOP] =
+        (Vector4){w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w};
+    frustum.planes[FRUSTUM_NEAR] =
+        (Vector4){w.x + z.x, w.y + z.y, w.z + z.z, w.w + z.w};
+    frustum.planes[FRUSTUM_FAR] =
+        (Vector4){w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w};
+
+    return frustum;
+}
+
+bool frustum_intersects_box(const struct frustum* frustum, BoundingBox box) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        const Vector4* plane = &frustum->planes[i];
+
+        // The corner furthest along the plane normal is the last one to
+        // leave the volume.
+        Vector3 corner = {
+            plane->x >= 0.0F ? box.max.x : box.min.x,
+            plane->y >= 0.0F ? box.max.y : box.min.y,
+            plane->z >= 0.0F ? box.max.z : box.min.z,
+        };
+        float distance = (plane->x * corner.x) + (plane->y * corner.y) +
+                         (plane->z * corner.z) + plane->w;
+        if (distance < 0.0F) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -31,6 +31,8 @@ void init_player(struct player* player,
     player->direction = EAST;
 
     char filepath[FILEPATH_SIZE];
+    struct anim_clip* preloaded[NUM_DIRECTIONS * 3];
+    size_t preloaded_count = 0;
 
     for (int i = 0; i < NUM_DIRECTIONS; i++) {
         format_filepath(filepath, sizeof(filepath),
@@ -52,6 +54,17 @@ void init_player(struct player* player,
         format_filepath(filepath, sizeof(filepath),
                         "assets/gifs/player/reload/reload%d.gif", i * 45);
         init_anim(&player->reload_anim[i], filepath, 4);
+
+        preloaded[preloaded_count++] = player->idle_anim[i].clip;
+        preloaded[preloaded_count++] = player->run_anim[i].clip;
+        preloaded[preloaded_count++] = player->attack_anim[i].clip;
+    }
+
+    // Clips the player can switch to at any moment are loaded up front, so
+    // that their first use never stalls a frame. Reload and death clips load
+    // on first use and may be evicted again.
+    if (anim_cache_preload_all(preloaded, preloaded_count) != 0) {
+        TraceLog(LOG_WARNING, "PLAYER: Failed to preload some animations.");
     }
 }
 
@@ -162,7 +175,7 @@ void update_player(struct player* player, const struct camera* camera) {
     }
 }
 
-void draw_player(struct player* player, Camera3D camera) {
+void draw_player(struct player* player) {
     struct anim* current_anim = NULL;
 
     switch (player->state) {
@@ -185,8 +198,7 @@ void draw_player(struct player* player, Camera3D camera) {
     }
 
     if (current_anim != NULL) {
-        DrawBillboard(camera, current_anim->tex_anim, player->position, 10.0F,
-                      WHITE);
+        draw_anim(current_anim, player->position, 10.0F, WHITE);
     }
 }
 
@@ -0,0 +1,222 @@
+#include "game/profiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "raylib.h"
+
+static const double FRAME_BUDGET_MS = 1000.0 / 60.0;
+
+enum {
+    OVERLAY_WIDTH = 260,
+    OVERLAY_PADDING = 6,
+    LINE_HEIGHT = 14,
+    FONT_SIZE = 10,
+    VALUE_COLUMN = 180,
+    GRAPH_HEIGHT = 60,
+};
+
+struct zone {
+    const char* name;
+    double start;
+    double frame_ms;
+    bool is_open;
+};
+
+static struct {
+    struct zone zones[PROFILER_MAX_ZONES];
+    int zone_count;
+    float frame_ms[PROFILER_HISTORY];
+    float zone_ms[PROFILER_HISTORY][PROFILER_MAX_ZONES];
+    int head;
+    int frame_count;
+    double last_frame_time;
+    bool has_last_frame;
+} profiler;
+
+static struct zone* find_zone(const char* name);
+static int last_frame_index(void);
+static double average_ms(int zone_index);
+
+void profiler_begin(const char* name) {
+    if (!name) {
+        return;
+    }
+
+    struct zone* zone = find_zone(name);
+    if (!zone && profiler.zone_count < PROFILER_MAX_ZONES) {
+        zone = &profiler.zones[profiler.zone_count++];
+        zone->name = name;
+        zone->frame_ms = 0.0;
+    }
+
+    if (!zone) {
+        return;
+    }
+
+    zone->start = GetTime();
+    zone->is_open = true;
+}
+
+void profiler_end(const char* name) {
+    struct zone* zone = find_zone(name);
+    if (!zone || !zone->is_open) {
+        return;
+    }
+
+    zone->frame_ms += (GetTime() - zone->start) * 1000.0;
+    zone->is_open = false;
+}
+
+void profiler_end_frame(void) {
+    double now = GetTime();
+    int index = profiler.head;
+
+    profiler.frame_ms[index] =
+        profiler.has_last_frame
+            ? (float)((now - profiler.last_frame_time) * 1000.0)
+            : 0.0F;
+
+    for (int i = 0; i < PROFILER_MAX_ZONES; i++) {
+        if (i < profiler.zone_count) {
+            profiler.zone_ms[index][i] = (float)profiler.zones[i].frame_ms;
+            profiler.zones[i].frame_ms = 0.0;
+        } else {
+            profiler.zone_ms[index][i] = 0.0F;
+        }
+    }
+
+    profiler.head = (index + 1) % PROFILER_HISTORY;
+    if (profiler.frame_count < PROFILER_HISTORY) {
+        profiler.frame_count++;
+    }
+
+    profiler.last_frame_time = now;
+    profiler.has_last_frame = true;
+}
+
+double profiler_get_zone_ms(const char* name) {
+    const struct zone* zone = find_zone(name);
+    if (!zone || profiler.frame_count == 0) {
+        return 0.0;
+    }
+
+    return profiler.zone_ms[last_frame_index()][zone - profiler.zones];
+}
+
+double profiler_get_frame_ms(void) {
+    if (profiler.frame_count == 0) {
+        return 0.0;
+    }
+
+    return profiler.frame_ms[last_frame_index()];
+}
+
+double profiler_get_average_frame_ms(void) {
+    return average_ms(-1);
+}
+
+double profiler_get_average_zone_ms(const char* name) {
+    const struct zone* zone = find_zone(name);
+    if (!zone) {
+        return 0.0;
+    }
+
+    return average_ms((int)(zone - profiler.zones));
+}
+
+void profiler_draw(int x, int y) {
+    int height = (2 * OVERLAY_PADDING) +
+                 ((profiler.zone_count + 1) * LINE_HEIGHT) + GRAPH_HEIGHT;
+    DrawRectangle(x, y, OVERLAY_WIDTH, height, Fade(BLACK, 0.6F));
+
+    int text_x = x + OVERLAY_PADDING;
+    int line_y = y + OVERLAY_PADDING;
+    DrawText("frame", text_x, line_y, FONT_SIZE, RAYWHITE);
+    DrawText(TextFormat("%6.2f ms", average_ms(-1)), x + VALUE_COLUMN,
+             line_y, FONT_SIZE, RAYWHITE);
+
+    for (int i = 0; i < profiler.zone_count; i++) {
+        line_y += LINE_HEIGHT;
+        DrawText(profiler.zones[i].name, text_x, line_y, FONT_SIZE, LIGHTGRAY);
+        DrawText(TextFormat("%6.2f ms", average_ms(i)), x + VALUE_COLUMN,
+                 line_y, FONT_SIZE, LIGHTGRAY);
+    }
+
+    // The graph spans twice the frame budget, so the budget line sits in the
+    // middle and slow frames stand out in red.
+    int graph_bottom = y + height - OVERLAY_PADDING;
+    int graph_width = OVERLAY_WIDTH - (2 * OVERLAY_PADDING);
+    int bar_width = graph_width / PROFILER_HISTORY;
+    if (bar_width < 1) {
+        bar_width = 1;
+    }
+
+    for (int i = 0; i < profiler.frame_count; i++) {
+        int index = (profiler.head - profiler.frame_count + i +
+                     PROFILER_HISTORY) %
+                    PROFILER_HISTORY;
+        if (profiler.frame_ms[index] <= 0.0F) {
+            continue;
+        }
+
+        double ratio = profiler.frame_ms[index] / (2.0 * FRAME_BUDGET_MS);
+        if (ratio > 1.0) {
+            ratio = 1.0;
+        }
+
+        int bar_height = (int)(ratio * (GRAPH_HEIGHT - LINE_HEIGHT));
+        Color color =
+            profiler.frame_ms[index] > FRAME_BUDGET_MS ? RED : GREEN;
+        DrawRectangle(text_x + (i * bar_width), graph_bottom - bar_height,
+                      bar_width, bar_height, color);
+    }
+
+    int budget_y = graph_bottom - ((GRAPH_HEIGHT - LINE_HEIGHT) / 2);
+    DrawLine(text_x, budget_y, text_x + graph_width, budget_y, YELLOW);
+}
+
+void profiler_reset(void) {
+    memset(&profiler, 0, sizeof(profiler));
+}
+
+static struct zone* find_zone(const char* name) {
+    if (!name) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < profiler.zone_count; i++) {
+        struct zone* zone = &profiler.zones[i];
+        if (zone->name == name || strcmp(zone->name, name) == 0) {
+            return zone;
+        }
+    }
+
+    return nullptr;
+}
+
+static int last_frame_index(void) {
+    return (profiler.head + PROFILER_HISTORY - 1) % PROFILER_HISTORY;
+}
+
+/**
+ * Averages a zone, or the frame time for a zone_index of -1, over the
+ * recorded frames. The first frame has no duration, so frames without one
+ * are left out rather than pulling the average down until the ring wraps.
+ */
+static double average_ms(int zone_index) {
+    double total = 0.0;
+    int frames = 0;
+    for (int f = 0; f < profiler.frame_count; f++) {
+        if (profiler.frame_ms[f] <= 0.0F) {
+            continue;
+        }
+
+        total += zone_index < 0 ? profiler.frame_ms[f]
+                                : profiler.zone_ms[f][zone_index];
+        frames++;
+    }
+
+    return frames > 0 ? total / frames : 0.0;
+}
@@ -3,54 +3,143 @@
 #include <assert.h>
 #include <stdint.h>
 
-static struct {
-    uint64_t s[4];
-} rng_state;
+static struct rng global_rng;
 
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15;
+
+static const uint64_t JUMP[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+static const uint64_t LONG_JUMP[] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3,
+                                     0x77710069854ee241, 0x39109bb02acbe635};
+
+static void apply_jump(struct rng* rng, const uint64_t polynomial[4]);
 static inline uint64_t rotl(const uint64_t x, unsigned int k);
+static inline uint64_t mix64(uint64_t z);
 
 void rng_init(uint64_t seed) {
+    rng_init_r(&global_rng, seed);
+}
+
+uint64_t rng_next_u64(void) {
+    return rng_next_u64_r(&global_rng);
+}
+
+int rng_get_range(int min, int max) {
+    return rng_get_range_r(&global_rng, min, max);
+}
+
+void rng_init_r(struct rng* rng, uint64_t seed) {
+    assert(rng && "rng_init_r: rng cannot be NULL");
+
     uint64_t z = seed + 0x9e3779b97f4a7c15;
     for (int i = 0; i < 4; i++) {
         z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9;
         z = (z ^ (z >> 27U)) * 0x94d049bb133111eb;
-        rng_state.s[i] = z ^ (z >> 31U);
+        rng->s[i] = z ^ (z >> 31U);
     }
 }
 
-uint64_t rng_next_u64(void) {
-    const uint64_t result = rotl(rng_state.s[1] * 5, 7) * 9;
-    const uint64_t t = rng_state.s[1] << 17U;
+uint64_t rng_next_u64_r(struct rng* rng) {
+    assert(rng && "rng_next_u64_r: rng cannot be NULL");
+
+    const uint64_t result = rotl(rng->s[1] * 5, 7) * 9;
+    const uint64_t t = rng->s[1] << 17U;
 
-    rng_state.s[2] ^= rng_state.s[0];
-    rng_state.s[3] ^= rng_state.s[1];
-    rng_state.s[1] ^= rng_state.s[2];
-    rng_state.s[0] ^= rng_state.s[3];
+    rng->s[2] ^= rng->s[0];
+    rng->s[3] ^= rng->s[1];
+    rng->s[1] ^= rng->s[2];
+    rng->s[0] ^= rng->s[3];
 
-    rng_state.s[2] ^= t;
-    rng_state.s[3] = rotl(rng_state.s[3], 45);
+    rng->s[2] ^= t;
+    rng->s[3] = rotl(rng->s[3], 45);
 
     return result;
 }
 
-int rng_get_range(int min, int max) {
+int rng_get_range_r(struct rng* rng, int min, int max) {
     assert(min <= max && "rng_get_range: min cannot be greater than max");
 
     uint64_t range = (uint64_t)(max - min) + 1;
     if (range == 0) {
-        return (int)rng_next_u64();
+        return (int)rng_next_u64_r(rng);
+    }
+
+    uint64_t threshold = UINT64_MAX - (UINT64_MAX % range);
+    uint64_t n = 0;
+
+    do {
+        n = rng_next_u64_r(rng);
+    } while (n >= threshold);
+
+    return (int)(n % range) + min;
+}
+
+void rng_jump(struct rng* rng) {
+    apply_jump(rng, JUMP);
+}
+
+void rng_long_jump(struct rng* rng) {
+    apply_jump(rng, LONG_JUMP);
+}
+
+uint64_t rng_hash_coords(uint64_t seed, int32_t x, int32_t y) {
+    uint64_t coords = ((uint64_t)(uint32_t)x << 32U) | (uint32_t)y;
+    return mix64(mix64(seed + GOLDEN_GAMMA) ^ coords);
+}
+
+uint64_t rng_stream_u64(uint64_t key, uint64_t counter) {
+    return mix64(key + ((counter + 1) * GOLDEN_GAMMA));
+}
+
+int rng_stream_range(uint64_t key, uint64_t* counter, int min, int max) {
+    assert(counter && "rng_stream_range: counter cannot be NULL");
+    assert(min <= max && "rng_stream_range: min cannot be greater than max");
+
+    uint64_t range = (uint64_t)(max - min) + 1;
+    if (range == 0) {
+        return (int)rng_stream_u64(key, (*counter)++);
     }
 
     uint64_t threshold = UINT64_MAX - (UINT64_MAX % range);
     uint64_t n = 0;
 
     do {
-        n = rng_next_u64();
+        n = rng_stream_u64(key, (*counter)++);
     } while (n >= threshold);
 
     return (int)(n % range) + min;
 }
 
+static void apply_jump(struct rng* rng, const uint64_t polynomial[4]) {
+    assert(rng && "rng_jump: rng cannot be NULL");
+
+    uint64_t s[4] = {0};
+
+    for (int i = 0; i < 4; i++) {
+        for (unsigned int b = 0; b < 64; b++) {
+            if (polynomial[i] & (UINT64_C(1) << b)) {
+                s[0] ^= rng->s[0];
+                s[1] ^= rng->s[1];
+                s[2] ^= rng->s[2];
+                s[3] ^= rng->s[3];
+            }
+            (void)rng_next_u64_r(rng);
+        }
+    }
+
+    rng->s[0] = s[0];
+    rng->s[1] = s[1];
+    rng->s[2] = s[2];
+    rng->s[3] = s[3];
+}
+
 static inline uint64_t rotl(const uint64_t x, unsigned int k) {
     return (x << k) | (x >> (64U - k));
 }
+
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27U)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31U);
+}
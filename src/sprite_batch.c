@@ -0,0 +1,330 @@
+#include "game/sprite_batch.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+enum { INITIAL_SPRITE_CAPACITY = 256 };
+
+/** A sprite waiting for sprite_batch_end(), with its sort keys. */
+struct queued_sprite {
+    struct sprite sprite;
+    float depth;
+    bool is_translucent;
+};
+
+// raylib's default fragment shader, except that fully transparent texels are
+// discarded instead of writing depth.
+static const char* SPRITE_FRAGMENT_SHADER =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    vec4 texelColor = texture(texture0, fragTexCoord);\n"
+    "    if (texelColor.a == 0.0) discard;\n"
+    "    finalColor = texelColor * colDiffuse * fragColor;\n"
+    "}\n";
+
+// The same, for a texture of palette slots whose colors are fetched from the
+// palette texture.
+static const char* PALETTE_FRAGMENT_SHADER =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform sampler2D palette;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    int slot = int(texture(texture0, fragTexCoord).r * 255.0 + 0.5);\n"
+    "    vec4 texelColor = texelFetch(palette, ivec2(slot, 0), 0);\n"
+    "    if (texelColor.a == 0.0) discard;\n"
+    "    finalColor = texelColor * colDiffuse * fragColor;\n"
+    "}\n";
+
+static bool is_initialized = false;
+static bool is_collecting = false;
+
+static Shader sprite_shader;
+static Shader palette_shader;
+static int palette_location = -1;
+static bool has_palette_shader = false;
+static bool is_palette_enabled = true;
+
+static struct queued_sprite* sprites = nullptr;
+static size_t sprite_count = 0;
+static size_t sprite_capacity = 0;
+
+static Vector3 camera_position;
+static Vector3 camera_forward;
+static Vector3 camera_right;
+
+static size_t drawn_sprites = 0;
+static size_t batch_count = 0;
+
+static int compare_sprites(const void* lhs, const void* rhs);
+static void draw_sprites(void);
+static void draw_quad(const struct sprite* sprite);
+
+int sprite_batch_init(void) {
+    if (is_initialized) {
+        return 0;
+    }
+
+    sprites = malloc(INITIAL_SPRITE_CAPACITY * sizeof(struct queued_sprite));
+    if (!sprites) {
+        TraceLog(LOG_ERROR,
+                 "SPRITE_BATCH: Failed to allocate sprites (out of memory).");
+        return -ENOMEM;
+    }
+    sprite_capacity = INITIAL_SPRITE_CAPACITY;
+
+    sprite_shader = LoadShaderFromMemory(nullptr, SPRITE_FRAGMENT_SHADER);
+    if (sprite_shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_ERROR, "SPRITE_BATCH: Failed to compile sprite shader.");
+        free(sprites);
+        sprites = nullptr;
+        return -EIO;
+    }
+
+    palette_shader = LoadShaderFromMemory(nullptr, PALETTE_FRAGMENT_SHADER);
+    has_palette_shader = palette_shader.id != rlGetShaderIdDefault();
+    if (has_palette_shader) {
+        palette_location = GetShaderLocation(palette_shader, "palette");
+    } else {
+        TraceLog(LOG_WARNING,
+                 "SPRITE_BATCH: Palette shader unavailable, atlases will use "
+                 "RGBA pages.");
+    }
+
+    sprite_count = 0;
+    is_collecting = false;
+    is_initialized = true;
+
+    return 0;
+}
+
+void sprite_batch_destroy(void) {
+    if (!is_initialized) {
+        return;
+    }
+
+    UnloadShader(sprite_shader);
+    if (has_palette_shader) {
+        UnloadShader(palette_shader);
+    }
+    has_palette_shader = false;
+
+    free(sprites);
+    sprites = nullptr;
+    sprite_count = 0;
+    sprite_capacity = 0;
+    is_initialized = false;
+}
+
+bool sprite_batch_has_palette_shader(void) {
+    return is_initialized && has_palette_shader && is_palette_enabled;
+}
+
+void sprite_batch_set_palette_enabled(bool enabled) {
+    is_palette_enabled = enabled;
+}
+
+void sprite_batch_begin(Camera3D camera) {
+    if (!is_initialized) {
+        return;
+    }
+
+    // The same right vector DrawBillboardPro() takes from the view matrix.
+    camera_position = camera.position;
+    camera_forward =
+        Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+    camera_right =
+        Vector3Normalize(Vector3CrossProduct(camera_forward, camera.up));
+
+    sprite_count = 0;
+    is_collecting = true;
+}
+
+int sprite_batch_add(const struct sprite* sprite) {
+    if (!sprite) {
+        return -EINVAL;
+    }
+    if (!is_collecting) {
+        return -ECANCELED;
+    }
+
+    if (sprite_count == sprite_capacity) {
+        size_t capacity = sprite_capacity * 2;
+        struct queued_sprite* grown =
+            realloc(sprites, capacity * sizeof(struct queued_sprite));
+        if (!grown) {
+            return -ENOMEM;
+        }
+        sprites = grown;
+        sprite_capacity = capacity;
+    }
+
+    sprites[sprite_count++] = (struct queued_sprite){
+        .sprite = *sprite,
+        .depth = Vector3DotProduct(
+            Vector3Subtract(sprite->position, camera_position),
+            camera_forward),
+        .is_translucent = sprite->tint.a < 255,
+    };
+
+    return 0;
+}
+
+void sprite_batch_end(void) {
+    if (!is_collecting) {
+        return;
+    }
+
+    qsort(sprites, sprite_count, sizeof(struct queued_sprite),
+          compare_sprites);
+    draw_sprites();
+
+    drawn_sprites = sprite_count;
+    sprite_count = 0;
+    is_collecting = false;
+}
+
+size_t sprite_batch_get_sprite_count(void) {
+    return drawn_sprites;
+}
+
+size_t sprite_batch_get_batch_count(void) {
+    return batch_count;
+}
+
+static int compare_sprites(const void* lhs, const void* rhs) {
+    const struct queued_sprite* a = lhs;
+    const struct queued_sprite* b = rhs;
+
+    if (a->is_translucent != b->is_translucent) {
+        return a->is_translucent ? 1 : -1;
+    }
+
+    // Translucent sprites blend with what is behind them, so they must be
+    // drawn back to front whatever their texture.
+    if (a->is_translucent) {
+        return (a->depth < b->depth) - (a->depth > b->depth);
+    }
+
+    if (a->sprite.palette.id != b->sprite.palette.id) {
+        return a->sprite.palette.id < b->sprite.palette.id ? -1 : 1;
+    }
+    if (a->sprite.texture.id != b->sprite.texture.id) {
+        return a->sprite.texture.id < b->sprite.texture.id ? -1 : 1;
+    }
+    return (a->depth > b->depth) - (a->depth < b->depth);
+}
+
+static void draw_sprites(void) {
+    batch_count = 0;
+    if (sprite_count == 0) {
+        return;
+    }
+
+    unsigned int texture_id = 0;
+    unsigned int palette_id = 0;
+    bool is_indexed = false;
+    bool has_begun = false;
+    bool can_draw_indexed = sprite_batch_has_palette_shader();
+
+    for (size_t i = 0; i < sprite_count; i++) {
+        const struct sprite* sprite = &sprites[i].sprite;
+        bool sprite_is_indexed = sprite->palette.id != 0;
+        if (sprite_is_indexed && !can_draw_indexed) {
+            continue;
+        }
+
+        // The first sprites may have been skipped, so the shader is chosen
+        // by the first one actually drawn.
+        if (!has_begun || sprite_is_indexed != is_indexed) {
+            BeginShaderMode(sprite_is_indexed ? palette_shader
+                                              : sprite_shader);
+            has_begun = true;
+            is_indexed = sprite_is_indexed;
+            palette_id = 0;
+            texture_id = 0;
+        }
+
+        // Each palette is bound for a whole render batch, so a new palette
+        // needs the quads of the previous one submitted first.
+        if (sprite_is_indexed && sprite->palette.id != palette_id) {
+            rlDrawRenderBatchActive();
+            SetShaderValueTexture(palette_shader, palette_location,
+                                  sprite->palette);
+            palette_id = sprite->palette.id;
+            texture_id = 0;
+        }
+
+        // rlgl submits the batch on its own when it runs out of draw calls
+        // on a texture change, or when the vertex buffer is full, and every
+        // submission unbinds the palette. Binding it again is free while it
+        // is still bound.
+        bool may_have_flushed = false;
+        if (sprite->texture.id != texture_id) {
+            rlSetTexture(sprite->texture.id);
+            texture_id = sprite->texture.id;
+            batch_count++;
+            may_have_flushed = true;
+        }
+        if (rlCheckRenderBatchLimit(4)) {
+            may_have_flushed = true;
+        }
+        if (may_have_flushed && is_indexed) {
+            SetShaderValueTexture(palette_shader, palette_location,
+                                  sprite->palette);
+        }
+        draw_quad(sprite);
+    }
+
+    if (has_begun) {
+        rlSetTexture(0);
+        EndShaderMode();
+    }
+}
+
+static void draw_quad(const struct sprite* sprite) {
+    Vector3 right = Vector3Scale(camera_right, sprite->size.x);
+    Vector3 up = {0.0F, sprite->size.y, 0.0F};
+    Vector3 origin = Vector3Add(Vector3Scale(camera_right, sprite->origin.x),
+                                (Vector3){0.0F, sprite->origin.y, 0.0F});
+    Vector3 corner = Vector3Subtract(sprite->position, origin);
+
+    Vector3 points[4] = {
+        corner,
+        Vector3Add(corner, right),
+        Vector3Add(Vector3Add(corner, right), up),
+        Vector3Add(corner, up),
+    };
+
+    Rectangle source = sprite->source;
+    float width = (float)sprite->texture.width;
+    float height = (float)sprite->texture.height;
+    Vector2 texcoords[4] = {
+        {source.x / width, (source.y + source.height) / height},
+        {(source.x + source.width) / width,
+         (source.y + source.height) / height},
+        {(source.x + source.width) / width, source.y / height},
+        {source.x / width, source.y / height},
+    };
+
+    Color tint = sprite->tint;
+    rlBegin(RL_QUADS);
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    for (int i = 0; i < 4; i++) {
+        rlTexCoord2f(texcoords[i].x, texcoords[i].y);
+        rlVertex3f(points[i].x, points[i].y, points[i].z);
+    }
+    rlEnd();
+}
@@ -1,24 +1,113 @@
 #include "game/world/generator.h"
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "raylib.h"
 
-#include "game/ds/vector.h"
+#include "game/ds/hashmap.h"
+#include "game/profiler.h"
 #include "game/rng.h"
 #include "game/world/grid.h"
 #include "game/world/room_def.h"
 
+enum { CHUNK_RADIUS = 2, CHUNK_SIDE = (2 * CHUNK_RADIUS) + 1 };
+
 struct frontier_cell {
     int32_t x;
     int32_t y;
 };
 
+/**
+ * The view of the room layout that the frontier algorithm reads and writes.
+ * The synchronous path works on the grid directly; the worker works on its
+ * private shadow copy and reports placements through the commit queue.
+ */
+struct layout {
+    const struct room_def* (*get)(int32_t x, int32_t y);
+    int (*place)(int32_t x, int32_t y, const struct room_def* def);
+};
+
+enum request_type {
+    REQUEST_CHUNK,    /**< Generate the chunk centered on (x, y). */
+    REQUEST_PAGE_OUT, /**< Forget rooms more than distance from (x, y). */
+};
+
+struct chunk_request {
+    struct chunk_request* next;
+    enum request_type type;
+    int32_t x;
+    int32_t y;
+    int32_t distance;
+};
+
+struct placement {
+    struct placement* next;
+    int32_t x;
+    int32_t y;
+    const struct room_def* def;
+};
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    struct chunk_request* requests_head;
+    struct chunk_request* requests_tail;
+    struct placement* commits_head;
+    struct placement* commits_tail;
+    struct hashmap shadow;
+    bool is_busy;
+    bool is_running;
+    bool should_stop;
+} worker = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+static struct rng generator_rng;
+static uint64_t world_seed = 0;
+static enum generator_rng_mode rng_mode = GENERATOR_RNG_SEQUENTIAL;
+
+static int create_chunk(const struct layout* layout,
+                        int32_t center_x,
+                        int32_t center_y);
+static const struct room_def* grid_layout_get(int32_t x, int32_t y);
+static const struct room_def* shadow_layout_get(int32_t x, int32_t y);
+static int shadow_layout_place(int32_t x,
+                               int32_t y,
+                               const struct room_def* def);
+static int queue_request(enum request_type type,
+                         int32_t x,
+                         int32_t y,
+                         int32_t distance);
+static void prune_shadow(const struct chunk_request* request);
+static bool is_awaiting_commit(int32_t x, int32_t y);
+static inline uint64_t layout_key(int32_t x, int32_t y);
+static void* generation_worker(void* arg);
+
+static const struct layout GRID_LAYOUT = {
+    .get = grid_layout_get,
+    .place = grid_place_room,
+};
+
+static const struct layout SHADOW_LAYOUT = {
+    .get = shadow_layout_get,
+    .place = shadow_layout_place,
+};
+
+void generator_set_rng_mode(enum generator_rng_mode mode) {
+    rng_mode = mode;
+}
+
 int generator_init(unsigned int seed) {
-    rng_init(seed);
+    rng_init_r(&generator_rng, seed);
+    world_seed = seed;
 
     const struct room_def* start = nullptr;
 
@@ -38,6 +127,12 @@ int generator_init(unsigned int seed) {
 
     room_def_remove(start);
 
+    // A world loaded from a save already has its starting area, and
+    // generating around it again would draw from the wrong state.
+    if (grid_get_cell(0, 0) != nullptr) {
+        return 0;
+    }
+
     grid_place_room(0, 0, start);
     if (generator_create_chunk(0, 0) != 0) {
         TraceLog(LOG_ERROR, "GENERATOR: Initial chunk generation failed.");
@@ -48,85 +143,209 @@ int generator_init(unsigned int seed) {
 }
 
 int generator_create_chunk(int32_t center_x, int32_t center_y) {
-    struct vector frontiers;
+    PROFILE_BEGIN("generator_create_chunk");
+    int ret = create_chunk(&GRID_LAYOUT, center_x, center_y);
+    PROFILE_END("generator_create_chunk");
 
-    if (vector_init(&frontiers) != 0) {
-        TraceLog(LOG_ERROR,
-                 "GENERATOR: Failed to initialize frontiers vector.");
+    return ret;
+}
+
+int generator_start_worker(void) {
+    if (worker.is_running) {
+        return 0;
+    }
+
+    if (hashmap_init(&worker.shadow) != 0) {
+        TraceLog(LOG_ERROR, "GENERATOR: Failed to initialize shadow layout.");
         return -ENOMEM;
     }
 
-    int ret = 0;
+    worker.should_stop = false;
+    worker.is_busy = false;
+    if (pthread_create(&worker.thread, nullptr, generation_worker, nullptr) !=
+        0) {
+        TraceLog(LOG_ERROR, "GENERATOR: Failed to start generation worker.");
+        hashmap_destroy(&worker.shadow);
+        return -EAGAIN;
+    }
+
+    worker.is_running = true;
+    return 0;
+}
+
+void generator_stop_worker(void) {
+    if (!worker.is_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker.lock);
+    worker.should_stop = true;
+    pthread_cond_signal(&worker.wake);
+    pthread_mutex_unlock(&worker.lock);
+    pthread_join(worker.thread, nullptr);
+
+    while (worker.requests_head) {
+        struct chunk_request* request = worker.requests_head;
+        worker.requests_head = request->next;
+        free(request);
+    }
+    worker.requests_tail = nullptr;
+
+    while (worker.commits_head) {
+        struct placement* placement = worker.commits_head;
+        worker.commits_head = placement->next;
+        free(placement);
+    }
+    worker.commits_tail = nullptr;
+
+    hashmap_destroy(&worker.shadow);
+    worker.is_running = false;
+}
+
+int generator_request_chunk(int32_t center_x, int32_t center_y) {
+    if (!worker.is_running) {
+        return generator_create_chunk(center_x, center_y);
+    }
+
+    return queue_request(REQUEST_CHUNK, center_x, center_y, 0);
+}
+
+int generator_page_out(int32_t center_x, int32_t center_y, int32_t distance) {
+    if (distance < 0) {
+        return -EINVAL;
+    }
+
+    if (!worker.is_running) {
+        return 0;
+    }
+
+    return queue_request(REQUEST_PAGE_OUT, center_x, center_y, distance);
+}
+
+size_t generator_commit(void) {
+    if (!worker.is_running) {
+        return 0;
+    }
+
+    PROFILE_BEGIN("generator_commit");
+
+    // The lock is held until the rooms are on the grid, so the worker never
+    // prunes its copy of a room that is in neither place.
+    pthread_mutex_lock(&worker.lock);
+    struct placement* placement = worker.commits_head;
+    worker.commits_head = nullptr;
+    worker.commits_tail = nullptr;
+
+    size_t committed = 0;
+    while (placement) {
+        struct placement* next = placement->next;
+        if (grid_place_room(placement->x, placement->y, placement->def) == 0) {
+            committed++;
+        }
+        free(placement);
+        placement = next;
+    }
+    pthread_mutex_unlock(&worker.lock);
+
+    PROFILE_END("generator_commit");
+
+    return committed;
+}
+
+size_t generator_flush(void) {
+    if (!worker.is_running) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&worker.lock);
+    while (worker.requests_head || worker.is_busy) {
+        pthread_cond_wait(&worker.idle, &worker.lock);
+    }
+    pthread_mutex_unlock(&worker.lock);
+
+    return generator_commit();
+}
+
+size_t generator_get_shadow_count(void) {
+    return worker.is_running ? hashmap_len(&worker.shadow) : 0;
+}
+
+void generator_get_state(struct generator_state* state) {
+    state->seed = world_seed;
+    state->rng = generator_rng;
+    state->mode = rng_mode;
+}
+
+void generator_set_state(const struct generator_state* state) {
+    world_seed = state->seed;
+    generator_rng = state->rng;
+    rng_mode = state->mode;
+}
 
-    for (int32_t y = center_y - 2; y <= center_y + 2; ++y) {
-        for (int32_t x = center_x - 2; x <= center_x + 2; ++x) {
-            if (grid_get_cell(x, y) != nullptr) {
+static int create_chunk(const struct layout* layout,
+                        int32_t center_x,
+                        int32_t center_y) {
+    struct frontier_cell frontiers[CHUNK_SIDE * CHUNK_SIDE];
+    int frontier_count = 0;
+
+    for (int32_t y = center_y - CHUNK_RADIUS; y <= center_y + CHUNK_RADIUS;
+         ++y) {
+        for (int32_t x = center_x - CHUNK_RADIUS; x <= center_x + CHUNK_RADIUS;
+             ++x) {
+            if (layout->get(x, y) != nullptr) {
                 continue;
             }
 
-            if (grid_get_cell(x, y + 1) || grid_get_cell(x, y - 1) ||
-                grid_get_cell(x + 1, y) || grid_get_cell(x - 1, y)) {
-                struct frontier_cell* cell =
-                    malloc(sizeof(struct frontier_cell));
-                if (!cell) {
-                    TraceLog(LOG_ERROR,
-                             "GENERATOR: Failed to allocate memory for "
-                             "frontier_cell.");
-                    ret = -ENOMEM;
-                    goto cleanup;
-                }
-                cell->x = x;
-                cell->y = y;
-
-                if (vector_push(&frontiers, cell) != 0) {
-                    TraceLog(
-                        LOG_ERROR,
-                        "GENERATOR: Failed ot push frontier cell to vector.");
-                    free(cell);
-                    ret = -ENOMEM;
-                    goto cleanup;
-                }
+            if (layout->get(x, y + 1) || layout->get(x, y - 1) ||
+                layout->get(x + 1, y) || layout->get(x - 1, y)) {
+                frontiers[frontier_count].x = x;
+                frontiers[frontier_count].y = y;
+                frontier_count++;
             }
         }
     }
 
-    for (int i = (int)vector_len(&frontiers) - 1; i > 0; i--) {
-        size_t j = rng_get_range(0, i);
-        void* temp = vector_get(&frontiers, i);
+    if (rng_mode == GENERATOR_RNG_SEQUENTIAL) {
+        for (int i = frontier_count - 1; i > 0; i--) {
+            int j = rng_get_range_r(&generator_rng, 0, i);
+            struct frontier_cell temp = frontiers[i];
 
-        vector_set(&frontiers, i, vector_get(&frontiers, j));
-        vector_set(&frontiers, j, temp);
+            frontiers[i] = frontiers[j];
+            frontiers[j] = temp;
+        }
     }
 
-    for (size_t i = 0; i < vector_len(&frontiers); ++i) {
-        struct frontier_cell* cell_pos = vector_get(&frontiers, i);
+    for (int i = 0; i < frontier_count; ++i) {
+        const struct frontier_cell* cell_pos = &frontiers[i];
 
         uint8_t required_doors = 0;
         uint8_t forbidden_doors = 0;
 
-        struct world_cell* north = grid_get_cell(cell_pos->x, cell_pos->y + 1);
-        if (north && (north->template->door_mask & DOOR_SOUTH)) {
+        const struct room_def* north =
+            layout->get(cell_pos->x, cell_pos->y + 1);
+        if (north && (north->door_mask & DOOR_SOUTH)) {
             required_doors |= DOOR_NORTH;
         } else if (north) {
             forbidden_doors |= DOOR_NORTH;
         }
 
-        struct world_cell* south = grid_get_cell(cell_pos->x, cell_pos->y - 1);
-        if (south && (south->template->door_mask & DOOR_NORTH)) {
+        const struct room_def* south =
+            layout->get(cell_pos->x, cell_pos->y - 1);
+        if (south && (south->door_mask & DOOR_NORTH)) {
             required_doors |= DOOR_SOUTH;
         } else if (south) {
             forbidden_doors |= DOOR_SOUTH;
         }
 
-        struct world_cell* east = grid_get_cell(cell_pos->x + 1, cell_pos->y);
-        if (east && (east->template->door_mask & DOOR_WEST)) {
+        const struct room_def* east = layout->get(cell_pos->x + 1, cell_pos->y);
+        if (east && (east->door_mask & DOOR_WEST)) {
             required_doors |= DOOR_EAST;
         } else if (east) {
             forbidden_doors |= DOOR_EAST;
         }
 
-        struct world_cell* west = grid_get_cell(cell_pos->x - 1, cell_pos->y);
-        if (west && (west->template->door_mask & DOOR_EAST)) {
+        const struct room_def* west = layout->get(cell_pos->x - 1, cell_pos->y);
+        if (west && (west->door_mask & DOOR_EAST)) {
             required_doors |= DOOR_WEST;
         } else if (west) {
             forbidden_doors |= DOOR_WEST;
@@ -141,18 +360,184 @@ int generator_create_chunk(int32_t center_x, int32_t center_y) {
             forbidden_doors = ~required_doors;
         }
 
-        const struct room_def* compatible =
-            room_def_find_constrained(required_doors, forbidden_doors);
+        const struct room_def* compatible = nullptr;
+        if (rng_mode == GENERATOR_RNG_COORDINATE) {
+            compatible = room_def_find_constrained_keyed(
+                required_doors, forbidden_doors,
+                rng_hash_coords(world_seed, cell_pos->x, cell_pos->y));
+        } else {
+            compatible = room_def_find_constrained_r(
+                required_doors, forbidden_doors, &generator_rng);
+        }
         if (compatible) {
-            grid_place_room(cell_pos->x, cell_pos->y, compatible);
+            int ret = layout->place(cell_pos->x, cell_pos->y, compatible);
+            if (ret != 0) {
+                return ret;
+            }
         }
     }
 
-cleanup:
-    for (size_t i = 0; i < vector_len(&frontiers); ++i) {
-        free(vector_get(&frontiers, i));
+    return 0;
+}
+
+static const struct room_def* grid_layout_get(int32_t x, int32_t y) {
+    const struct world_cell* cell = grid_get_cell(x, y);
+    return cell ? cell->template : nullptr;
+}
+
+static const struct room_def* shadow_layout_get(int32_t x, int32_t y) {
+    const struct room_def* def = hashmap_get(&worker.shadow, layout_key(x, y));
+    return def ? def : grid_get_saved_template(x, y);
+}
+
+static int shadow_layout_place(int32_t x,
+                               int32_t y,
+                               const struct room_def* def) {
+    struct placement* placement = malloc(sizeof(struct placement));
+    if (!placement) {
+        TraceLog(LOG_ERROR,
+                 "GENERATOR: Failed to allocate memory for placement.");
+        return -ENOMEM;
+    }
+
+    if (hashmap_set(&worker.shadow, layout_key(x, y), (void*)def, nullptr) !=
+        0) {
+        free(placement);
+        return -ENOMEM;
     }
-    vector_destroy(&frontiers);
 
-    return ret;
+    placement->next = nullptr;
+    placement->x = x;
+    placement->y = y;
+    placement->def = def;
+
+    pthread_mutex_lock(&worker.lock);
+    if (worker.commits_tail) {
+        worker.commits_tail->next = placement;
+    } else {
+        worker.commits_head = placement;
+    }
+    worker.commits_tail = placement;
+    pthread_mutex_unlock(&worker.lock);
+
+    return 0;
+}
+
+static int queue_request(enum request_type type,
+                         int32_t x,
+                         int32_t y,
+                         int32_t distance) {
+    struct chunk_request* request = malloc(sizeof(struct chunk_request));
+    if (!request) {
+        TraceLog(LOG_ERROR,
+                 "GENERATOR: Failed to allocate memory for chunk request.");
+        return -ENOMEM;
+    }
+
+    request->next = nullptr;
+    request->type = type;
+    request->x = x;
+    request->y = y;
+    request->distance = distance;
+
+    pthread_mutex_lock(&worker.lock);
+    if (worker.requests_tail) {
+        worker.requests_tail->next = request;
+    } else {
+        worker.requests_head = request;
+    }
+    worker.requests_tail = request;
+    pthread_cond_signal(&worker.wake);
+    pthread_mutex_unlock(&worker.lock);
+
+    return 0;
+}
+
+/**
+ * Drops the worker's copies of the rooms far from the request's center. The
+ * grid has every committed room, resident or paged out, and
+ * shadow_layout_get() reads it back from there; only rooms still waiting for
+ * generator_commit() must be kept.
+ */
+static void prune_shadow(const struct chunk_request* request) {
+    size_t pruned = 0;
+
+    // Removing the current entry does not move any other, so entries can be
+    // removed as the iteration reaches them.
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&worker.shadow, &iter, &key, &value)) {
+        int32_t x = (int32_t)(uint32_t)(key >> 32U);
+        int32_t y = (int32_t)(uint32_t)key;
+        int64_t dist_x = llabs((int64_t)x - request->x);
+        int64_t dist_y = llabs((int64_t)y - request->y);
+        if ((dist_x > request->distance || dist_y > request->distance) &&
+            !is_awaiting_commit(x, y)) {
+            hashmap_remove(&worker.shadow, key);
+            pruned++;
+        }
+    }
+
+    if (pruned > 0) {
+        TraceLog(LOG_DEBUG, "GENERATOR: Pruned %zu rooms, %zu kept.", pruned,
+                 hashmap_len(&worker.shadow));
+    }
+}
+
+static bool is_awaiting_commit(int32_t x, int32_t y) {
+    pthread_mutex_lock(&worker.lock);
+    const struct placement* placement = worker.commits_head;
+    while (placement && (placement->x != x || placement->y != y)) {
+        placement = placement->next;
+    }
+    pthread_mutex_unlock(&worker.lock);
+
+    return placement != nullptr;
+}
+
+static inline uint64_t layout_key(int32_t x, int32_t y) {
+    return ((uint64_t)(uint32_t)x << 32U) | (uint32_t)y;
+}
+
+static void* generation_worker(void* arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&worker.lock);
+    for (;;) {
+        while (!worker.should_stop && !worker.requests_head) {
+            pthread_cond_broadcast(&worker.idle);
+            pthread_cond_wait(&worker.wake, &worker.lock);
+        }
+
+        if (worker.should_stop) {
+            break;
+        }
+
+        struct chunk_request* request = worker.requests_head;
+        worker.requests_head = request->next;
+        if (!worker.requests_head) {
+            worker.requests_tail = nullptr;
+        }
+        worker.is_busy = true;
+        pthread_mutex_unlock(&worker.lock);
+
+        if (request->type == REQUEST_PAGE_OUT) {
+            prune_shadow(request);
+        } else if (create_chunk(&SHADOW_LAYOUT, request->x, request->y) !=
+                   0) {
+            TraceLog(LOG_ERROR,
+                     "GENERATOR: Background chunk generation failed at "
+                     "(%d, %d).",
+                     request->x, request->y);
+        }
+        free(request);
+
+        pthread_mutex_lock(&worker.lock);
+        worker.is_busy = false;
+    }
+    pthread_cond_broadcast(&worker.idle);
+    pthread_mutex_unlock(&worker.lock);
+
+    return nullptr;
 }
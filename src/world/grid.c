@@ -1,16 +1,64 @@
 #include "game/world/grid.h"
 
 #include <errno.h>
+#include <float.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 #include "raylib.h"
 
 #include "game/ds/hashmap.h"
+#include "game/profiler.h"
+#include "game/world/model_cache.h"
+#include "game/world/world_file.h"
+
+enum { INITIAL_REGION_CAPACITY = 16 };
+
+/** A paged-out room: its offset within its region and its template id. */
+struct region_room {
+    uint8_t offset_x;
+    uint8_t offset_y;
+    uint16_t template_id;
+};
+
+/** The paged-out rooms of one region, in no particular order. */
+struct region {
+    uint16_t count;
+    uint16_t capacity;
+    struct region_room rooms[];
+};
 
 static struct hashmap grid;
+static struct hashmap regions;
+static size_t paged_count = 0;
 static bool is_initialized = false;
 
+// Only the main thread changes grid and regions, and it holds this lock while
+// it does, so grid_get_saved_template() can read them from other threads.
+// The main thread's own reads need no lock.
+static pthread_mutex_t layout_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The attached save, the template of each of its names, and one bit per
+// entry of its region index, set once the region has been faulted in.
+static const struct world_file* save = nullptr;
+static const struct room_def* const* save_templates = nullptr;
+static uint8_t* save_faulted = nullptr;
+
+static int insert_cell(int32_t x,
+                       int32_t y,
+                       const struct room_def* room_template);
+static int page_out_cell(const struct world_cell* cell);
+static int restore_region(int32_t x, int32_t y);
+static int restore_paged_region(int32_t region_x, int32_t region_y);
+static int fault_in_region(int32_t region_x, int32_t region_y);
+static bool is_faulted_in(const struct world_file_region* region);
+static bool is_region_far(int32_t x,
+                          int32_t y,
+                          int32_t center_x,
+                          int32_t center_y,
+                          int32_t distance);
+static inline int32_t region_coord(int32_t v);
 static inline uint64_t grid_key(int32_t x, int32_t y);
 
 int grid_init() {
@@ -22,6 +70,17 @@ int grid_init() {
         return -ENOMEM;
     }
 
+    if (hashmap_init(&regions) != 0) {
+        hashmap_destroy(&grid);
+        return -ENOMEM;
+    }
+
+    if (model_cache_init() != 0) {
+        hashmap_destroy(&regions);
+        hashmap_destroy(&grid);
+        return -ENOMEM;
+    }
+
     is_initialized = true;
 
     return 0;
@@ -37,13 +96,25 @@ void grid_destroy(void) {
     void* value = nullptr;
     while (hashmap_iter(&grid, &iter, &key, &value)) {
         struct world_cell* cell = (struct world_cell*)value;
-        if (cell->is_model_loaded) {
-            UnloadModel(cell->model);
+        if (cell->is_model_requested) {
+            model_cache_release(cell->template);
         }
         free(cell);
     }
 
+    iter = 0;
+    while (hashmap_iter(&regions, &iter, &key, &value)) {
+        free(value);
+    }
+
     hashmap_destroy(&grid);
+    hashmap_destroy(&regions);
+    paged_count = 0;
+    free(save_faulted);
+    save = nullptr;
+    save_templates = nullptr;
+    save_faulted = nullptr;
+    model_cache_destroy();
     is_initialized = false;
 }
 
@@ -59,37 +130,271 @@ int grid_place_room(int32_t x,
         return -EINVAL;
     }
 
+    // A paged-out room at (x, y) must win over the new one, as it would if it
+    // were resident.
+    int ret = restore_region(x, y);
+    if (ret < 0) {
+        return ret;
+    }
+
+    pthread_mutex_lock(&layout_lock);
+    ret = insert_cell(x, y, room_template);
+    pthread_mutex_unlock(&layout_lock);
+
+    return ret;
+}
+
+struct world_cell* grid_get_cell(int32_t x, int32_t y) {
+    if (!is_initialized) {
+        return nullptr;
+    }
+
     uint64_t key = grid_key(x, y);
-    if (hashmap_get(&grid, key) != nullptr) {
-        return 0;
+    struct world_cell* cell = hashmap_get(&grid, key);
+    if (!cell && restore_region(x, y) > 0) {
+        cell = hashmap_get(&grid, key);
     }
 
-    struct world_cell* cell = malloc(sizeof(struct world_cell));
-    if (!cell) {
-        TraceLog(LOG_ERROR, "GRID: Failed to allocate memory for world cell.");
-        return -ENOMEM;
+    return cell;
+}
+
+int grid_page_out(int32_t center_x, int32_t center_y, int32_t distance) {
+    if (!is_initialized) {
+        TraceLog(LOG_WARNING, "GRID: Called page_out before initialization.");
+        return -ECANCELED;
     }
 
-    cell->template = room_template;
-    cell->is_model_loaded = false;
-    cell->model = (Model){0};
-    cell->grid_x = x;
-    cell->grid_y = y;
+    if (distance < 0) {
+        return -EINVAL;
+    }
 
-    if (hashmap_set(&grid, key, cell, nullptr) != 0) {
+    PROFILE_BEGIN("grid_page_out");
+    int ret = 0;
+    int paged = 0;
+
+    // Removing the current entry does not move any other, so cells can be
+    // paged out as the iteration reaches them.
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&grid, &iter, &key, &value)) {
+        struct world_cell* cell = (struct world_cell*)value;
+        if (!is_region_far(cell->grid_x, cell->grid_y, center_x, center_y,
+                           distance)) {
+            continue;
+        }
+
+        // Only templates that can be found again by id can be paged out.
+        if (room_def_get_by_id(cell->template->id) != cell->template) {
+            continue;
+        }
+
+        pthread_mutex_lock(&layout_lock);
+        ret = page_out_cell(cell);
+        if (ret == 0) {
+            hashmap_remove(&grid, key);
+        }
+        pthread_mutex_unlock(&layout_lock);
+
+        if (ret != 0) {
+            break;
+        }
+
+        grid_unload_model(cell);
         free(cell);
+        paged++;
+    }
+    PROFILE_END("grid_page_out");
+
+    if (paged > 0) {
+        TraceLog(LOG_DEBUG, "GRID: Paged out %d rooms, %zu resident.", paged,
+                 hashmap_len(&grid));
+    }
+
+    return ret != 0 ? ret : paged;
+}
+
+size_t grid_get_resident_count(void) {
+    return is_initialized ? hashmap_len(&grid) : 0;
+}
+
+size_t grid_get_paged_count(void) {
+    return is_initialized ? paged_count : 0;
+}
+
+int grid_attach_save(const struct world_file* file,
+                     const struct room_def* const* templates) {
+    if (!is_initialized) {
+        TraceLog(LOG_WARNING,
+                 "GRID: Called attach_save before initialization.");
+        return -ECANCELED;
+    }
+
+    if (!file || !templates) {
+        return -EINVAL;
+    }
+
+    if (save || hashmap_len(&grid) > 0 || hashmap_len(&regions) > 0) {
+        return -EBUSY;
+    }
+
+    size_t region_count = file->header->region_count;
+    save_faulted = calloc((region_count / 8) + 1, sizeof(uint8_t));
+    if (!save_faulted) {
+        TraceLog(LOG_ERROR,
+                 "GRID: Failed to allocate the save's region bits (out of "
+                 "memory).");
         return -ENOMEM;
     }
 
+    save = file;
+    save_templates = templates;
+    TraceLog(LOG_INFO, "GRID: Attached a save of %llu rooms in %zu regions.",
+             (unsigned long long)file->header->room_count, region_count);
+
     return 0;
 }
 
-struct world_cell* grid_get_cell(int32_t x, int32_t y) {
+const struct room_def* grid_get_saved_template(int32_t x, int32_t y) {
     if (!is_initialized) {
         return nullptr;
     }
 
-    return (struct world_cell*)hashmap_get(&grid, grid_key(x, y));
+    int32_t region_x = region_coord(x);
+    int32_t region_y = region_coord(y);
+    uint8_t offset_x = (uint8_t)(x - (region_x * GRID_REGION_SIZE));
+    uint8_t offset_y = (uint8_t)(y - (region_y * GRID_REGION_SIZE));
+
+    const struct room_def* room_template = nullptr;
+    pthread_mutex_lock(&layout_lock);
+    const struct world_cell* cell = hashmap_get(&grid, grid_key(x, y));
+    if (cell) {
+        room_template = cell->template;
+    } else {
+        const struct region* paged =
+            hashmap_get(&regions, grid_key(region_x, region_y));
+        for (uint16_t i = 0; paged && i < paged->count; i++) {
+            const struct region_room* room = &paged->rooms[i];
+            if (room->offset_x == offset_x && room->offset_y == offset_y) {
+                room_template = room_def_get_by_id(room->template_id);
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&layout_lock);
+
+    // The mapping never changes, and a room is never replaced once placed,
+    // so the save can be read without the lock.
+    if (room_template || !save) {
+        return room_template;
+    }
+
+    const struct world_file_region* region =
+        world_file_find_region(save, region_x, region_y);
+    const struct world_file_room* rooms =
+        region ? world_file_get_rooms(save, region) : nullptr;
+    if (!rooms) {
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < region->room_count; i++) {
+        if (rooms[i].offset_x == offset_x && rooms[i].offset_y == offset_y) {
+            uint16_t index = rooms[i].template_index;
+            return index < save->header->template_count ? save_templates[index]
+                                                        : nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+int grid_for_each_room(int (*visit)(int32_t x,
+                                    int32_t y,
+                                    const struct room_def* room_template,
+                                    void* context),
+                       void* context) {
+    if (!is_initialized || !visit) {
+        return -EINVAL;
+    }
+
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&grid, &iter, &key, &value)) {
+        const struct world_cell* cell = (const struct world_cell*)value;
+        int ret = visit(cell->grid_x, cell->grid_y, cell->template, context);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    iter = 0;
+    while (hashmap_iter(&regions, &iter, &key, &value)) {
+        const struct region* region = (const struct region*)value;
+        int32_t region_x = (int32_t)(uint32_t)(key >> 32U);
+        int32_t region_y = (int32_t)(uint32_t)key;
+        for (uint16_t i = 0; i < region->count; i++) {
+            const struct region_room* room = &region->rooms[i];
+            const struct room_def* room_template =
+                room_def_get_by_id(room->template_id);
+            if (!room_template) {
+                continue;
+            }
+
+            int ret = visit((region_x * GRID_REGION_SIZE) + room->offset_x,
+                            (region_y * GRID_REGION_SIZE) + room->offset_y,
+                            room_template, context);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+    }
+
+    if (!save) {
+        return 0;
+    }
+
+    // Regions of the save that were never visited only exist in the file.
+    for (uint32_t r = 0; r < save->header->region_count; r++) {
+        const struct world_file_region* region = &save->regions[r];
+        const struct world_file_room* rooms =
+            world_file_get_rooms(save, region);
+        if (is_faulted_in(region) || !rooms) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < region->room_count; i++) {
+            uint16_t index = rooms[i].template_index;
+            if (index >= save->header->template_count ||
+                !save_templates[index]) {
+                continue;
+            }
+
+            int ret = visit((region->x * GRID_REGION_SIZE) + rooms[i].offset_x,
+                            (region->y * GRID_REGION_SIZE) + rooms[i].offset_y,
+                            save_templates[index], context);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+bool grid_iter(size_t* iterator, struct world_cell** cell) {
+    if (!is_initialized || !iterator || !cell) {
+        return false;
+    }
+
+    uint64_t key = 0;
+    void* value = nullptr;
+    if (!hashmap_iter(&grid, iterator, &key, &value)) {
+        return false;
+    }
+
+    *cell = (struct world_cell*)value;
+    return true;
 }
 
 int grid_load_model(struct world_cell* cell) {
@@ -101,28 +406,288 @@ int grid_load_model(struct world_cell* cell) {
         return 0;
     }
 
-    cell->model = LoadModel(cell->template->model_path);
+    PROFILE_BEGIN("grid_load_model");
+    int ret = 0;
+    if (cell->is_model_requested) {
+        ret = model_cache_wait(cell->template, &cell->model);
+    } else {
+        ret = model_cache_acquire(cell->template, &cell->model);
+    }
+    PROFILE_END("grid_load_model");
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    cell->is_model_requested = true;
     cell->is_model_loaded = true;
 
     return 0;
 }
 
+int grid_request_model(struct world_cell* cell) {
+    if (!cell) {
+        return -EINVAL;
+    }
+
+    if (cell->is_model_loaded) {
+        return 0;
+    }
+
+    if (!cell->is_model_requested) {
+        int ret = model_cache_request(cell->template);
+        if (ret != 0) {
+            return ret;
+        }
+        cell->is_model_requested = true;
+    }
+
+    if (model_cache_get(cell->template, &cell->model)) {
+        cell->is_model_loaded = true;
+    }
+
+    return 0;
+}
+
 int grid_unload_model(struct world_cell* cell) {
     if (!cell) {
         return -EINVAL;
     }
 
-    if (!cell->is_model_loaded) {
+    if (!cell->is_model_requested) {
         return 0;
     }
 
-    UnloadModel(cell->model);
+    model_cache_release(cell->template);
     cell->model = (Model){0};
     cell->is_model_loaded = false;
+    cell->is_model_requested = false;
 
     return 0;
 }
 
+void grid_update_model_distances(int32_t center_x, int32_t center_y) {
+    if (!is_initialized) {
+        return;
+    }
+
+    model_cache_reset_distances(FLT_MAX);
+
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&grid, &iter, &key, &value)) {
+        const struct world_cell* cell = value;
+        int64_t dist_x = llabs((int64_t)cell->grid_x - center_x);
+        int64_t dist_y = llabs((int64_t)cell->grid_y - center_y);
+        model_cache_lower_distance(
+            cell->template, (float)(dist_x > dist_y ? dist_x : dist_y));
+    }
+}
+
+static int insert_cell(int32_t x,
+                       int32_t y,
+                       const struct room_def* room_template) {
+    uint64_t key = grid_key(x, y);
+    if (hashmap_get(&grid, key) != nullptr) {
+        return 0;
+    }
+
+    struct world_cell* cell = malloc(sizeof(struct world_cell));
+    if (!cell) {
+        TraceLog(LOG_ERROR, "GRID: Failed to allocate memory for world cell.");
+        return -ENOMEM;
+    }
+
+    cell->template = room_template;
+    cell->is_model_loaded = false;
+    cell->is_model_requested = false;
+    cell->model = (Model){0};
+    cell->grid_x = x;
+    cell->grid_y = y;
+    cell->visit_stamp = 0;
+
+    if (hashmap_set(&grid, key, cell, nullptr) != 0) {
+        free(cell);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+static int page_out_cell(const struct world_cell* cell) {
+    int32_t region_x = region_coord(cell->grid_x);
+    int32_t region_y = region_coord(cell->grid_y);
+    uint64_t key = grid_key(region_x, region_y);
+
+    struct region* region = hashmap_get(&regions, key);
+    if (!region || region->count == region->capacity) {
+        uint16_t capacity =
+            region ? (uint16_t)(region->capacity * 2) : INITIAL_REGION_CAPACITY;
+        struct region* grown =
+            realloc(region, sizeof(struct region) +
+                                (capacity * sizeof(struct region_room)));
+        if (!grown) {
+            TraceLog(LOG_ERROR,
+                     "GRID: Failed to allocate a region record (out of "
+                     "memory).");
+            return -ENOMEM;
+        }
+
+        if (!region) {
+            grown->count = 0;
+        }
+        grown->capacity = capacity;
+
+        // Replacing the value of an existing key never allocates, so only a
+        // new region can fail here.
+        if (hashmap_set(&regions, key, grown, nullptr) != 0) {
+            free(grown);
+            return -ENOMEM;
+        }
+        region = grown;
+    }
+
+    region->rooms[region->count++] = (struct region_room){
+        .offset_x = (uint8_t)(cell->grid_x - (region_x * GRID_REGION_SIZE)),
+        .offset_y = (uint8_t)(cell->grid_y - (region_y * GRID_REGION_SIZE)),
+        .template_id = cell->template->id,
+    };
+    paged_count++;
+
+    return 0;
+}
+
+static int restore_region(int32_t x, int32_t y) {
+    if (hashmap_len(&regions) == 0 && !save) {
+        return 0;
+    }
+
+    // A region faulted in from the save is paged out into a record like any
+    // other, so at most one of the two holds its rooms.
+    int32_t region_x = region_coord(x);
+    int32_t region_y = region_coord(y);
+    pthread_mutex_lock(&layout_lock);
+    int ret = restore_paged_region(region_x, region_y);
+    if (ret == 0) {
+        ret = fault_in_region(region_x, region_y);
+    }
+    pthread_mutex_unlock(&layout_lock);
+
+    return ret;
+}
+
+static int restore_paged_region(int32_t region_x, int32_t region_y) {
+    uint64_t key = grid_key(region_x, region_y);
+
+    struct region* region = hashmap_get(&regions, key);
+    if (!region) {
+        return 0;
+    }
+
+    // Rooms are restored from the back, so a failure leaves the rest of the
+    // record intact for the next attempt.
+    int restored = 0;
+    while (region->count > 0) {
+        const struct region_room* room = &region->rooms[region->count - 1];
+        const struct room_def* room_template =
+            room_def_get_by_id(room->template_id);
+        if (room_template) {
+            int32_t room_x = (region_x * GRID_REGION_SIZE) + room->offset_x;
+            int32_t room_y = (region_y * GRID_REGION_SIZE) + room->offset_y;
+            int ret = insert_cell(room_x, room_y, room_template);
+            if (ret != 0) {
+                TraceLog(LOG_ERROR, "GRID: Failed to restore region (%d, %d).",
+                         region_x, region_y);
+                return ret;
+            }
+        }
+
+        region->count--;
+        paged_count--;
+        restored++;
+    }
+
+    hashmap_remove(&regions, key);
+    free(region);
+
+    return restored;
+}
+
+static int fault_in_region(int32_t region_x, int32_t region_y) {
+    if (!save) {
+        return 0;
+    }
+
+    const struct world_file_region* region =
+        world_file_find_region(save, region_x, region_y);
+    if (!region || is_faulted_in(region)) {
+        return 0;
+    }
+
+    const struct world_file_room* rooms = world_file_get_rooms(save, region);
+    if (!rooms) {
+        TraceLog(LOG_WARNING, "GRID: Saved region (%d, %d) is corrupt.",
+                 region_x, region_y);
+        return 0;
+    }
+
+    // Rooms already inserted are skipped if this is retried after a failure.
+    int restored = 0;
+    for (uint32_t i = 0; i < region->room_count; i++) {
+        uint16_t index = rooms[i].template_index;
+        if (index >= save->header->template_count || !save_templates[index]) {
+            continue;
+        }
+
+        int32_t room_x = (region_x * GRID_REGION_SIZE) + rooms[i].offset_x;
+        int32_t room_y = (region_y * GRID_REGION_SIZE) + rooms[i].offset_y;
+        int ret = insert_cell(room_x, room_y, save_templates[index]);
+        if (ret != 0) {
+            TraceLog(LOG_ERROR, "GRID: Failed to fault in region (%d, %d).",
+                     region_x, region_y);
+            return ret;
+        }
+        restored++;
+    }
+
+    size_t bit = (size_t)(region - save->regions);
+    save_faulted[bit / 8] |= (uint8_t)(1U << (bit % 8));
+
+    return restored;
+}
+
+static bool is_faulted_in(const struct world_file_region* region) {
+    size_t bit = (size_t)(region - save->regions);
+    return (save_faulted[bit / 8] & (1U << (bit % 8))) != 0;
+}
+
+static bool is_region_far(int32_t x,
+                          int32_t y,
+                          int32_t center_x,
+                          int32_t center_y,
+                          int32_t distance) {
+    int64_t min_x = (int64_t)region_coord(x) * GRID_REGION_SIZE;
+    int64_t min_y = (int64_t)region_coord(y) * GRID_REGION_SIZE;
+    int64_t max_x = min_x + GRID_REGION_SIZE - 1;
+    int64_t max_y = min_y + GRID_REGION_SIZE - 1;
+
+    // Distance from the center to the nearest cell of the region, per axis.
+    int64_t dist_x = center_x < min_x   ? min_x - center_x
+                     : center_x > max_x ? center_x - max_x
+                                        : 0;
+    int64_t dist_y = center_y < min_y   ? min_y - center_y
+                     : center_y > max_y ? center_y - max_y
+                                        : 0;
+
+    return dist_x > distance || dist_y > distance;
+}
+
+static inline int32_t region_coord(int32_t v) {
+    // Rounds toward negative infinity, so every region has the same size.
+    return v >= 0 ? v / GRID_REGION_SIZE : -1 - ((-1 - v) / GRID_REGION_SIZE);
+}
+
 static inline uint64_t grid_key(int32_t x, int32_t y) {
     return ((uint64_t)(uint32_t)x << 32U) | (uint32_t)y;
 }
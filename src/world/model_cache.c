@@ -0,0 +1,725 @@
+#include "game/world/model_cache.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include "game/ds/hashmap.h"
+#include "game/profiler.h"
+#include "game/world/model_file.h"
+
+enum model_entry_state {
+    MODEL_ENTRY_STREAMING, /**< Queued for or being parsed by the worker. */
+    MODEL_ENTRY_UPLOADING, /**< Parsed, but not all meshes are uploaded. */
+    MODEL_ENTRY_READY,     /**< Parsed and uploaded to the GPU. */
+};
+
+struct model_cache_entry {
+    Model model;
+    BoundingBox bounds;
+    size_t bytes;       /**< Estimated memory of the loaded model. */
+    uint64_t last_used; /**< use_clock when the last reference was dropped. */
+    float distance;     /**< How far from the viewer its cells last were. */
+    int refcount;
+    int uploaded_meshes; /**< Meshes of model that are on the GPU. */
+    enum model_entry_state state;
+};
+
+/**
+ * A parse request handed to the streaming worker. Jobs only carry a copy of
+ * the path and the cache key, so the worker never touches cache entries.
+ */
+struct stream_job {
+    struct stream_job* next;
+    uint64_t key;
+    char* path;
+    Model model; /**< The parsed model, with no mesh uploaded yet. */
+    int result;  /**< What parsing the file returned. */
+};
+
+struct job_queue {
+    struct stream_job* head;
+    struct stream_job* tail;
+};
+
+static struct hashmap cache;
+static bool is_initialized = false;
+static size_t budget = 0;
+static size_t resident_bytes = 0;
+static uint64_t use_clock = 0;
+
+static pthread_t worker;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_signal = PTHREAD_COND_INITIALIZER;
+static struct job_queue pending_jobs;
+static struct job_queue finished_jobs;
+static bool worker_should_stop = false;
+
+// The entry whose meshes model_cache_update() was uploading when its time
+// ran out.
+static uint64_t upload_key = 0;
+static bool is_uploading = false;
+
+static inline uint64_t cache_key(const struct room_def* def);
+static struct model_cache_entry* find_or_create_entry(
+    const struct room_def* def,
+    bool* created);
+static int queue_stream_job(const struct room_def* def, uint64_t key);
+static void finish_entry(struct model_cache_entry* entry, const char* path);
+static void begin_upload(struct model_cache_entry* entry,
+                         const char* path,
+                         Model model,
+                         int result);
+static bool upload_next_mesh(struct model_cache_entry* entry);
+static struct model_cache_entry* next_upload(void);
+static void unload_entry(uint64_t key, struct model_cache_entry* entry);
+static void evict_idle_entries(void);
+static size_t estimate_model_bytes(Model model);
+static void job_queue_push(struct job_queue* queue, struct stream_job* job);
+static struct stream_job* job_queue_pop(struct job_queue* queue);
+static void free_job(struct stream_job* job);
+static void* stream_worker(void* arg);
+static int parse_file(const char* path, Model* out_model);
+static unsigned char* read_file(const char* path, size_t* data_size);
+
+int model_cache_init(void) {
+    if (is_initialized) {
+        return 0;
+    }
+
+    if (hashmap_init(&cache) != 0) {
+        return -ENOMEM;
+    }
+
+    worker_should_stop = false;
+    if (pthread_create(&worker, nullptr, stream_worker, nullptr) != 0) {
+        TraceLog(LOG_ERROR, "MODEL_CACHE: Failed to start streaming worker.");
+        hashmap_destroy(&cache);
+        return -EAGAIN;
+    }
+
+    is_initialized = true;
+
+    return 0;
+}
+
+void model_cache_destroy(void) {
+    if (!is_initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    worker_should_stop = true;
+    pthread_cond_signal(&queue_signal);
+    pthread_mutex_unlock(&queue_lock);
+    pthread_join(worker, nullptr);
+
+    struct stream_job* job = nullptr;
+    while ((job = job_queue_pop(&pending_jobs)) != nullptr) {
+        free_job(job);
+    }
+    while ((job = job_queue_pop(&finished_jobs)) != nullptr) {
+        free_job(job);
+    }
+
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&cache, &iter, &key, &value)) {
+        struct model_cache_entry* entry = (struct model_cache_entry*)value;
+        if (entry->refcount > 0) {
+            TraceLog(LOG_WARNING,
+                     "MODEL_CACHE: Destroying model with %d live references.",
+                     entry->refcount);
+        }
+        if (entry->state != MODEL_ENTRY_STREAMING) {
+            UnloadModel(entry->model);
+        }
+        free(entry);
+    }
+
+    hashmap_destroy(&cache);
+    is_uploading = false;
+    resident_bytes = 0;
+    use_clock = 0;
+    is_initialized = false;
+}
+
+int model_cache_acquire(const struct room_def* def, Model* out_model) {
+    if (!def || !out_model) {
+        return -EINVAL;
+    }
+
+    if (!is_initialized) {
+        TraceLog(LOG_WARNING,
+                 "MODEL_CACHE: Called acquire before initialization.");
+        return -ECANCELED;
+    }
+
+    bool created = false;
+    struct model_cache_entry* entry = find_or_create_entry(def, &created);
+    if (!entry) {
+        return -ENOMEM;
+    }
+
+    if (entry->state != MODEL_ENTRY_READY) {
+        finish_entry(entry, def->model_path);
+    }
+
+    entry->refcount++;
+    *out_model = entry->model;
+
+    return 0;
+}
+
+int model_cache_request(const struct room_def* def) {
+    if (!def) {
+        return -EINVAL;
+    }
+
+    if (!is_initialized) {
+        TraceLog(LOG_WARNING,
+                 "MODEL_CACHE: Called request before initialization.");
+        return -ECANCELED;
+    }
+
+    bool created = false;
+    struct model_cache_entry* entry = find_or_create_entry(def, &created);
+    if (!entry) {
+        return -ENOMEM;
+    }
+
+    if (created && queue_stream_job(def, cache_key(def)) != 0) {
+        finish_entry(entry, def->model_path);
+    }
+
+    entry->refcount++;
+
+    return 0;
+}
+
+bool model_cache_get(const struct room_def* def, Model* out_model) {
+    if (!is_initialized || !def || !out_model) {
+        return false;
+    }
+
+    const struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    if (!entry || entry->state != MODEL_ENTRY_READY) {
+        return false;
+    }
+
+    *out_model = entry->model;
+    return true;
+}
+
+bool model_cache_get_bounds(const struct room_def* def,
+                            BoundingBox* out_bounds) {
+    if (!is_initialized || !def || !out_bounds) {
+        return false;
+    }
+
+    const struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    if (!entry || entry->state != MODEL_ENTRY_READY) {
+        return false;
+    }
+
+    *out_bounds = entry->bounds;
+    return true;
+}
+
+int model_cache_wait(const struct room_def* def, Model* out_model) {
+    if (!def || !out_model) {
+        return -EINVAL;
+    }
+
+    if (!is_initialized) {
+        return -ENOENT;
+    }
+
+    struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    if (!entry) {
+        return -ENOENT;
+    }
+
+    if (entry->state != MODEL_ENTRY_READY) {
+        finish_entry(entry, def->model_path);
+    }
+
+    *out_model = entry->model;
+    return 0;
+}
+
+size_t model_cache_update(double budget_seconds) {
+    if (!is_initialized) {
+        return 0;
+    }
+
+    PROFILE_BEGIN("model_cache_update");
+    const double start = GetTime();
+    size_t finished = 0;
+
+    struct model_cache_entry* entry = nullptr;
+    while ((entry = next_upload()) != nullptr) {
+        if (upload_next_mesh(entry)) {
+            is_uploading = false;
+            finished++;
+        }
+
+        if (GetTime() - start >= budget_seconds) {
+            break;
+        }
+    }
+    PROFILE_END("model_cache_update");
+
+    return finished;
+}
+
+int model_cache_release(const struct room_def* def) {
+    if (!def) {
+        return -EINVAL;
+    }
+
+    if (!is_initialized) {
+        return -ENOENT;
+    }
+
+    uint64_t key = cache_key(def);
+    struct model_cache_entry* entry = hashmap_get(&cache, key);
+    if (!entry) {
+        return -ENOENT;
+    }
+
+    if (entry->refcount == 0) {
+        return -ENOENT;
+    }
+
+    entry->refcount--;
+    if (entry->refcount > 0) {
+        return 0;
+    }
+
+    // A model still streaming in has cost nothing yet, so there is no
+    // reason to keep it. A loaded one stays idle until the budget runs out.
+    if (entry->state != MODEL_ENTRY_READY) {
+        unload_entry(key, entry);
+        return 0;
+    }
+
+    entry->last_used = ++use_clock;
+    evict_idle_entries();
+
+    return 0;
+}
+
+void model_cache_set_budget(size_t budget_bytes) {
+    budget = budget_bytes;
+    if (is_initialized) {
+        evict_idle_entries();
+    }
+}
+
+void model_cache_set_distance(const struct room_def* def, float distance) {
+    if (!is_initialized || !def) {
+        return;
+    }
+
+    struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    if (entry) {
+        entry->distance = distance;
+    }
+}
+
+void model_cache_reset_distances(float distance) {
+    if (!is_initialized) {
+        return;
+    }
+
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    while (hashmap_iter(&cache, &iter, &key, &value)) {
+        ((struct model_cache_entry*)value)->distance = distance;
+    }
+}
+
+void model_cache_lower_distance(const struct room_def* def, float distance) {
+    if (!is_initialized || !def) {
+        return;
+    }
+
+    struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    if (entry && distance < entry->distance) {
+        entry->distance = distance;
+    }
+}
+
+size_t model_cache_get_resident_bytes(void) {
+    return resident_bytes;
+}
+
+size_t model_cache_get_count(void) {
+    return is_initialized ? hashmap_len(&cache) : 0;
+}
+
+int model_cache_get_refcount(const struct room_def* def) {
+    if (!is_initialized || !def) {
+        return 0;
+    }
+
+    const struct model_cache_entry* entry = hashmap_get(&cache, cache_key(def));
+    return entry ? entry->refcount : 0;
+}
+
+static inline uint64_t cache_key(const struct room_def* def) {
+    return (uint64_t)(uintptr_t)def;
+}
+
+static struct model_cache_entry* find_or_create_entry(
+    const struct room_def* def,
+    bool* created) {
+    uint64_t key = cache_key(def);
+    struct model_cache_entry* entry = hashmap_get(&cache, key);
+
+    *created = false;
+    if (entry) {
+        return entry;
+    }
+
+    entry = malloc(sizeof(struct model_cache_entry));
+    if (!entry) {
+        TraceLog(LOG_ERROR,
+                 "MODEL_CACHE: Failed to allocate memory for cache entry.");
+        return nullptr;
+    }
+
+    entry->model = (Model){0};
+    entry->bytes = 0;
+    entry->last_used = 0;
+    entry->distance = 0.0F;
+    entry->refcount = 0;
+    entry->uploaded_meshes = 0;
+    entry->state = MODEL_ENTRY_STREAMING;
+
+    if (hashmap_set(&cache, key, entry, nullptr) != 0) {
+        free(entry);
+        return nullptr;
+    }
+
+    *created = true;
+    return entry;
+}
+
+static int queue_stream_job(const struct room_def* def, uint64_t key) {
+    struct stream_job* job = calloc(1, sizeof(struct stream_job));
+    if (!job) {
+        return -ENOMEM;
+    }
+
+    job->key = key;
+    job->path = strdup(def->model_path);
+    if (!job->path) {
+        free(job);
+        return -ENOMEM;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    job_queue_push(&pending_jobs, job);
+    pthread_cond_signal(&queue_signal);
+    pthread_mutex_unlock(&queue_lock);
+
+    return 0;
+}
+
+/**
+ * Finishes a model on the calling (GL) thread, parsing it there first if the
+ * worker has not handed it over yet.
+ */
+static void finish_entry(struct model_cache_entry* entry, const char* path) {
+    if (entry->state == MODEL_ENTRY_STREAMING) {
+        Model model = {0};
+        int result = parse_file(path, &model);
+        begin_upload(entry, path, model, result);
+    }
+
+    while (!upload_next_mesh(entry)) {
+    }
+}
+
+/**
+ * Hands a parsed model to its entry. A file that cannot be parsed leaves the
+ * entry with an empty model, so it is not requested over and over.
+ */
+static void begin_upload(struct model_cache_entry* entry,
+                         const char* path,
+                         Model model,
+                         int result) {
+    if (result != 0) {
+        TraceLog(LOG_WARNING, "MODEL_CACHE: Failed to load model '%s'.",
+                 path);
+        model = (Model){.transform = MatrixIdentity()};
+    }
+
+    entry->model = model;
+    entry->uploaded_meshes = 0;
+    entry->state = MODEL_ENTRY_UPLOADING;
+}
+
+/**
+ * Uploads the next mesh of an entry, and marks the entry ready once all of
+ * its meshes are on the GPU.
+ * @return true if the entry became ready.
+ */
+static bool upload_next_mesh(struct model_cache_entry* entry) {
+    if (entry->uploaded_meshes < entry->model.meshCount) {
+        PROFILE_BEGIN("model_upload");
+        UploadMesh(&entry->model.meshes[entry->uploaded_meshes], false);
+        PROFILE_END("model_upload");
+        entry->uploaded_meshes++;
+    }
+
+    if (entry->uploaded_meshes < entry->model.meshCount) {
+        return false;
+    }
+
+    entry->bounds = GetModelBoundingBox(entry->model);
+    entry->bytes = estimate_model_bytes(entry->model);
+    entry->state = MODEL_ENTRY_READY;
+    resident_bytes += entry->bytes;
+
+    return true;
+}
+
+/**
+ * Picks the entry to upload a mesh of: the one the last update ran out of
+ * time on, or else the next one the worker has parsed. Parsed models of
+ * entries that were released or finished synchronously meanwhile are
+ * dropped.
+ */
+static struct model_cache_entry* next_upload(void) {
+    if (is_uploading) {
+        struct model_cache_entry* entry = hashmap_get(&cache, upload_key);
+        if (entry && entry->state == MODEL_ENTRY_UPLOADING) {
+            return entry;
+        }
+        is_uploading = false;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        struct stream_job* job = job_queue_pop(&finished_jobs);
+        pthread_mutex_unlock(&queue_lock);
+
+        if (!job) {
+            return nullptr;
+        }
+
+        struct model_cache_entry* entry = hashmap_get(&cache, job->key);
+        if (entry && entry->state == MODEL_ENTRY_STREAMING) {
+            begin_upload(entry, job->path, job->model, job->result);
+            job->model = (Model){0};
+            upload_key = job->key;
+            is_uploading = true;
+        }
+        free_job(job);
+
+        if (is_uploading) {
+            return entry;
+        }
+    }
+}
+
+static void unload_entry(uint64_t key, struct model_cache_entry* entry) {
+    hashmap_remove(&cache, key);
+    if (entry->state != MODEL_ENTRY_STREAMING) {
+        UnloadModel(entry->model);
+    }
+    if (entry->state == MODEL_ENTRY_READY) {
+        resident_bytes -= entry->bytes;
+    }
+    free(entry);
+}
+
+/**
+ * Unloads idle models until the resident ones fit in the budget. Models whose
+ * cells were furthest from the viewer go first, and the least recently used
+ * one among equally distant models. Models in use are never evicted, so the
+ * budget may stay exceeded.
+ */
+static void evict_idle_entries(void) {
+    while (resident_bytes > budget) {
+        struct model_cache_entry* victim = nullptr;
+        uint64_t victim_key = 0;
+
+        size_t iter = 0;
+        uint64_t key = 0;
+        void* value = nullptr;
+        while (hashmap_iter(&cache, &iter, &key, &value)) {
+            struct model_cache_entry* entry = value;
+            if (entry->refcount > 0 || entry->state != MODEL_ENTRY_READY) {
+                continue;
+            }
+            if (!victim || entry->distance > victim->distance ||
+                (entry->distance == victim->distance &&
+                 entry->last_used < victim->last_used)) {
+                victim = entry;
+                victim_key = key;
+            }
+        }
+
+        if (!victim) {
+            return;
+        }
+
+        unload_entry(victim_key, victim);
+    }
+}
+
+/**
+ * Estimates the memory of a model: its vertex data, which raylib keeps in RAM
+ * as well as in GPU buffers, plus the textures of its materials.
+ */
+static size_t estimate_model_bytes(Model model) {
+    size_t vertex_bytes = 0;
+
+    for (int i = 0; i < model.meshCount; i++) {
+        const Mesh* mesh = &model.meshes[i];
+        size_t vertices = (size_t)mesh->vertexCount;
+        size_t floats_per_vertex = 3 + (mesh->texcoords ? 2 : 0) +
+                                   (mesh->texcoords2 ? 2 : 0) +
+                                   (mesh->normals ? 3 : 0) +
+                                   (mesh->tangents ? 4 : 0);
+        vertex_bytes += vertices * floats_per_vertex * sizeof(float);
+        if (mesh->colors) {
+            vertex_bytes += vertices * 4;
+        }
+        if (mesh->indices) {
+            vertex_bytes +=
+                (size_t)mesh->triangleCount * 3 * sizeof(unsigned short);
+        }
+    }
+
+    size_t bytes = 2 * vertex_bytes;
+    for (int i = 0; i < model.materialCount; i++) {
+        const Material* material = &model.materials[i];
+        if (!material->maps) {
+            continue;
+        }
+        Texture2D texture = material->maps[MATERIAL_MAP_DIFFUSE].texture;
+        if (texture.id != 0 && texture.id != rlGetTextureIdDefault()) {
+            bytes += (size_t)GetPixelDataSize(texture.width, texture.height,
+                                              texture.format);
+        }
+    }
+
+    return bytes;
+}
+
+static void job_queue_push(struct job_queue* queue, struct stream_job* job) {
+    job->next = nullptr;
+    if (queue->tail) {
+        queue->tail->next = job;
+    } else {
+        queue->head = job;
+    }
+    queue->tail = job;
+}
+
+static struct stream_job* job_queue_pop(struct job_queue* queue) {
+    struct stream_job* job = queue->head;
+    if (!job) {
+        return nullptr;
+    }
+
+    queue->head = job->next;
+    if (!queue->head) {
+        queue->tail = nullptr;
+    }
+    job->next = nullptr;
+
+    return job;
+}
+
+/**
+ * Frees a job and any model it still holds. The model has no GPU buffers
+ * yet, but UnloadModel() is only ever called on the main thread.
+ */
+static void free_job(struct stream_job* job) {
+    if (job->model.meshes || job->model.materials) {
+        UnloadModel(job->model);
+    }
+    free(job->path);
+    free(job);
+}
+
+static void* stream_worker(void* arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&queue_lock);
+    for (;;) {
+        while (!worker_should_stop && !pending_jobs.head) {
+            pthread_cond_wait(&queue_signal, &queue_lock);
+        }
+
+        if (worker_should_stop) {
+            break;
+        }
+
+        struct stream_job* job = job_queue_pop(&pending_jobs);
+        pthread_mutex_unlock(&queue_lock);
+
+        job->result = parse_file(job->path, &job->model);
+
+        pthread_mutex_lock(&queue_lock);
+        job_queue_push(&finished_jobs, job);
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return nullptr;
+}
+
+static int parse_file(const char* path, Model* out_model) {
+    size_t data_size = 0;
+    unsigned char* data = read_file(path, &data_size);
+    if (!data) {
+        *out_model = (Model){0};
+        return -ENOENT;
+    }
+
+    int ret = model_file_parse(data, data_size, out_model);
+    free(data);
+
+    return ret;
+}
+
+static unsigned char* read_file(const char* path, size_t* data_size) {
+    *data_size = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return nullptr;
+    }
+
+    unsigned char* data = nullptr;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = malloc((size_t)size);
+            if (data && fread(data, 1, (size_t)size, file) == (size_t)size) {
+                *data_size = (size_t)size;
+            } else {
+                free(data);
+                data = nullptr;
+            }
+        }
+    }
+
+    (void)fclose(file);
+    return data;
+}
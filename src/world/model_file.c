@@ -0,0 +1,969 @@
+#include "game/world/model_file.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+#include "raymath.h"
+
+enum {
+    GLB_MAGIC = 0x46546C67,      /**< "glTF" */
+    GLB_VERSION = 2,
+    GLB_CHUNK_JSON = 0x4E4F534A, /**< "JSON" */
+    GLB_CHUNK_BIN = 0x004E4942,  /**< "BIN\0" */
+    GLB_HEADER_SIZE = 12,
+    GLB_CHUNK_HEADER_SIZE = 8,
+};
+
+enum {
+    GLTF_UNSIGNED_BYTE = 5121,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT = 5125,
+    GLTF_FLOAT = 5126,
+    GLTF_TRIANGLES = 4,
+};
+
+enum {
+    MAX_JSON_DEPTH = 64,     /**< Deepest nesting of JSON values accepted. */
+    MAX_NUMBER_LENGTH = 63,  /**< Longest JSON number accepted. */
+    INITIAL_TOKEN_COUNT = 256,
+};
+
+enum json_type {
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE,
+};
+
+/**
+ * A value of the JSON chunk. The members of an object or array follow it
+ * directly in the token list, and an object member is its key followed by
+ * its value.
+ */
+struct json_token {
+    enum json_type type;
+    int start; /**< First character, inside the quotes for strings. */
+    int end;   /**< One past the last character. */
+    int size;  /**< Number of members of an object or array. */
+    int next;  /**< Index of the token after this value and its members. */
+};
+
+struct gltf {
+    const char* json;
+    int json_size;
+    struct json_token* tokens;
+    int token_count;
+    int token_capacity;
+    const unsigned char* bin;
+    size_t bin_size;
+    int root;
+};
+
+/**
+ * Where the elements of an accessor are in the binary chunk. Elements are
+ * stride bytes apart.
+ */
+struct accessor {
+    const unsigned char* data;
+    size_t stride;
+    int count;
+    int component_type;
+};
+
+static int read_chunks(struct gltf* gltf,
+                       const unsigned char* data,
+                       size_t size);
+static uint32_t read_u32(const unsigned char* data);
+static int parse_json(struct gltf* gltf);
+static int parse_value(struct gltf* gltf, int* pos, int depth);
+static void skip_whitespace(const struct gltf* gltf, int* pos);
+static bool is_whitespace(char c);
+static int push_token(struct gltf* gltf);
+static int find_member(const struct gltf* gltf, int object, const char* key);
+static int find_element(const struct gltf* gltf, int array, int index);
+static int count_elements(const struct gltf* gltf, int object, const char* key);
+static int get_number(const struct gltf* gltf, int token, double* out);
+static int get_index(const struct gltf* gltf,
+                     int object,
+                     const char* key,
+                     int count,
+                     int* out);
+static int get_floats(const struct gltf* gltf,
+                      int object,
+                      const char* key,
+                      float* out,
+                      int count);
+static int get_accessor(const struct gltf* gltf,
+                        int index,
+                        const char* type,
+                        struct accessor* out);
+static int get_node_transforms(const struct gltf* gltf, Matrix* transforms);
+static int get_local_transform(const struct gltf* gltf,
+                               int node,
+                               Matrix* out);
+static int load_materials(const struct gltf* gltf, Model* model);
+static int load_meshes(const struct gltf* gltf,
+                       const Matrix* transforms,
+                       Model* model);
+static int load_primitive(const struct gltf* gltf,
+                          int primitive,
+                          Matrix transform,
+                          Mesh* mesh);
+static int load_indices(const struct gltf* gltf, int primitive, Mesh* mesh);
+static void read_floats(const struct accessor* accessor,
+                        int index,
+                        float* out,
+                        int count);
+static void free_model(Model* model);
+
+int model_file_parse(const unsigned char* data, size_t size, Model* out_model) {
+    *out_model = (Model){0};
+    if (!data) {
+        return -EINVAL;
+    }
+
+    struct gltf gltf = {0};
+    Model model = {.transform = MatrixIdentity()};
+    Matrix* transforms = nullptr;
+
+    int ret = read_chunks(&gltf, data, size);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = parse_json(&gltf);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    int node_count = count_elements(&gltf, gltf.root, "nodes");
+    transforms = malloc(((size_t)node_count + 1) * sizeof(Matrix));
+    if (!transforms) {
+        ret = -ENOMEM;
+        goto cleanup;
+    }
+
+    ret = get_node_transforms(&gltf, transforms);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = load_materials(&gltf, &model);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = load_meshes(&gltf, transforms, &model);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    *out_model = model;
+
+cleanup:
+    if (ret != 0) {
+        free_model(&model);
+    }
+    free(transforms);
+    free(gltf.tokens);
+
+    return ret;
+}
+
+static int read_chunks(struct gltf* gltf,
+                       const unsigned char* data,
+                       size_t size) {
+    if (size < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE ||
+        read_u32(data) != GLB_MAGIC || read_u32(data + 4) != GLB_VERSION ||
+        read_u32(data + 8) > size) {
+        return -EINVAL;
+    }
+
+    size = read_u32(data + 8);
+    size_t offset = GLB_HEADER_SIZE;
+    while (size - offset >= GLB_CHUNK_HEADER_SIZE) {
+        size_t length = read_u32(data + offset);
+        uint32_t type = read_u32(data + offset + 4);
+        offset += GLB_CHUNK_HEADER_SIZE;
+        if (length > size - offset) {
+            return -EINVAL;
+        }
+
+        // The JSON chunk always comes first, and the binary one second.
+        if (!gltf->json && type == GLB_CHUNK_JSON && length <= INT32_MAX) {
+            gltf->json = (const char*)(data + offset);
+            gltf->json_size = (int)length;
+        } else if (gltf->json && !gltf->bin && type == GLB_CHUNK_BIN) {
+            gltf->bin = data + offset;
+            gltf->bin_size = length;
+        } else if (!gltf->json) {
+            return -EINVAL;
+        }
+
+        offset += length;
+    }
+
+    return gltf->json ? 0 : -EINVAL;
+}
+
+static uint32_t read_u32(const unsigned char* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static int parse_json(struct gltf* gltf) {
+    int pos = 0;
+    int ret = parse_value(gltf, &pos, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    skip_whitespace(gltf, &pos);
+    if (pos != gltf->json_size || gltf->tokens[0].type != JSON_OBJECT) {
+        return -EINVAL;
+    }
+
+    gltf->root = 0;
+    return 0;
+}
+
+/**
+ * Appends the value at pos and all of its members to the token list. Strings
+ * are kept escaped, since only keys and accessor types are ever compared and
+ * neither contains escapes.
+ */
+static int parse_value(struct gltf* gltf, int* pos, int depth) {
+    skip_whitespace(gltf, pos);
+    if (*pos >= gltf->json_size || depth > MAX_JSON_DEPTH) {
+        return -EINVAL;
+    }
+
+    int index = push_token(gltf);
+    if (index < 0) {
+        return index;
+    }
+
+    const char* json = gltf->json;
+    struct json_token token = {.start = *pos};
+    char c = json[*pos];
+
+    if (c == '{' || c == '[') {
+        bool is_object = c == '{';
+        char close = is_object ? '}' : ']';
+        token.type = is_object ? JSON_OBJECT : JSON_ARRAY;
+        (*pos)++;
+
+        skip_whitespace(gltf, pos);
+        if (*pos < gltf->json_size && json[*pos] == close) {
+            (*pos)++;
+        } else {
+            for (;;) {
+                if (is_object) {
+                    skip_whitespace(gltf, pos);
+                    if (*pos >= gltf->json_size || json[*pos] != '"') {
+                        return -EINVAL;
+                    }
+
+                    int ret = parse_value(gltf, pos, depth + 1);
+                    if (ret != 0) {
+                        return ret;
+                    }
+
+                    skip_whitespace(gltf, pos);
+                    if (*pos >= gltf->json_size || json[*pos] != ':') {
+                        return -EINVAL;
+                    }
+                    (*pos)++;
+                }
+
+                int ret = parse_value(gltf, pos, depth + 1);
+                if (ret != 0) {
+                    return ret;
+                }
+                token.size++;
+
+                skip_whitespace(gltf, pos);
+                if (*pos >= gltf->json_size) {
+                    return -EINVAL;
+                }
+                if (json[*pos] == close) {
+                    (*pos)++;
+                    break;
+                }
+                if (json[*pos] != ',') {
+                    return -EINVAL;
+                }
+                (*pos)++;
+            }
+        }
+    } else if (c == '"') {
+        token.type = JSON_STRING;
+        token.start = ++(*pos);
+        while (*pos < gltf->json_size && json[*pos] != '"') {
+            *pos += json[*pos] == '\\' ? 2 : 1;
+        }
+        if (*pos >= gltf->json_size) {
+            return -EINVAL;
+        }
+        token.end = (*pos)++;
+    } else {
+        token.type = JSON_PRIMITIVE;
+        while (*pos < gltf->json_size && !is_whitespace(json[*pos]) &&
+               json[*pos] != ',' && json[*pos] != ']' && json[*pos] != '}') {
+            (*pos)++;
+        }
+        if (*pos == token.start) {
+            return -EINVAL;
+        }
+    }
+
+    if (token.type != JSON_STRING) {
+        token.end = *pos;
+    }
+    token.next = gltf->token_count;
+    gltf->tokens[index] = token;
+
+    return 0;
+}
+
+static void skip_whitespace(const struct gltf* gltf, int* pos) {
+    while (*pos < gltf->json_size && is_whitespace(gltf->json[*pos])) {
+        (*pos)++;
+    }
+}
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int push_token(struct gltf* gltf) {
+    if (gltf->token_count == gltf->token_capacity) {
+        int capacity = gltf->token_capacity ? gltf->token_capacity * 2
+                                            : INITIAL_TOKEN_COUNT;
+        struct json_token* tokens =
+            realloc(gltf->tokens, (size_t)capacity * sizeof(*tokens));
+        if (!tokens) {
+            return -ENOMEM;
+        }
+        gltf->tokens = tokens;
+        gltf->token_capacity = capacity;
+    }
+
+    return gltf->token_count++;
+}
+
+/** Returns the value of an object's member, or -1 if it has none. */
+static int find_member(const struct gltf* gltf, int object, const char* key) {
+    if (object < 0 || gltf->tokens[object].type != JSON_OBJECT) {
+        return -1;
+    }
+
+    size_t key_length = strlen(key);
+    int token = object + 1;
+    for (int i = 0; i < gltf->tokens[object].size; i++) {
+        const struct json_token* name = &gltf->tokens[token];
+        int value = token + 1;
+        if ((size_t)(name->end - name->start) == key_length &&
+            memcmp(gltf->json + name->start, key, key_length) == 0) {
+            return value;
+        }
+        token = gltf->tokens[value].next;
+    }
+
+    return -1;
+}
+
+/** Returns an element of an array, or -1 if it is out of range. */
+static int find_element(const struct gltf* gltf, int array, int index) {
+    if (array < 0 || gltf->tokens[array].type != JSON_ARRAY || index < 0 ||
+        index >= gltf->tokens[array].size) {
+        return -1;
+    }
+
+    int token = array + 1;
+    for (int i = 0; i < index; i++) {
+        token = gltf->tokens[token].next;
+    }
+
+    return token;
+}
+
+static int count_elements(const struct gltf* gltf,
+                          int object,
+                          const char* key) {
+    int array = find_member(gltf, object, key);
+    if (array < 0 || gltf->tokens[array].type != JSON_ARRAY) {
+        return 0;
+    }
+
+    return gltf->tokens[array].size;
+}
+
+static int get_number(const struct gltf* gltf, int token, double* out) {
+    const struct json_token* value = &gltf->tokens[token];
+    int length = value->end - value->start;
+    if (value->type != JSON_PRIMITIVE || length > MAX_NUMBER_LENGTH) {
+        return -EINVAL;
+    }
+
+    // The chunk is not NUL-terminated, so strtod() gets a copy.
+    char text[MAX_NUMBER_LENGTH + 1];
+    memcpy(text, gltf->json + value->start, (size_t)length);
+    text[length] = '\0';
+
+    char* end = nullptr;
+    *out = strtod(text, &end);
+
+    return end == text + length && isfinite(*out) ? 0 : -EINVAL;
+}
+
+/**
+ * Reads an index into an array of count elements. A missing member leaves
+ * -1 in out; one that is not a valid index is an error.
+ */
+static int get_index(const struct gltf* gltf,
+                     int object,
+                     const char* key,
+                     int count,
+                     int* out) {
+    *out = -1;
+
+    int token = find_member(gltf, object, key);
+    if (token < 0) {
+        return 0;
+    }
+
+    double value = 0.0;
+    if (get_number(gltf, token, &value) != 0 || value < 0.0 ||
+        value >= count || value != (int)value) {
+        return -EINVAL;
+    }
+
+    *out = (int)value;
+    return 0;
+}
+
+/**
+ * Reads an array of exactly count numbers. A missing member leaves out
+ * untouched, so it can hold the default.
+ */
+static int get_floats(const struct gltf* gltf,
+                      int object,
+                      const char* key,
+                      float* out,
+                      int count) {
+    int array = find_member(gltf, object, key);
+    if (array < 0) {
+        return 0;
+    }
+
+    if (gltf->tokens[array].type != JSON_ARRAY ||
+        gltf->tokens[array].size != count) {
+        return -EINVAL;
+    }
+
+    int token = array + 1;
+    for (int i = 0; i < count; i++) {
+        double value = 0.0;
+        if (get_number(gltf, token, &value) != 0) {
+            return -EINVAL;
+        }
+        out[i] = (float)value;
+        token = gltf->tokens[token].next;
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up an accessor and checks that all of its elements lie within the
+ * binary chunk. The element type must match, and only float elements are
+ * accepted unless it is a "SCALAR".
+ */
+static int get_accessor(const struct gltf* gltf,
+                        int index,
+                        const char* type,
+                        struct accessor* out) {
+    int accessors = find_member(gltf, gltf->root, "accessors");
+    int accessor = find_element(gltf, accessors, index);
+    int type_token = find_member(gltf, accessor, "type");
+    if (accessor < 0 || type_token < 0 ||
+        find_member(gltf, accessor, "sparse") >= 0) {
+        return -EINVAL;
+    }
+
+    const struct json_token* name = &gltf->tokens[type_token];
+    if (name->type != JSON_STRING ||
+        (size_t)(name->end - name->start) != strlen(type) ||
+        memcmp(gltf->json + name->start, type, strlen(type)) != 0) {
+        return -EINVAL;
+    }
+
+    bool is_scalar = strcmp(type, "SCALAR") == 0;
+    size_t components = is_scalar ? 1 : (size_t)(type[3] - '0');
+
+    double component_type = 0.0;
+    double count = 0.0;
+    double offset = 0.0;
+    int token = find_member(gltf, accessor, "componentType");
+    if (token < 0 || get_number(gltf, token, &component_type) != 0) {
+        return -EINVAL;
+    }
+    token = find_member(gltf, accessor, "count");
+    if (token < 0 || get_number(gltf, token, &count) != 0 || count < 1.0 ||
+        count > INT32_MAX) {
+        return -EINVAL;
+    }
+    token = find_member(gltf, accessor, "byteOffset");
+    if (token >= 0 && (get_number(gltf, token, &offset) != 0 || offset < 0.0)) {
+        return -EINVAL;
+    }
+
+    size_t component_size = 0;
+    switch ((int)component_type) {
+        case GLTF_UNSIGNED_BYTE:
+            component_size = is_scalar ? 1 : 0;
+            break;
+        case GLTF_UNSIGNED_SHORT:
+            component_size = is_scalar ? 2 : 0;
+            break;
+        case GLTF_UNSIGNED_INT:
+            component_size = is_scalar ? 4 : 0;
+            break;
+        case GLTF_FLOAT:
+            component_size = sizeof(float);
+            break;
+        default:
+            break;
+    }
+    if (component_size == 0) {
+        return -EINVAL;
+    }
+
+    int view_index = -1;
+    if (get_index(gltf, accessor, "bufferView",
+                  count_elements(gltf, gltf->root, "bufferViews"),
+                  &view_index) != 0 ||
+        view_index < 0) {
+        return -EINVAL;
+    }
+
+    int view = find_element(
+        gltf, find_member(gltf, gltf->root, "bufferViews"), view_index);
+    int buffer = -1;
+    double view_offset = 0.0;
+    double view_length = 0.0;
+    double stride = 0.0;
+    if (get_index(gltf, view, "buffer",
+                  count_elements(gltf, gltf->root, "buffers"), &buffer) != 0 ||
+        buffer != 0) {
+        return -EINVAL;
+    }
+    token = find_member(gltf, view, "byteLength");
+    if (token < 0 || get_number(gltf, token, &view_length) != 0) {
+        return -EINVAL;
+    }
+    token = find_member(gltf, view, "byteOffset");
+    if (token >= 0 && get_number(gltf, token, &view_offset) != 0) {
+        return -EINVAL;
+    }
+    token = find_member(gltf, view, "byteStride");
+    if (token >= 0 && get_number(gltf, token, &stride) != 0) {
+        return -EINVAL;
+    }
+
+    // Only the buffer stored in the file itself can be read.
+    int buffer_token = find_element(
+        gltf, find_member(gltf, gltf->root, "buffers"), buffer);
+    if (!gltf->bin || find_member(gltf, buffer_token, "uri") >= 0) {
+        return -EINVAL;
+    }
+
+    size_t element_size = components * component_size;
+    if (stride == 0.0) {
+        stride = (double)element_size;
+    }
+    double end = offset + (stride * (count - 1.0)) + (double)element_size;
+    if (view_offset < 0.0 || view_length < 0.0 ||
+        view_offset + view_length > (double)gltf->bin_size ||
+        stride < (double)element_size || end > view_length) {
+        return -EINVAL;
+    }
+
+    *out = (struct accessor){
+        .data = gltf->bin + (size_t)view_offset + (size_t)offset,
+        .stride = (size_t)stride,
+        .count = (int)count,
+        .component_type = (int)component_type,
+    };
+    return 0;
+}
+
+/**
+ * Computes the world transform of every node. Entry node_count holds the
+ * identity, so parentless nodes can refer to it.
+ */
+static int get_node_transforms(const struct gltf* gltf, Matrix* transforms) {
+    int nodes = find_member(gltf, gltf->root, "nodes");
+    int node_count = count_elements(gltf, gltf->root, "nodes");
+
+    int* parents = malloc(((size_t)node_count + 1) * sizeof(int));
+    if (!parents) {
+        return -ENOMEM;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < node_count; i++) {
+        parents[i] = node_count;
+    }
+
+    for (int i = 0; i < node_count && ret == 0; i++) {
+        int node = find_element(gltf, nodes, i);
+        int children = find_member(gltf, node, "children");
+        int child_count = children < 0 ? 0 : gltf->tokens[children].size;
+        int child = children + 1;
+        for (int c = 0; c < child_count && ret == 0; c++) {
+            double value = 0.0;
+            if (get_number(gltf, child, &value) != 0 || value < 0.0 ||
+                value >= node_count || parents[(int)value] != node_count ||
+                (int)value == i) {
+                ret = -EINVAL;
+            } else {
+                parents[(int)value] = i;
+            }
+            child = gltf->tokens[child].next;
+        }
+    }
+
+    transforms[node_count] = MatrixIdentity();
+    for (int i = 0; i < node_count && ret == 0; i++) {
+        ret = get_local_transform(gltf, find_element(gltf, nodes, i),
+                                  &transforms[i]);
+
+        // Walk up to the root. A chain longer than the node count is a cycle.
+        int parent = parents[i];
+        for (int depth = 0; parent != node_count && ret == 0; depth++) {
+            Matrix local = MatrixIdentity();
+            ret = depth < node_count
+                      ? get_local_transform(
+                            gltf, find_element(gltf, nodes, parent), &local)
+                      : -EINVAL;
+            transforms[i] = MatrixMultiply(transforms[i], local);
+            parent = parents[parent];
+        }
+    }
+
+    free(parents);
+    return ret;
+}
+
+static int get_local_transform(const struct gltf* gltf,
+                               int node,
+                               Matrix* out) {
+    float matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    float translation[3] = {0, 0, 0};
+    float rotation[4] = {0, 0, 0, 1};
+    float scale[3] = {1, 1, 1};
+
+    if (get_floats(gltf, node, "matrix", matrix, 16) != 0 ||
+        get_floats(gltf, node, "translation", translation, 3) != 0 ||
+        get_floats(gltf, node, "rotation", rotation, 4) != 0 ||
+        get_floats(gltf, node, "scale", scale, 3) != 0) {
+        return -EINVAL;
+    }
+
+    // glTF matrices are column-major, like the fields of a raylib Matrix.
+    Matrix base = {
+        matrix[0], matrix[4], matrix[8],  matrix[12],
+        matrix[1], matrix[5], matrix[9],  matrix[13],
+        matrix[2], matrix[6], matrix[10], matrix[14],
+        matrix[3], matrix[7], matrix[11], matrix[15],
+    };
+    Quaternion quaternion = {rotation[0], rotation[1], rotation[2],
+                             rotation[3]};
+    Matrix trs = MatrixMultiply(
+        MatrixMultiply(MatrixScale(scale[0], scale[1], scale[2]),
+                       QuaternionToMatrix(quaternion)),
+        MatrixTranslate(translation[0], translation[1], translation[2]));
+
+    *out = MatrixMultiply(trs, base);
+    return 0;
+}
+
+/**
+ * Creates the default material followed by one material per glTF material,
+ * as LoadModel() does. LoadMaterialDefault() only reads the ids of rlgl's
+ * default shader and texture, so it is safe off the main thread.
+ */
+static int load_materials(const struct gltf* gltf, Model* model) {
+    int materials = find_member(gltf, gltf->root, "materials");
+    int count = count_elements(gltf, gltf->root, "materials");
+
+    model->materials = calloc((size_t)count + 1, sizeof(Material));
+    if (!model->materials) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i <= count; i++) {
+        model->materials[i] = LoadMaterialDefault();
+        if (!model->materials[i].maps) {
+            return -ENOMEM;
+        }
+        model->materialCount++;
+
+        if (i == 0) {
+            continue;
+        }
+
+        float color[4] = {1, 1, 1, 1};
+        int pbr = find_member(gltf, find_element(gltf, materials, i - 1),
+                              "pbrMetallicRoughness");
+        if (get_floats(gltf, pbr, "baseColorFactor", color, 4) != 0) {
+            return -EINVAL;
+        }
+
+        model->materials[i].maps[MATERIAL_MAP_ALBEDO].color = (Color){
+            (unsigned char)(Clamp(color[0], 0.0F, 1.0F) * 255.0F),
+            (unsigned char)(Clamp(color[1], 0.0F, 1.0F) * 255.0F),
+            (unsigned char)(Clamp(color[2], 0.0F, 1.0F) * 255.0F),
+            (unsigned char)(Clamp(color[3], 0.0F, 1.0F) * 255.0F),
+        };
+    }
+
+    return 0;
+}
+
+static int load_meshes(const struct gltf* gltf,
+                       const Matrix* transforms,
+                       Model* model) {
+    int nodes = find_member(gltf, gltf->root, "nodes");
+    int node_count = count_elements(gltf, gltf->root, "nodes");
+    int meshes = find_member(gltf, gltf->root, "meshes");
+    int mesh_count = count_elements(gltf, gltf->root, "meshes");
+    int material_count = model->materialCount - 1;
+
+    // Primitives that are not triangles are skipped, as raylib does.
+    int total = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            if (total == 0) {
+                return 0;
+            }
+            model->meshes = calloc((size_t)total, sizeof(Mesh));
+            model->meshMaterial = calloc((size_t)total, sizeof(int));
+            if (!model->meshes || !model->meshMaterial) {
+                return -ENOMEM;
+            }
+        }
+
+        for (int i = 0; i < node_count; i++) {
+            int mesh = -1;
+            int ret = get_index(gltf, find_element(gltf, nodes, i), "mesh",
+                                mesh_count, &mesh);
+            if (ret != 0) {
+                return ret;
+            }
+            if (mesh < 0) {
+                continue;
+            }
+
+            int primitives =
+                find_member(gltf, find_element(gltf, meshes, mesh),
+                            "primitives");
+            int primitive_count =
+                primitives < 0 ? 0 : gltf->tokens[primitives].size;
+            int primitive = primitives + 1;
+            for (int p = 0; p < primitive_count; p++) {
+                double mode = GLTF_TRIANGLES;
+                int mode_token = find_member(gltf, primitive, "mode");
+                if (mode_token >= 0 &&
+                    get_number(gltf, mode_token, &mode) != 0) {
+                    return -EINVAL;
+                }
+
+                if (mode == GLTF_TRIANGLES && pass == 0) {
+                    total++;
+                } else if (mode == GLTF_TRIANGLES) {
+                    // Counted before it is filled in, so free_model() also
+                    // frees a mesh that fails halfway.
+                    int index = model->meshCount++;
+                    int material = -1;
+                    ret = get_index(gltf, primitive, "material",
+                                    material_count, &material);
+                    if (ret == 0) {
+                        ret = load_primitive(gltf, primitive, transforms[i],
+                                             &model->meshes[index]);
+                    }
+                    if (ret != 0) {
+                        return ret;
+                    }
+                    model->meshMaterial[index] = material + 1;
+                }
+
+                primitive = gltf->tokens[primitive].next;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int load_primitive(const struct gltf* gltf,
+                          int primitive,
+                          Matrix transform,
+                          Mesh* mesh) {
+    int attributes = find_member(gltf, primitive, "attributes");
+    int accessor_count = count_elements(gltf, gltf->root, "accessors");
+    int position = -1;
+    int normal = -1;
+    int texcoord = -1;
+    if (get_index(gltf, attributes, "POSITION", accessor_count, &position) !=
+            0 ||
+        get_index(gltf, attributes, "NORMAL", accessor_count, &normal) != 0 ||
+        get_index(gltf, attributes, "TEXCOORD_0", accessor_count,
+                  &texcoord) != 0 ||
+        position < 0) {
+        return -EINVAL;
+    }
+
+    struct accessor positions = {0};
+    struct accessor normals = {0};
+    struct accessor texcoords = {0};
+    if (get_accessor(gltf, position, "VEC3", &positions) != 0 ||
+        (normal >= 0 &&
+         (get_accessor(gltf, normal, "VEC3", &normals) != 0 ||
+          normals.count != positions.count)) ||
+        (texcoord >= 0 &&
+         (get_accessor(gltf, texcoord, "VEC2", &texcoords) != 0 ||
+          texcoords.count != positions.count))) {
+        return -EINVAL;
+    }
+
+    size_t vertex_count = (size_t)positions.count;
+    mesh->vertexCount = positions.count;
+    mesh->triangleCount = positions.count / 3;
+    mesh->vertices = malloc(vertex_count * 3 * sizeof(float));
+    if (!mesh->vertices) {
+        return -ENOMEM;
+    }
+    for (int i = 0; i < positions.count; i++) {
+        Vector3 vertex = {0};
+        read_floats(&positions, i, (float*)&vertex, 3);
+        vertex = Vector3Transform(vertex, transform);
+        memcpy(&mesh->vertices[i * 3], &vertex, sizeof(vertex));
+    }
+
+    if (normal >= 0) {
+        Matrix normal_transform = MatrixTranspose(MatrixInvert(transform));
+        normal_transform.m12 = 0.0F;
+        normal_transform.m13 = 0.0F;
+        normal_transform.m14 = 0.0F;
+
+        mesh->normals = malloc(vertex_count * 3 * sizeof(float));
+        if (!mesh->normals) {
+            return -ENOMEM;
+        }
+        for (int i = 0; i < normals.count; i++) {
+            Vector3 vertex_normal = {0};
+            read_floats(&normals, i, (float*)&vertex_normal, 3);
+            vertex_normal = Vector3Normalize(
+                Vector3Transform(vertex_normal, normal_transform));
+            memcpy(&mesh->normals[i * 3], &vertex_normal,
+                   sizeof(vertex_normal));
+        }
+    }
+
+    if (texcoord >= 0) {
+        mesh->texcoords = malloc(vertex_count * 2 * sizeof(float));
+        if (!mesh->texcoords) {
+            return -ENOMEM;
+        }
+        for (int i = 0; i < texcoords.count; i++) {
+            read_floats(&texcoords, i, &mesh->texcoords[i * 2], 2);
+        }
+    }
+
+    return load_indices(gltf, primitive, mesh);
+}
+
+/**
+ * Reads the index list of a primitive, if it has one. raylib draws meshes
+ * with 16-bit indices, so wider ones are narrowed and must fit.
+ */
+static int load_indices(const struct gltf* gltf, int primitive, Mesh* mesh) {
+    int index = -1;
+    if (get_index(gltf, primitive, "indices",
+                  count_elements(gltf, gltf->root, "accessors"), &index) != 0) {
+        return -EINVAL;
+    }
+    if (index < 0) {
+        return 0;
+    }
+
+    struct accessor indices = {0};
+    if (get_accessor(gltf, index, "SCALAR", &indices) != 0 ||
+        indices.component_type == GLTF_FLOAT || indices.count % 3 != 0) {
+        return -EINVAL;
+    }
+
+    mesh->triangleCount = indices.count / 3;
+    mesh->indices = malloc((size_t)indices.count * sizeof(unsigned short));
+    if (!mesh->indices) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < indices.count; i++) {
+        const unsigned char* element = indices.data + (i * indices.stride);
+        uint32_t value = 0;
+        if (indices.component_type == GLTF_UNSIGNED_BYTE) {
+            value = element[0];
+        } else if (indices.component_type == GLTF_UNSIGNED_SHORT) {
+            uint16_t narrow = 0;
+            memcpy(&narrow, element, sizeof(narrow));
+            value = narrow;
+        } else {
+            memcpy(&value, element, sizeof(value));
+        }
+
+        if (value >= (uint32_t)mesh->vertexCount) {
+            return -EINVAL;
+        }
+        mesh->indices[i] = (unsigned short)value;
+    }
+
+    return 0;
+}
+
+static void read_floats(const struct accessor* accessor,
+                        int index,
+                        float* out,
+                        int count) {
+    memcpy(out, accessor->data + ((size_t)index * accessor->stride),
+           (size_t)count * sizeof(float));
+}
+
+/**
+ * Frees a model that was never uploaded. UnloadModel() would also try to
+ * delete its GPU buffers, which must not happen off the main thread.
+ */
+static void free_model(Model* model) {
+    for (int i = 0; i < model->meshCount; i++) {
+        free(model->meshes[i].vertices);
+        free(model->meshes[i].normals);
+        free(model->meshes[i].texcoords);
+        free(model->meshes[i].indices);
+    }
+    free(model->meshes);
+    free(model->meshMaterial);
+
+    for (int i = 0; i < model->materialCount; i++) {
+        free(model->materials[i].maps);
+    }
+    free(model->materials);
+
+    *model = (Model){0};
+}
@@ -0,0 +1,201 @@
+#include "game/world/portal.h"
+
+#include <stdlib.h>
+
+#include "raylib.h"
+
+#include "game/world/room_def.h"
+
+/** A wall of a room and the neighbor it faces. */
+struct doorway {
+    uint8_t door;
+    uint8_t opposite_door;
+    int32_t step_x;
+    int32_t step_y;
+};
+
+static const struct doorway DOORWAYS[] = {
+    {DOOR_NORTH, DOOR_SOUTH, 0, 1},
+    {DOOR_SOUTH, DOOR_NORTH, 0, -1},
+    {DOOR_EAST, DOOR_WEST, 1, 0},
+    {DOOR_WEST, DOOR_EAST, -1, 0},
+};
+
+// Cells reached by the current pass carry this stamp, so no visited set has
+// to be allocated or cleared. 0 is left for cells no pass has reached.
+static uint32_t current_stamp = 0;
+
+static size_t find_in_range(const struct portal_view* view,
+                            struct world_cell** cells,
+                            size_t capacity);
+static size_t add_open_topped(const struct portal_view* view,
+                              struct world_cell** cells,
+                              size_t count,
+                              size_t capacity);
+static bool is_cell_visible(const struct portal_view* view,
+                            const struct world_cell* cell);
+static bool is_doorway_visible(const struct portal_view* view,
+                               const struct world_cell* cell,
+                               const struct doorway* doorway);
+
+size_t portal_find_visible(const struct portal_view* view,
+                           struct world_cell** cells,
+                           size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+
+    if (!view->walls_occlude) {
+        return find_in_range(view, cells, capacity);
+    }
+
+    if (++current_stamp == 0) {
+        current_stamp = 1;
+    }
+
+    struct world_cell* origin = grid_get_cell(view->origin_x, view->origin_y);
+    if (!origin) {
+        return add_open_topped(view, cells, 0, capacity);
+    }
+
+    // cells doubles as the queue: everything before next has been expanded.
+    size_t count = 0;
+    origin->visit_stamp = current_stamp;
+    cells[count++] = origin;
+
+    for (size_t next = 0; next < count; next++) {
+        const struct world_cell* cell = cells[next];
+        if (!cell->template) {
+            continue;
+        }
+
+        for (size_t i = 0; i < sizeof(DOORWAYS) / sizeof(DOORWAYS[0]); i++) {
+            const struct doorway* doorway = &DOORWAYS[i];
+            if (!(cell->template->door_mask & doorway->door)) {
+                continue;
+            }
+
+            int32_t x = cell->grid_x + doorway->step_x;
+            int32_t y = cell->grid_y + doorway->step_y;
+            if (abs(x - view->origin_x) > view->radius ||
+                abs(y - view->origin_y) > view->radius) {
+                continue;
+            }
+
+            struct world_cell* neighbor = grid_get_cell(x, y);
+            if (!neighbor || neighbor->visit_stamp == current_stamp ||
+                !neighbor->template ||
+                !(neighbor->template->door_mask & doorway->opposite_door)) {
+                continue;
+            }
+
+            if (!is_doorway_visible(view, cell, doorway)) {
+                continue;
+            }
+
+            neighbor->visit_stamp = current_stamp;
+            cells[count++] = neighbor;
+            if (count == capacity) {
+                return count;
+            }
+        }
+    }
+
+    return add_open_topped(view, cells, count, capacity);
+}
+
+static size_t find_in_range(const struct portal_view* view,
+                            struct world_cell** cells,
+                            size_t capacity) {
+    size_t count = 0;
+    struct world_cell* origin = grid_get_cell(view->origin_x, view->origin_y);
+    if (origin && origin->template) {
+        cells[count++] = origin;
+    }
+
+    for (int32_t y = view->origin_y - view->radius;
+         y <= view->origin_y + view->radius && count < capacity; y++) {
+        for (int32_t x = view->origin_x - view->radius;
+             x <= view->origin_x + view->radius && count < capacity; x++) {
+            struct world_cell* cell = grid_get_cell(x, y);
+            if (cell && cell != origin && cell->template) {
+                cells[count++] = cell;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Appends the open-topped rooms in range that the flood fill did not reach.
+ * They are seen into from above, over their walls, so only their bounds
+ * decide whether they are visible.
+ */
+static size_t add_open_topped(const struct portal_view* view,
+                              struct world_cell** cells,
+                              size_t count,
+                              size_t capacity) {
+    for (int32_t y = view->origin_y - view->radius;
+         y <= view->origin_y + view->radius && count < capacity; y++) {
+        for (int32_t x = view->origin_x - view->radius;
+             x <= view->origin_x + view->radius && count < capacity; x++) {
+            struct world_cell* cell = grid_get_cell(x, y);
+            if (!cell || cell->visit_stamp == current_stamp ||
+                !cell->template || !cell->template->is_open_topped ||
+                !is_cell_visible(view, cell)) {
+                continue;
+            }
+
+            cell->visit_stamp = current_stamp;
+            cells[count++] = cell;
+        }
+    }
+
+    return count;
+}
+
+static bool is_cell_visible(const struct portal_view* view,
+                            const struct world_cell* cell) {
+    if (!view->frustum) {
+        return true;
+    }
+
+    float half_size = 0.5F * view->cell_size;
+    float half_height = 0.5F * view->cell_height;
+    Vector3 center = {(float)cell->grid_x * view->cell_size, 0.0F,
+                      (float)cell->grid_y * view->cell_size};
+
+    BoundingBox box = {
+        .min = {center.x - half_size, -half_height, center.z - half_size},
+        .max = {center.x + half_size, half_height, center.z + half_size},
+    };
+
+    return frustum_intersects_box(view->frustum, box);
+}
+
+static bool is_doorway_visible(const struct portal_view* view,
+                               const struct world_cell* cell,
+                               const struct doorway* doorway) {
+    if (!view->frustum) {
+        return true;
+    }
+
+    float half_size = 0.5F * view->cell_size;
+    float half_height = 0.5F * view->cell_height;
+    Vector3 center = {(float)cell->grid_x * view->cell_size, 0.0F,
+                      (float)cell->grid_y * view->cell_size};
+
+    // The shared wall, flattened onto the plane between the two cells.
+    Vector3 wall = {center.x + ((float)doorway->step_x * half_size), 0.0F,
+                    center.z + ((float)doorway->step_y * half_size)};
+    Vector3 extent = {doorway->step_x != 0 ? 0.0F : half_size, half_height,
+                      doorway->step_y != 0 ? 0.0F : half_size};
+
+    BoundingBox box = {
+        .min = {wall.x - extent.x, wall.y - extent.y, wall.z - extent.z},
+        .max = {wall.x + extent.x, wall.y + extent.y, wall.z + extent.z},
+    };
+
+    return frustum_intersects_box(view->frustum, box);
+}
@@ -0,0 +1,237 @@
+#include "game/world/room_batch.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+enum { INITIAL_ROOM_CAPACITY = 64 };
+
+/** A room waiting for room_batch_end(). */
+struct room_instance {
+    const struct room_def* def;
+    Model model;
+    Matrix transform;
+};
+
+// raylib's default vertex shader, except that the model matrix comes from a
+// per-instance attribute. The default fragment shader is used as is.
+static const char* INSTANCED_VERTEX_SHADER =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec2 vertexTexCoord;\n"
+    "in vec4 vertexColor;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragTexCoord = vertexTexCoord;\n"
+    "    fragColor = vertexColor;\n"
+    "    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static bool is_initialized = false;
+static bool is_collecting = false;
+
+static Shader instanced_shader;
+static bool is_instanced = false;
+
+static struct room_instance* rooms = nullptr;
+static Matrix* transforms = nullptr;
+static size_t room_count = 0;
+static size_t room_capacity = 0;
+
+static size_t drawn_rooms = 0;
+static size_t draw_count = 0;
+
+static int compare_rooms(const void* lhs, const void* rhs);
+static void draw_group(const struct room_instance* group, size_t count);
+
+int room_batch_init(void) {
+    if (is_initialized) {
+        return 0;
+    }
+
+    rooms = malloc(INITIAL_ROOM_CAPACITY * sizeof(struct room_instance));
+    transforms = malloc(INITIAL_ROOM_CAPACITY * sizeof(Matrix));
+    if (!rooms || !transforms) {
+        TraceLog(LOG_ERROR,
+                 "ROOM_BATCH: Failed to allocate rooms (out of memory).");
+        free(rooms);
+        free(transforms);
+        rooms = nullptr;
+        transforms = nullptr;
+        return -ENOMEM;
+    }
+    room_capacity = INITIAL_ROOM_CAPACITY;
+
+    instanced_shader = LoadShaderFromMemory(INSTANCED_VERTEX_SHADER, nullptr);
+    is_instanced = instanced_shader.id != rlGetShaderIdDefault();
+    if (is_instanced) {
+        // raylib 5.5 gave instance transforms their own location; earlier
+        // versions bind them to the model matrix location.
+#if RAYLIB_VERSION_MAJOR > 5 || \
+    (RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5)
+        instanced_shader.locs[SHADER_LOC_VERTEX_INSTANCE_TX] =
+            GetShaderLocationAttrib(instanced_shader, "instanceTransform");
+#else
+        instanced_shader.locs[SHADER_LOC_MATRIX_MODEL] =
+            GetShaderLocationAttrib(instanced_shader, "instanceTransform");
+#endif
+    } else {
+        TraceLog(LOG_WARNING,
+                 "ROOM_BATCH: Instancing shader unavailable, drawing rooms "
+                 "one by one.");
+    }
+
+    room_count = 0;
+    is_collecting = false;
+    is_initialized = true;
+
+    return 0;
+}
+
+void room_batch_destroy(void) {
+    if (!is_initialized) {
+        return;
+    }
+
+    if (is_instanced) {
+        UnloadShader(instanced_shader);
+    }
+    is_instanced = false;
+
+    free(rooms);
+    free(transforms);
+    rooms = nullptr;
+    transforms = nullptr;
+    room_count = 0;
+    room_capacity = 0;
+    is_initialized = false;
+}
+
+bool room_batch_is_instanced(void) {
+    return is_initialized && is_instanced;
+}
+
+void room_batch_begin(void) {
+    if (!is_initialized) {
+        return;
+    }
+
+    room_count = 0;
+    is_collecting = true;
+}
+
+int room_batch_add(const struct room_def* def,
+                   Model model,
+                   Vector3 position,
+                   float scale) {
+    if (!def) {
+        return -EINVAL;
+    }
+    if (!is_collecting) {
+        return -ECANCELED;
+    }
+
+    if (room_count == room_capacity) {
+        size_t capacity = room_capacity * 2;
+        struct room_instance* grown_rooms =
+            realloc(rooms, capacity * sizeof(struct room_instance));
+        if (!grown_rooms) {
+            return -ENOMEM;
+        }
+        rooms = grown_rooms;
+
+        Matrix* grown_transforms =
+            realloc(transforms, capacity * sizeof(Matrix));
+        if (!grown_transforms) {
+            return -ENOMEM;
+        }
+        transforms = grown_transforms;
+        room_capacity = capacity;
+    }
+
+    // The same transform DrawModel() applies to every mesh of the model.
+    Matrix placement = MatrixMultiply(MatrixScale(scale, scale, scale),
+                                      MatrixTranslate(position.x, position.y,
+                                                      position.z));
+    rooms[room_count++] = (struct room_instance){
+        .def = def,
+        .model = model,
+        .transform = MatrixMultiply(model.transform, placement),
+    };
+
+    return 0;
+}
+
+void room_batch_end(void) {
+    if (!is_collecting) {
+        return;
+    }
+
+    qsort(rooms, room_count, sizeof(struct room_instance), compare_rooms);
+
+    draw_count = 0;
+    size_t first = 0;
+    while (first < room_count) {
+        size_t last = first + 1;
+        while (last < room_count && rooms[last].def == rooms[first].def) {
+            last++;
+        }
+        draw_group(&rooms[first], last - first);
+        first = last;
+    }
+
+    drawn_rooms = room_count;
+    room_count = 0;
+    is_collecting = false;
+}
+
+size_t room_batch_get_room_count(void) {
+    return drawn_rooms;
+}
+
+size_t room_batch_get_draw_count(void) {
+    return draw_count;
+}
+
+static int compare_rooms(const void* lhs, const void* rhs) {
+    uintptr_t a = (uintptr_t)((const struct room_instance*)lhs)->def;
+    uintptr_t b = (uintptr_t)((const struct room_instance*)rhs)->def;
+    return (a > b) - (a < b);
+}
+
+static void draw_group(const struct room_instance* group, size_t count) {
+    const Model* model = &group->model;
+
+    if (!is_instanced) {
+        for (size_t i = 0; i < count; i++) {
+            for (int mesh = 0; mesh < model->meshCount; mesh++) {
+                DrawMesh(model->meshes[mesh],
+                         model->materials[model->meshMaterial[mesh]],
+                         group[i].transform);
+                draw_count++;
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        transforms[i] = group[i].transform;
+    }
+
+    for (int mesh = 0; mesh < model->meshCount; mesh++) {
+        // The material is shared with every holder of the model, so only a
+        // copy gets the instancing shader.
+        Material material = model->materials[model->meshMaterial[mesh]];
+        material.shader = instanced_shader;
+        DrawMeshInstanced(model->meshes[mesh], material, transforms,
+                          (int)count);
+        draw_count++;
+    }
+}
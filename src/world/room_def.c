@@ -12,18 +12,68 @@
 #include "game/ds/vector.h"
 #include "game/rng.h"
 
-static struct vector room_defs;
-static bool is_initialized = false;
+#define DOOR_MASK_ALL (DOOR_NORTH | DOOR_SOUTH | DOOR_EAST | DOOR_WEST)
+
+enum { DOOR_MASK_COUNT = DOOR_MASK_ALL + 1 };
 
 struct room_attributes {
     uint8_t door_mask;
     int weight;
+    bool is_open_topped;
+};
+
+/**
+ * A template that matches a constraint pair, together with the running sum of
+ * the weights of all matches up to and including it.
+ */
+struct candidate {
+    const struct room_def* def;
+    int cumulative_weight;
+};
+
+/**
+ * The matches for one (required, forbidden) pair, stored as a contiguous
+ * slice of the shared candidate array in template order.
+ */
+struct constraint_entry {
+    size_t first;
+    size_t count;
+    int total_weight;
+};
+
+// Every loaded template, in id order. This list owns the templates; room_defs
+// is the generation pool and only borrows them.
+static struct vector templates;
+static struct vector room_defs;
+static bool is_initialized = false;
+
+static struct {
+    struct constraint_entry entries[DOOR_MASK_COUNT][DOOR_MASK_COUNT];
+    struct candidate* candidates;
+} constraint_table;
+
+/**
+ * Where a lookup takes its random numbers from: a keyed stream, a caller's
+ * context, or the global generator when neither is set.
+ */
+struct draw_source {
+    struct rng* rng;
+    bool is_keyed;
+    uint64_t key;
+    uint64_t counter;
 };
 
 static struct room_attributes parse_attributes_from_filename(
     const char* filename);
-static const struct room_def* select_weighted_random_from_matches(
-    const struct vector* matches);
+static const struct room_def* find_constrained(uint8_t required_doors,
+                                               uint8_t forbidden_doors,
+                                               struct draw_source* source);
+static int build_constraint_table(void);
+static inline bool satisfies(const struct room_def* def,
+                             unsigned int required_doors,
+                             unsigned int forbidden_doors);
+static int draw_range(struct draw_source* source, int min, int max);
+static void free_templates(void);
 
 int room_def_load_all(const char* directory_path) {
     if (is_initialized) {
@@ -31,9 +81,16 @@ int room_def_load_all(const char* directory_path) {
         return (int)vector_len(&room_defs);
     }
 
+    if (vector_init(&templates) != 0) {
+        TraceLog(LOG_ERROR,
+                 "ROOM_DEF: Failed to initialize vector (out of memory).");
+        return -ENOMEM;
+    }
+
     if (vector_init(&room_defs) != 0) {
         TraceLog(LOG_ERROR,
                  "ROOM_DEF: Failed to initialize vector (out of memory).");
+        vector_destroy(&templates);
         return -ENOMEM;
     }
 
@@ -59,6 +116,12 @@ int room_def_load_all(const char* directory_path) {
             continue;
         }
 
+        if (vector_len(&templates) > UINT16_MAX) {
+            TraceLog(LOG_WARNING, "ROOM_DEF: Too many templates, skipping '%s'",
+                     filename);
+            continue;
+        }
+
         struct room_def* template = malloc(sizeof(struct room_def));
         if (!template) {
             ret = -ENOMEM;
@@ -74,12 +137,24 @@ int room_def_load_all(const char* directory_path) {
 
         template->door_mask = attr.door_mask;
         template->weight = attr.weight;
-        if (vector_push(&room_defs, template) != 0) {
+        template->is_open_topped = attr.is_open_topped;
+        template->id = (uint16_t)vector_len(&templates);
+        if (vector_push(&templates, template) != 0) {
             free(template->model_path);
             free(template);
             ret = -ENOMEM;
             goto cleanup_files;
         }
+
+        if (vector_push(&room_defs, template) != 0) {
+            ret = -ENOMEM;
+            goto cleanup_files;
+        }
+    }
+
+    ret = build_constraint_table();
+    if (ret != 0) {
+        goto cleanup_files;
     }
 
     is_initialized = true;
@@ -92,7 +167,7 @@ cleanup_files:
 
 cleanup_vector:
     if (ret < 0) {
-        room_def_unload_all();
+        free_templates();
     }
 
     return ret;
@@ -103,13 +178,7 @@ void room_def_unload_all() {
         return;
     }
 
-    for (size_t i = 0; i < vector_len(&room_defs); ++i) {
-        struct room_def* template = vector_get(&room_defs, i);
-        free(template->model_path);
-        free(template);
-    }
-
-    vector_destroy(&room_defs);
+    free_templates();
     is_initialized = false;
     TraceLog(LOG_INFO, "ROOM_DEF: Unloaded all room templates.");
 }
@@ -126,39 +195,32 @@ const struct room_def* room_def_get_by_index(size_t index) {
     return (const struct room_def*)vector_get(&room_defs, index);
 }
 
-const struct room_def* room_def_find_constrained(uint8_t required_doors,
-                                                 uint8_t forbidden_doors) {
+const struct room_def* room_def_get_by_id(uint16_t id) {
     if (!is_initialized) {
         return nullptr;
     }
 
-    struct vector matches;
-    if (vector_init(&matches) != 0) {
-        TraceLog(LOG_ERROR,
-                 "ROOM_TEMPLATE: Failed to initialize matches vector.");
-        return nullptr;
-    }
-
-    for (size_t i = 0; i < vector_len(&room_defs); i++) {
-        const struct room_def* template = vector_get(&room_defs, i);
-
-        bool has_required =
-            (template->door_mask & required_doors) == required_doors;
-        bool has_no_forbidden = (template->door_mask & forbidden_doors) == 0;
+    return (const struct room_def*)vector_get(&templates, id);
+}
 
-        if ((int)has_required && (int)has_no_forbidden) {
-            if (vector_push(&matches, (void*)template) != 0) {
-                TraceLog(LOG_WARNING,
-                         "ROOM_TEMPLATE: Failed to push match to vector.");
-            }
-        }
-    }
+const struct room_def* room_def_find_constrained(uint8_t required_doors,
+                                                 uint8_t forbidden_doors) {
+    struct draw_source source = {0};
+    return find_constrained(required_doors, forbidden_doors, &source);
+}
 
-    const struct room_def* result =
-        select_weighted_random_from_matches(&matches);
+const struct room_def* room_def_find_constrained_r(uint8_t required_doors,
+                                                   uint8_t forbidden_doors,
+                                                   struct rng* rng) {
+    struct draw_source source = {.rng = rng};
+    return find_constrained(required_doors, forbidden_doors, &source);
+}
 
-    vector_destroy(&matches);
-    return result;
+const struct room_def* room_def_find_constrained_keyed(uint8_t required_doors,
+                                                       uint8_t forbidden_doors,
+                                                       uint64_t key) {
+    struct draw_source source = {.is_keyed = true, .key = key};
+    return find_constrained(required_doors, forbidden_doors, &source);
 }
 
 void room_def_remove(const struct room_def* room_to_remove) {
@@ -174,6 +236,8 @@ void room_def_remove(const struct room_def* room_to_remove) {
                 vector_set(&room_defs, i, last_element);
             }
 
+            (void)build_constraint_table();
+
             TraceLog(LOG_DEBUG,
                      "ROOM_DEF: Removed '%s' from the generation pool.",
                      room_to_remove->model_path);
@@ -182,6 +246,103 @@ void room_def_remove(const struct room_def* room_to_remove) {
     }
 }
 
+static const struct room_def* find_constrained(uint8_t required_doors,
+                                               uint8_t forbidden_doors,
+                                               struct draw_source* source) {
+    if (!is_initialized || (required_doors & ~DOOR_MASK_ALL) != 0) {
+        return nullptr;
+    }
+
+    const struct constraint_entry* entry =
+        &constraint_table.entries[required_doors]
+                                 [forbidden_doors & DOOR_MASK_ALL];
+    if (entry->count == 0) {
+        return nullptr;
+    }
+
+    const struct candidate* candidates =
+        &constraint_table.candidates[entry->first];
+
+    if (entry->total_weight <= 0) {
+        int rand_index = draw_range(source, 0, (int)entry->count - 1);
+        return candidates[rand_index].def;
+    }
+
+    int roll = draw_range(source, 0, entry->total_weight - 1);
+
+    size_t low = 0;
+    size_t high = entry->count - 1;
+    while (low < high) {
+        size_t mid = low + ((high - low) / 2);
+        if (candidates[mid].cumulative_weight > roll) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    return candidates[low].def;
+}
+
+static int build_constraint_table(void) {
+    size_t total = 0;
+    for (unsigned int required = 0; required < DOOR_MASK_COUNT; ++required) {
+        for (unsigned int forbidden = 0; forbidden < DOOR_MASK_COUNT;
+             ++forbidden) {
+            for (size_t i = 0; i < vector_len(&room_defs); ++i) {
+                const struct room_def* def = vector_get(&room_defs, i);
+                total += (size_t)satisfies(def, required, forbidden);
+            }
+        }
+    }
+
+    struct candidate* candidates = nullptr;
+    if (total > 0) {
+        candidates = malloc(total * sizeof(struct candidate));
+        if (!candidates) {
+            free(constraint_table.candidates);
+            memset(&constraint_table, 0, sizeof(constraint_table));
+            TraceLog(LOG_ERROR,
+                     "ROOM_DEF: Failed to allocate the constraint table.");
+            return -ENOMEM;
+        }
+    }
+
+    size_t next = 0;
+    for (unsigned int required = 0; required < DOOR_MASK_COUNT; ++required) {
+        for (unsigned int forbidden = 0; forbidden < DOOR_MASK_COUNT;
+             ++forbidden) {
+            struct constraint_entry* entry =
+                &constraint_table.entries[required][forbidden];
+            entry->first = next;
+            entry->total_weight = 0;
+
+            for (size_t i = 0; i < vector_len(&room_defs); ++i) {
+                const struct room_def* def = vector_get(&room_defs, i);
+                if (satisfies(def, required, forbidden)) {
+                    entry->total_weight += def->weight;
+                    candidates[next].def = def;
+                    candidates[next].cumulative_weight = entry->total_weight;
+                    next++;
+                }
+            }
+
+            entry->count = next - entry->first;
+        }
+    }
+
+    free(constraint_table.candidates);
+    constraint_table.candidates = candidates;
+    return 0;
+}
+
+static inline bool satisfies(const struct room_def* def,
+                             unsigned int required_doors,
+                             unsigned int forbidden_doors) {
+    return (def->door_mask & required_doors) == required_doors &&
+           (def->door_mask & forbidden_doors) == 0;
+}
+
 static struct room_attributes parse_attributes_from_filename(
     const char* filename) {
     struct room_attributes attr = {0};
@@ -227,35 +388,33 @@ static struct room_attributes parse_attributes_from_filename(
                  filename);
     }
 
+    // None of the shipped models has a ceiling; a roofed one says so.
+    attr.is_open_topped = strstr(filename, "_roofed") == nullptr;
+
     return attr;
 }
 
-static const struct room_def* select_weighted_random_from_matches(
-    const struct vector* matches) {
-    if (vector_is_empty(matches)) {
-        return nullptr;
-    }
-
-    int total_weight = 0;
-    for (size_t i = 0; i < vector_len(matches); ++i) {
-        const struct room_def* def = vector_get(matches, i);
-        total_weight += def->weight;
+static int draw_range(struct draw_source* source, int min, int max) {
+    if (source->is_keyed) {
+        return rng_stream_range(source->key, &source->counter, min, max);
     }
 
-    if (total_weight <= 0) {
-        int rand_index = rng_get_range(0, (int)vector_len(matches) - 1);
-        return vector_get(matches, rand_index);
+    if (source->rng) {
+        return rng_get_range_r(source->rng, min, max);
     }
 
-    int roll = rng_get_range(0, total_weight - 1);
+    return rng_get_range(min, max);
+}
 
-    for (size_t i = 0; i < vector_len(matches); ++i) {
-        const struct room_def* def = vector_get(matches, i);
-        roll -= def->weight;
-        if (roll < 0) {
-            return def;
-        }
+static void free_templates(void) {
+    for (size_t i = 0; i < vector_len(&templates); ++i) {
+        struct room_def* template = vector_get(&templates, i);
+        free(template->model_path);
+        free(template);
     }
 
-    return vector_get(matches, vector_len(matches) - 1);
+    vector_destroy(&templates);
+    vector_destroy(&room_defs);
+    free(constraint_table.candidates);
+    memset(&constraint_table, 0, sizeof(constraint_table));
 }
@@ -4,39 +4,219 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
 
+#include "game/frustum.h"
 #include "game/world/generator.h"
 #include "game/world/grid.h"
+#include "game/world/model_cache.h"
+#include "game/world/portal.h"
+#include "game/world/room_batch.h"
 #include "game/world/room_def.h"
+#include "game/world/world_file.h"
 
 static const float ROOM_SCALE = 5.0F;
 static const float ROOM_SIZE = 4.0F * ROOM_SCALE;
-static const int LOAD_RADIUS = 1;
+// Room models are much lower than they are wide; a cube bounds them safely.
+static const float ROOM_HEIGHT = ROOM_SIZE;
+// Cells within this many steps of the player are streamed in.
+static const int32_t DEFAULT_LOAD_RADIUS = 2;
+// Cells this far beyond the load radius are checked for unloading.
+static const int32_t UNLOAD_MARGIN = 2;
+// Regions beyond this many cells from the player are paged out of the grid.
+static const int32_t DEFAULT_PAGE_DISTANCE = 64;
+// Room models released by cells out of range stay cached up to this size.
+static const size_t MODEL_BUDGET_BYTES = (size_t)64 * 1024 * 1024;
+static const double DEFAULT_STREAM_BUDGET_MS = 2.0;
 
 static int32_t player_grid_x = -9999;
 static int32_t player_grid_y = -9999;
 static bool is_initialized = false;
+static double stream_budget_ms = DEFAULT_STREAM_BUDGET_MS;
+static int32_t load_radius = DEFAULT_LOAD_RADIUS;
+static int32_t page_distance = DEFAULT_PAGE_DISTANCE;
+static struct world_cell** visible_cells = nullptr;
+static size_t visible_capacity = 0;
+static struct world_file save_file;
+static const struct room_def** save_templates = nullptr;
+
+/** The rooms gathered by world_save(). */
+struct room_collector {
+    struct world_file_entry* entries;
+    size_t count;
+    size_t capacity;
+};
+
+static int init_world(unsigned int seed,
+                      const char* assets_path,
+                      const char* save_path);
+static void release_world(void);
+static int open_save(const char* path, struct generator_state* state);
+static void close_save(void);
+static const struct room_def* find_template(const char* name);
+static int collect_room(int32_t x,
+                        int32_t y,
+                        const struct room_def* room_template,
+                        void* context);
+static int reserve_visible_cells(int32_t radius);
+static bool is_near_grid_edge(int32_t x, int32_t y);
+static void update_residency(int32_t scan_radius);
+static bool is_cell_in_view(const struct world_cell* cell,
+                            const struct frustum* frustum);
+static void stream_nearby_models(void);
 
 int world_init(unsigned int seed, const char* assets_path) {
+    return init_world(seed, assets_path, nullptr);
+}
+
+int world_load(const char* save_path, const char* assets_path) {
+    if (!save_path) {
+        return -EINVAL;
+    }
+
+    return init_world(0, assets_path, save_path);
+}
+
+int world_save(const char* path) {
+    if (!is_initialized || !path) {
+        return -EINVAL;
+    }
+
+    // Rooms the worker has generated but not committed are part of the
+    // world, and it must be idle before its state can be read.
+    generator_flush();
+
+    size_t template_count = 0;
+    while (template_count <= UINT16_MAX &&
+           room_def_get_by_id((uint16_t)template_count)) {
+        template_count++;
+    }
+
+    // Every room is resident, paged out, or still only in the attached save.
+    struct room_collector collector = {
+        .capacity = grid_get_resident_count() + grid_get_paged_count() +
+                    (save_file.header ? save_file.header->room_count : 0),
+    };
+    collector.entries =
+        malloc((collector.capacity + 1) * sizeof(struct world_file_entry));
+    const char** names = malloc((template_count + 1) * sizeof(const char*));
+    if (!collector.entries || !names) {
+        TraceLog(LOG_ERROR, "WORLD: Failed to allocate the save (out of "
+                            "memory).");
+        free(collector.entries);
+        free((void*)names);
+        return -ENOMEM;
+    }
+
+    for (size_t id = 0; id < template_count; id++) {
+        names[id] = GetFileName(room_def_get_by_id((uint16_t)id)->model_path);
+    }
+
+    int ret = grid_for_each_room(collect_room, &collector);
+    if (ret == 0) {
+        struct generator_state state;
+        generator_get_state(&state);
+
+        struct world_file_info info = {
+            .seed = state.seed,
+            .rng_mode = (uint32_t)state.mode,
+            .names = names,
+            .template_count = template_count,
+        };
+        memcpy(info.rng_state, state.rng.s, sizeof(info.rng_state));
+
+        ret = world_file_write(path, &info, collector.entries,
+                               collector.count);
+    }
+
+    if (ret == 0) {
+        TraceLog(LOG_INFO, "WORLD: Saved %zu rooms to %s", collector.count,
+                 path);
+    } else {
+        TraceLog(LOG_ERROR, "WORLD: Failed to save %s", path);
+    }
+
+    free(collector.entries);
+    free((void*)names);
+
+    return ret;
+}
+
+static int init_world(unsigned int seed,
+                      const char* assets_path,
+                      const char* save_path) {
     if (is_initialized) {
         return 0;
     }
 
-    grid_init();
-    if (room_def_load_all(assets_path) <= 0) {
-        return -1;
+    // The mode is the caller's setting, so a failed load puts it back.
+    struct generator_state previous;
+    generator_get_state(&previous);
+    struct generator_state state = {0};
+
+    int ret = grid_init();
+    if (ret != 0) {
+        return ret;
     }
 
-    if (generator_init(seed) != 0) {
-        return -1;
+    model_cache_set_budget(MODEL_BUDGET_BYTES);
+    int template_count = room_def_load_all(assets_path);
+    if (template_count <= 0) {
+        ret = template_count < 0 ? template_count : -ENOENT;
+        goto cleanup;
+    }
+
+    if (save_path) {
+        ret = open_save(save_path, &state);
+        if (ret != 0) {
+            goto cleanup;
+        }
+
+        // The starting room and the first chunk are already in the save, so
+        // generator_init() only finds them there.
+        generator_set_rng_mode(state.mode);
+        seed = (unsigned int)state.seed;
+    }
+
+    ret = generator_init(seed);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    if (save_path) {
+        generator_set_state(&state);
+    }
+
+    ret = room_batch_init();
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = reserve_visible_cells(load_radius);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    if (generator_start_worker() != 0) {
+        TraceLog(LOG_WARNING,
+                 "WORLD: Generation worker unavailable, generating inline.");
     }
 
     world_update((Vector3){0});
 
     is_initialized = true;
     return 0;
+
+cleanup:
+    // Every step above is undone by release_world(), and the ones that never
+    // ran are left alone by it.
+    release_world();
+    generator_set_rng_mode(previous.mode);
+    return ret;
 }
 
 void world_destroy(void) {
@@ -44,9 +224,7 @@ void world_destroy(void) {
         return;
     }
 
-    grid_destroy();
-    room_def_unload_all();
-
+    release_world();
     is_initialized = false;
 }
 
@@ -55,43 +233,28 @@ int world_update(Vector3 player_pos) {
         return -EINVAL;
     }
 
+    generator_commit();
+    model_cache_update(stream_budget_ms / 1000.0);
+
     int32_t new_grid_x = (int32_t)roundf(player_pos.x / ROOM_SIZE);
     int32_t new_grid_y = (int32_t)roundf(player_pos.z / ROOM_SIZE);
 
     if (new_grid_x == player_grid_x && new_grid_y == player_grid_y) {
+        stream_nearby_models();
         return 0;
     }
 
     player_grid_x = new_grid_x;
     player_grid_y = new_grid_y;
 
-    if (player_grid_x > INT32_MAX - 2 || player_grid_x < INT32_MIN + 2 ||
-        player_grid_y > INT32_MAX - 2 || player_grid_y < INT32_MIN + 2) {
+    if (is_near_grid_edge(player_grid_x, player_grid_y)) {
         return 0;
     }
 
-    generator_create_chunk(player_grid_x, player_grid_y);
-
-    const int scan_radius = LOAD_RADIUS + 2;
-    for (int32_t y = player_grid_y - scan_radius;
-         y <= player_grid_y + scan_radius; y++) {
-        for (int32_t x = player_grid_x - scan_radius;
-             x <= player_grid_x + scan_radius; x++) {
-            struct world_cell* cell = grid_get_cell(x, y);
-            if (!cell) {
-                continue;
-            }
-
-            int32_t dist_x = abs(x - player_grid_x);
-            int32_t dist_y = abs(y - player_grid_y);
-
-            if (dist_x <= LOAD_RADIUS && dist_y <= LOAD_RADIUS) {
-                grid_load_model(cell);
-            } else {
-                grid_unload_model(cell);
-            }
-        }
-    }
+    generator_request_chunk(player_grid_x, player_grid_y);
+    update_residency(load_radius + UNLOAD_MARGIN);
+    grid_page_out(player_grid_x, player_grid_y, page_distance);
+    generator_page_out(player_grid_x, player_grid_y, page_distance);
 
     return 0;
 }
@@ -101,21 +264,38 @@ int world_draw(void) {
         return -EINVAL;
     }
 
-    for (int32_t y = player_grid_y - LOAD_RADIUS;
-         y <= player_grid_y + LOAD_RADIUS; y++) {
-        for (int32_t x = player_grid_x - LOAD_RADIUS;
-             x <= player_grid_x + LOAD_RADIUS; x++) {
-            struct world_cell* cell = grid_get_cell(x, y);
+    // The matrices BeginMode3D() set up for the current camera.
+    struct frustum frustum = frustum_from_matrix(
+        MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    struct portal_view view = {
+        .origin_x = player_grid_x,
+        .origin_y = player_grid_y,
+        .radius = load_radius,
+        .cell_size = ROOM_SIZE,
+        .cell_height = ROOM_HEIGHT,
+        .frustum = &frustum,
+        // Open-topped rooms are found by their bounds, so a room without a
+        // doorway towards the player can still be in plain view.
+        .walls_occlude = true,
+    };
+    size_t visible_count =
+        portal_find_visible(&view, visible_cells, visible_capacity);
 
-            if (cell && (int)cell->is_model_loaded) {
-                Vector3 room_pos = {.x = (float)cell->grid_x * ROOM_SIZE,
-                                    .y = 0.0F,
-                                    .z = (float)cell->grid_y * ROOM_SIZE};
-                DrawModel(cell->model, room_pos, ROOM_SCALE, WHITE);
-            }
+    room_batch_begin();
+
+    for (size_t i = 0; i < visible_count; i++) {
+        const struct world_cell* cell = visible_cells[i];
+
+        if (cell->is_model_loaded && is_cell_in_view(cell, &frustum)) {
+            Vector3 room_pos = {.x = (float)cell->grid_x * ROOM_SIZE,
+                                .y = 0.0F,
+                                .z = (float)cell->grid_y * ROOM_SIZE};
+            room_batch_add(cell->template, cell->model, room_pos, ROOM_SCALE);
         }
     }
 
+    room_batch_end();
+
     return 0;
 }
 
@@ -144,3 +324,234 @@ Vector3 world_get_room_center(Vector3 pos) {
 Vector3 world_get_spawn_position(void) {
     return (Vector3){0.0F, 0.1F, 0.0F};
 }
+
+void world_set_stream_budget(double milliseconds) {
+    stream_budget_ms = milliseconds > 0.0 ? milliseconds : 0.0;
+}
+
+int world_set_load_radius(int32_t radius) {
+    if (radius < 0 || radius > WORLD_MAX_LOAD_RADIUS) {
+        return -EINVAL;
+    }
+
+    if (is_initialized) {
+        int ret = reserve_visible_cells(radius);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    // Cells between the two radii are unloaded or requested right away
+    // instead of waiting for the player to change cells.
+    int32_t scan_radius =
+        (radius > load_radius ? radius : load_radius) + UNLOAD_MARGIN;
+    load_radius = radius;
+    if (is_initialized && !is_near_grid_edge(player_grid_x, player_grid_y)) {
+        update_residency(scan_radius);
+    }
+
+    return 0;
+}
+
+int32_t world_get_load_radius(void) {
+    return load_radius;
+}
+
+int world_set_page_distance(int32_t distance) {
+    if (distance < WORLD_MIN_PAGE_DISTANCE) {
+        return -EINVAL;
+    }
+
+    page_distance = distance;
+    return 0;
+}
+
+int32_t world_get_page_distance(void) {
+    return page_distance;
+}
+
+/**
+ * Releases everything init_world() sets up. Each step checks for itself
+ * whether it ran, so this also cleans up after a partial initialization. The
+ * grid goes first, as its cells point into the save and the templates.
+ */
+static void release_world(void) {
+    generator_stop_worker();
+    grid_destroy();
+    room_batch_destroy();
+    free((void*)visible_cells);
+    visible_cells = nullptr;
+    visible_capacity = 0;
+    close_save();
+    room_def_unload_all();
+
+    player_grid_x = -9999;
+    player_grid_y = -9999;
+}
+
+static int open_save(const char* path, struct generator_state* state) {
+    int ret = world_file_open(&save_file, path);
+    if (ret != 0) {
+        TraceLog(LOG_ERROR, "WORLD: Failed to open save: %s", path);
+        return ret;
+    }
+
+    const struct world_file_header* header = save_file.header;
+    save_templates =
+        calloc((size_t)header->template_count + 1, sizeof(*save_templates));
+    if (!save_templates) {
+        close_save();
+        return -ENOMEM;
+    }
+
+    for (uint32_t i = 0; i < header->template_count; i++) {
+        const char* name = world_file_get_name(&save_file, (uint16_t)i);
+        save_templates[i] = name ? find_template(name) : nullptr;
+        if (!save_templates[i]) {
+            TraceLog(LOG_WARNING,
+                     "WORLD: Unknown template '%s' in save, dropping its "
+                     "rooms.",
+                     name ? name : "");
+        }
+    }
+
+    ret = grid_attach_save(&save_file, save_templates);
+    if (ret != 0) {
+        close_save();
+        return ret;
+    }
+
+    state->seed = header->seed;
+    memcpy(state->rng.s, header->rng_state, sizeof(state->rng.s));
+    state->mode = header->rng_mode == GENERATOR_RNG_COORDINATE
+                      ? GENERATOR_RNG_COORDINATE
+                      : GENERATOR_RNG_SEQUENTIAL;
+
+    return 0;
+}
+
+static void close_save(void) {
+    world_file_close(&save_file);
+    free((void*)save_templates);
+    save_templates = nullptr;
+}
+
+static const struct room_def* find_template(const char* name) {
+    for (size_t id = 0; id <= UINT16_MAX; id++) {
+        const struct room_def* room_template = room_def_get_by_id((uint16_t)id);
+        if (!room_template) {
+            break;
+        }
+
+        if (strcmp(GetFileName(room_template->model_path), name) == 0) {
+            return room_template;
+        }
+    }
+
+    return nullptr;
+}
+
+static int collect_room(int32_t x,
+                        int32_t y,
+                        const struct room_def* room_template,
+                        void* context) {
+    struct room_collector* collector = context;
+
+    // Only catalog templates can be found again by name.
+    if (room_def_get_by_id(room_template->id) != room_template) {
+        return 0;
+    }
+
+    if (collector->count == collector->capacity) {
+        return -EOVERFLOW;
+    }
+
+    collector->entries[collector->count++] = (struct world_file_entry){
+        .x = x,
+        .y = y,
+        .template_index = room_template->id,
+    };
+
+    return 0;
+}
+
+static int reserve_visible_cells(int32_t radius) {
+    size_t side = (size_t)((2 * radius) + 1);
+    if (side * side <= visible_capacity) {
+        return 0;
+    }
+
+    struct world_cell** cells = realloc((void*)visible_cells,
+                                        side * side * sizeof(*visible_cells));
+    if (!cells) {
+        TraceLog(LOG_ERROR,
+                 "WORLD: Failed to allocate visible cells (out of memory).");
+        return -ENOMEM;
+    }
+
+    visible_cells = cells;
+    visible_capacity = side * side;
+    return 0;
+}
+
+static bool is_near_grid_edge(int32_t x, int32_t y) {
+    const int32_t margin = WORLD_MAX_LOAD_RADIUS + UNLOAD_MARGIN;
+    return x > INT32_MAX - margin || x < INT32_MIN + margin ||
+           y > INT32_MAX - margin || y < INT32_MIN + margin;
+}
+
+static void update_residency(int32_t scan_radius) {
+    // Models released below are evicted furthest first, by these distances.
+    grid_update_model_distances(player_grid_x, player_grid_y);
+
+    for (int32_t y = player_grid_y - scan_radius;
+         y <= player_grid_y + scan_radius; y++) {
+        for (int32_t x = player_grid_x - scan_radius;
+             x <= player_grid_x + scan_radius; x++) {
+            struct world_cell* cell = grid_get_cell(x, y);
+            if (!cell) {
+                continue;
+            }
+
+            int32_t dist_x = abs(x - player_grid_x);
+            int32_t dist_y = abs(y - player_grid_y);
+
+            if (dist_x <= load_radius && dist_y <= load_radius) {
+                grid_request_model(cell);
+            } else if (cell->is_model_requested) {
+                // The model stays cached until its memory is needed.
+                grid_unload_model(cell);
+            }
+        }
+    }
+}
+
+static bool is_cell_in_view(const struct world_cell* cell,
+                            const struct frustum* frustum) {
+    BoundingBox bounds;
+    if (!model_cache_get_bounds(cell->template, &bounds)) {
+        return true;
+    }
+
+    Vector3 room_pos = {(float)cell->grid_x * ROOM_SIZE, 0.0F,
+                        (float)cell->grid_y * ROOM_SIZE};
+    BoundingBox box = {
+        .min = Vector3Add(Vector3Scale(bounds.min, ROOM_SCALE), room_pos),
+        .max = Vector3Add(Vector3Scale(bounds.max, ROOM_SCALE), room_pos),
+    };
+
+    return frustum_intersects_box(frustum, box);
+}
+
+static void stream_nearby_models(void) {
+    for (int32_t y = player_grid_y - load_radius;
+         y <= player_grid_y + load_radius; y++) {
+        for (int32_t x = player_grid_x - load_radius;
+             x <= player_grid_x + load_radius; x++) {
+            struct world_cell* cell = grid_get_cell(x, y);
+            if (cell && !cell->is_model_loaded) {
+                grid_request_model(cell);
+            }
+        }
+    }
+}
@@ -0,0 +1,369 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "game/world/world_file.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "raylib.h"
+
+#include "game/world/grid.h"
+
+static_assert(sizeof(struct world_file_header) == 72,
+              "world_file_header must not contain padding");
+static_assert(sizeof(struct world_file_name) == WORLD_FILE_NAME_SIZE,
+              "world_file_name must not contain padding");
+static_assert(sizeof(struct world_file_region) == 24,
+              "world_file_region must not contain padding");
+static_assert(sizeof(struct world_file_room) == 4,
+              "world_file_room must not contain padding");
+
+static int map_file(struct world_file* file, const char* path);
+static bool is_valid(const struct world_file* file);
+static int compare_entries(const void* a, const void* b);
+static int compare_region(const struct world_file_region* region,
+                          int32_t region_x,
+                          int32_t region_y);
+static int write_file(FILE* out,
+                      const struct world_file_info* info,
+                      const struct world_file_entry* rooms,
+                      size_t room_count,
+                      size_t region_count);
+static inline int32_t region_coord(int32_t v);
+
+int world_file_open(struct world_file* file, const char* path) {
+    memset(file, 0, sizeof(*file));
+
+    int ret = map_file(file, path);
+    if (ret != 0) {
+        return ret;
+    }
+
+    file->header = (const struct world_file_header*)file->data;
+    if (!is_valid(file)) {
+        TraceLog(LOG_WARNING, "WORLD_FILE: Invalid or outdated file: %s",
+                 path);
+        world_file_close(file);
+        return -EINVAL;
+    }
+
+    const struct world_file_header* header = file->header;
+    file->names = (const struct world_file_name*)(header + 1);
+    file->regions = (const struct world_file_region*)(file->names +
+                                                      header->template_count);
+    file->rooms = (const struct world_file_room*)(file->regions +
+                                                  header->region_count);
+
+    return 0;
+}
+
+const struct world_file_region* world_file_find_region(
+    const struct world_file* file,
+    int32_t region_x,
+    int32_t region_y) {
+    size_t low = 0;
+    size_t high = file->header->region_count;
+    while (low < high) {
+        size_t mid = low + ((high - low) / 2);
+        int order = compare_region(&file->regions[mid], region_x, region_y);
+        if (order == 0) {
+            return &file->regions[mid];
+        }
+
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return nullptr;
+}
+
+const struct world_file_room* world_file_get_rooms(
+    const struct world_file* file,
+    const struct world_file_region* region) {
+    uint64_t room_count = file->header->room_count;
+    if (region->first_room > room_count ||
+        region->room_count > room_count - region->first_room) {
+        return nullptr;
+    }
+
+    return &file->rooms[region->first_room];
+}
+
+const char* world_file_get_name(const struct world_file* file,
+                                uint16_t template_index) {
+    if (template_index >= file->header->template_count) {
+        return nullptr;
+    }
+
+    const char* name = file->names[template_index].name;
+    return memchr(name, '\0', WORLD_FILE_NAME_SIZE) ? name : nullptr;
+}
+
+void world_file_close(struct world_file* file) {
+    if (file->data) {
+#ifndef _WIN32
+        munmap((void*)file->data, file->size);
+#else
+        UnloadFileData((unsigned char*)file->data);
+#endif
+    }
+
+    memset(file, 0, sizeof(*file));
+}
+
+int world_file_write(const char* path,
+                     const struct world_file_info* info,
+                     struct world_file_entry* rooms,
+                     size_t room_count) {
+    if (info->template_count > (size_t)UINT16_MAX + 1 ||
+        (room_count > 0 && !rooms)) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; i < info->template_count; i++) {
+        if (strlen(info->names[i]) >= WORLD_FILE_NAME_SIZE) {
+            return -EINVAL;
+        }
+    }
+
+    for (size_t i = 0; i < room_count; i++) {
+        if (rooms[i].template_index >= info->template_count) {
+            return -EINVAL;
+        }
+    }
+
+    qsort(rooms, room_count, sizeof(*rooms), compare_entries);
+
+    size_t region_count = 0;
+    for (size_t i = 0; i < room_count; i++) {
+        if (i == 0 ||
+            region_coord(rooms[i].x) != region_coord(rooms[i - 1].x) ||
+            region_coord(rooms[i].y) != region_coord(rooms[i - 1].y)) {
+            region_count++;
+        }
+    }
+
+    if (region_count > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    // Written under a temporary name first, so the previous save stays
+    // intact, and mappable, until the new one is complete.
+    size_t path_length = strlen(path);
+    char* temp_path = malloc(path_length + sizeof(".tmp"));
+    if (!temp_path) {
+        return -ENOMEM;
+    }
+    memcpy(temp_path, path, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    FILE* out = fopen(temp_path, "wb");
+    if (!out) {
+        free(temp_path);
+        return -EIO;
+    }
+
+    int ret = write_file(out, info, rooms, room_count, region_count);
+    if (fclose(out) != 0 && ret == 0) {
+        ret = -EIO;
+    }
+
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows.
+    if (ret == 0) {
+        (void)remove(path);
+    }
+#endif
+    if (ret == 0 && rename(temp_path, path) != 0) {
+        ret = -EIO;
+    }
+
+    if (ret != 0) {
+        (void)remove(temp_path);
+    }
+    free(temp_path);
+
+    return ret;
+}
+
+static int map_file(struct world_file* file, const char* path) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -ENOENT;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return -ENOENT;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+                      fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -ENOENT;
+    }
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    file->is_mapped = true;
+#else
+    if (!FileExists(path)) {
+        return -ENOENT;
+    }
+
+    int size = 0;
+    unsigned char* data = LoadFileData(path, &size);
+    if (!data || size <= 0) {
+        UnloadFileData(data);
+        return -ENOENT;
+    }
+
+    file->data = data;
+    file->size = (size_t)size;
+    file->is_mapped = false;
+#endif
+
+    return 0;
+}
+
+static bool is_valid(const struct world_file* file) {
+    const struct world_file_header* header = file->header;
+    if (file->size < sizeof(*header) ||
+        memcmp(header->magic, WORLD_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != WORLD_FILE_VERSION ||
+        header->region_size != GRID_REGION_SIZE ||
+        header->template_count > (uint32_t)UINT16_MAX + 1) {
+        return false;
+    }
+
+    // The tables follow the header back to back and fill the rest of the
+    // file exactly.
+    uint64_t remaining = file->size - sizeof(*header);
+    uint64_t tables_size =
+        ((uint64_t)header->template_count * sizeof(struct world_file_name)) +
+        ((uint64_t)header->region_count * sizeof(struct world_file_region));
+    if (tables_size > remaining) {
+        return false;
+    }
+
+    remaining -= tables_size;
+    return remaining % sizeof(struct world_file_room) == 0 &&
+           remaining / sizeof(struct world_file_room) == header->room_count;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const struct world_file_entry* lhs = a;
+    const struct world_file_entry* rhs = b;
+
+    int32_t keys[2][4] = {
+        {region_coord(lhs->y), region_coord(lhs->x), lhs->y, lhs->x},
+        {region_coord(rhs->y), region_coord(rhs->x), rhs->y, rhs->x},
+    };
+    for (size_t i = 0; i < 4; i++) {
+        if (keys[0][i] != keys[1][i]) {
+            return keys[0][i] < keys[1][i] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+static int compare_region(const struct world_file_region* region,
+                          int32_t region_x,
+                          int32_t region_y) {
+    if (region->y != region_y) {
+        return region->y < region_y ? -1 : 1;
+    }
+
+    if (region->x != region_x) {
+        return region->x < region_x ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static int write_file(FILE* out,
+                      const struct world_file_info* info,
+                      const struct world_file_entry* rooms,
+                      size_t room_count,
+                      size_t region_count) {
+    struct world_file_header header = {
+        .version = WORLD_FILE_VERSION,
+        .seed = info->seed,
+        .rng_mode = info->rng_mode,
+        .region_size = GRID_REGION_SIZE,
+        .template_count = (uint32_t)info->template_count,
+        .region_count = (uint32_t)region_count,
+        .room_count = room_count,
+    };
+    memcpy(header.magic, WORLD_FILE_MAGIC, sizeof(header.magic));
+    memcpy(header.rng_state, info->rng_state, sizeof(header.rng_state));
+
+    if (fwrite(&header, sizeof(header), 1, out) != 1) {
+        return -EIO;
+    }
+
+    for (size_t i = 0; i < info->template_count; i++) {
+        struct world_file_name name = {0};
+        memcpy(name.name, info->names[i], strlen(info->names[i]));
+        if (fwrite(&name, sizeof(name), 1, out) != 1) {
+            return -EIO;
+        }
+    }
+
+    // Rooms are sorted by region, so every run of equal regions becomes one
+    // index entry.
+    for (size_t first = 0; first < room_count;) {
+        struct world_file_region region = {
+            .x = region_coord(rooms[first].x),
+            .y = region_coord(rooms[first].y),
+            .first_room = first,
+        };
+        size_t end = first;
+        while (end < room_count && region_coord(rooms[end].x) == region.x &&
+               region_coord(rooms[end].y) == region.y) {
+            end++;
+        }
+        region.room_count = (uint32_t)(end - first);
+
+        if (fwrite(&region, sizeof(region), 1, out) != 1) {
+            return -EIO;
+        }
+        first = end;
+    }
+
+    for (size_t i = 0; i < room_count; i++) {
+        int32_t region_x = region_coord(rooms[i].x);
+        int32_t region_y = region_coord(rooms[i].y);
+        struct world_file_room room = {
+            .offset_x = (uint8_t)(rooms[i].x - (region_x * GRID_REGION_SIZE)),
+            .offset_y = (uint8_t)(rooms[i].y - (region_y * GRID_REGION_SIZE)),
+            .template_index = rooms[i].template_index,
+        };
+        if (fwrite(&room, sizeof(room), 1, out) != 1) {
+            return -EIO;
+        }
+    }
+
+    return 0;
+}
+
+static inline int32_t region_coord(int32_t v) {
+    // Must round the same way as the grid's regions do.
+    return v >= 0 ? v / GRID_REGION_SIZE : -1 - ((-1 - v) / GRID_REGION_SIZE);
+}
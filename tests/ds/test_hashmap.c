@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -173,6 +174,61 @@ void test_iterator(void) {
     hashmap_destroy(&map);
 }
 
+void test_grid_keys_with_churn(void) {
+    struct hashmap map;
+    static int values[64 * 64];
+    assert(hashmap_init(&map) == 0);
+
+    for (int32_t y = 0; y < 64; y++) {
+        for (int32_t x = 0; x < 64; x++) {
+            uint64_t key = ((uint64_t)(uint32_t)(x - 32) << 32U) |
+                           (uint32_t)(y - 32);
+            assert(hashmap_set(&map, key, &values[(y * 64) + x], nullptr) ==
+                   0);
+        }
+    }
+    assert(hashmap_len(&map) == 64 * 64);
+    size_t capacity = hashmap_capacity(&map);
+    assert((capacity & (capacity - 1)) == 0);
+
+    for (int round = 0; round < 8; round++) {
+        for (int32_t y = 0; y < 64; y++) {
+            for (int32_t x = 0; x < 64; x += 2) {
+                uint64_t key = ((uint64_t)(uint32_t)(x - 32) << 32U) |
+                               (uint32_t)(y - 32);
+                assert(hashmap_remove(&map, key) == &values[(y * 64) + x]);
+            }
+        }
+        assert(hashmap_len(&map) == 64 * 32);
+
+        for (int32_t y = 0; y < 64; y++) {
+            for (int32_t x = 0; x < 64; x += 2) {
+                uint64_t key = ((uint64_t)(uint32_t)(x - 32) << 32U) |
+                               (uint32_t)(y - 32);
+                assert(hashmap_get(&map, key) == nullptr);
+                assert(hashmap_set(&map, key, &values[(y * 64) + x],
+                                   nullptr) == 0);
+            }
+        }
+        assert(hashmap_len(&map) == 64 * 64);
+    }
+    assert(hashmap_capacity(&map) == capacity);
+
+    size_t iter = 0;
+    uint64_t key = 0;
+    void* value = nullptr;
+    size_t visited = 0;
+    while (hashmap_iter(&map, &iter, &key, &value)) {
+        int32_t x = (int32_t)(uint32_t)(key >> 32U) + 32;
+        int32_t y = (int32_t)(uint32_t)key + 32;
+        assert(value == &values[(y * 64) + x]);
+        visited++;
+    }
+    assert(visited == 64 * 64);
+
+    hashmap_destroy(&map);
+}
+
 int main(void) {
     puts("Starting hashmap tests.\n");
 
@@ -185,6 +241,7 @@ int main(void) {
     RUN_TEST(test_resizing);
     RUN_TEST(test_null_args);
     RUN_TEST(test_iterator);
+    RUN_TEST(test_grid_keys_with_churn);
 
     puts("\nAll hashmap tests passed successfully!");
 
@@ -0,0 +1,216 @@
+#include "game/anim_cache.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+
+#include "game/anim.h"
+#include "game/anim_file.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+enum { CLIP_COUNT = 3, CLIP_SIZE = 8, CLIP_BYTES = CLIP_SIZE * CLIP_SIZE * 4 };
+
+static const char* CLIP_PATHS[CLIP_COUNT] = {
+    "test_anim_cache_0.anim",
+    "test_anim_cache_1.anim",
+    "test_anim_cache_2.anim",
+};
+
+static void write_clips(void) {
+    for (int i = 0; i < CLIP_COUNT; i++) {
+        int frame_count = i + 1;
+        size_t pixels = (size_t)CLIP_SIZE * CLIP_SIZE * frame_count;
+        Color* data = malloc(pixels * sizeof(Color));
+        for (size_t p = 0; p < pixels; p++) {
+            data[p] = WHITE;
+        }
+
+        Image image = {
+            .data = data,
+            .width = CLIP_SIZE,
+            .height = CLIP_SIZE,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+        };
+        assert(anim_file_write(CLIP_PATHS[i], image, frame_count, nullptr) ==
+               0);
+        free(data);
+    }
+}
+
+static void remove_clips(void) {
+    for (int i = 0; i < CLIP_COUNT; i++) {
+        assert(remove(CLIP_PATHS[i]) == 0);
+    }
+}
+
+void test_clips_load_on_first_use(void) {
+    assert(anim_cache_init(CLIP_BYTES * CLIP_COUNT * 4) == 0);
+
+    struct anim_clip* clip = anim_cache_acquire(CLIP_PATHS[1]);
+    assert(clip);
+    assert(anim_cache_acquire(CLIP_PATHS[1]) == clip);
+    assert(clip->refcount == 2);
+    assert(!clip->is_loaded);
+    assert(anim_cache_get_loaded_count() == 0);
+
+    const struct atlas* atlas = anim_cache_use(clip);
+    assert(atlas);
+    assert(clip->is_loaded);
+    assert(clip->frame_count == 2);
+    assert(atlas->frame_count == 2);
+    assert(anim_cache_get_loaded_count() == 1);
+    assert(anim_cache_get_resident_bytes() == clip->texture_bytes);
+
+    struct anim_clip* missing = anim_cache_acquire("missing.anim");
+    assert(missing);
+    assert(anim_cache_use(missing) == nullptr);
+    assert(missing->is_missing);
+
+    anim_cache_destroy();
+    assert(anim_cache_acquire(CLIP_PATHS[0]) == nullptr);
+}
+
+void test_least_recently_used_clip_is_evicted(void) {
+    assert(anim_cache_init(0) == 0);
+
+    struct anim_clip* clips[CLIP_COUNT];
+    size_t bytes[CLIP_COUNT];
+    for (int i = 0; i < CLIP_COUNT; i++) {
+        clips[i] = anim_cache_acquire(CLIP_PATHS[i]);
+        assert(anim_cache_use(clips[i]));
+        bytes[i] = clips[i]->texture_bytes;
+        assert(bytes[i] > 0);
+    }
+
+    // With no budget, only the clip in use stays resident.
+    assert(anim_cache_get_loaded_count() == 1);
+    assert(clips[2]->is_loaded);
+
+    size_t two_clips = bytes[1] + bytes[2];
+    assert(anim_cache_init(two_clips) == 0);
+
+    assert(anim_cache_use(clips[0]));
+    assert(anim_cache_use(clips[2]));
+    assert(anim_cache_get_resident_bytes() <= two_clips);
+
+    assert(anim_cache_use(clips[1]));
+    assert(!clips[0]->is_loaded);
+    assert(clips[1]->is_loaded && clips[2]->is_loaded);
+    assert(anim_cache_get_resident_bytes() <= two_clips);
+
+    // Evicted clips come back with the same frames.
+    const struct atlas* atlas = anim_cache_use(clips[0]);
+    assert(atlas && atlas->frame_count == 1);
+    assert(!clips[2]->is_loaded);
+
+    anim_cache_destroy();
+}
+
+void test_pinned_clips_are_never_evicted(void) {
+    assert(anim_cache_init(0) == 0);
+
+    struct anim_clip* pinned = anim_cache_acquire(CLIP_PATHS[0]);
+    assert(anim_cache_preload(pinned) == 0);
+    assert(pinned->is_loaded && pinned->is_pinned);
+
+    struct anim_clip* other = anim_cache_acquire(CLIP_PATHS[1]);
+    assert(anim_cache_use(other));
+    assert(anim_cache_use(anim_cache_acquire(CLIP_PATHS[2])));
+
+    assert(pinned->is_loaded);
+    assert(!other->is_loaded);
+    assert(anim_cache_get_loaded_count() == 2);
+
+    anim_cache_destroy();
+}
+
+void test_preload_all_decodes_every_clip(void) {
+    assert(anim_cache_init(0) == 0);
+
+    struct anim_clip* clips[] = {
+        anim_cache_acquire(CLIP_PATHS[0]),
+        anim_cache_acquire(CLIP_PATHS[1]),
+        anim_cache_acquire("missing.anim"),
+        anim_cache_acquire(CLIP_PATHS[2]),
+        anim_cache_acquire(CLIP_PATHS[1]),
+    };
+    size_t count = sizeof(clips) / sizeof(clips[0]);
+
+    assert(anim_cache_preload_all(clips, count) == -ENOENT);
+    assert(clips[2]->is_missing && !clips[2]->is_loaded);
+    assert(anim_cache_get_loaded_count() == CLIP_COUNT);
+
+    size_t bytes = 0;
+    for (int i = 0; i < CLIP_COUNT; i++) {
+        struct anim_clip* clip = anim_cache_acquire(CLIP_PATHS[i]);
+        assert(clip->is_loaded && clip->is_pinned);
+        assert(clip->frame_count == i + 1);
+        bytes += clip->texture_bytes;
+    }
+    assert(anim_cache_get_resident_bytes() == bytes);
+
+    assert(anim_cache_preload_all(clips, 2) == 0);
+    assert(anim_cache_get_loaded_count() == CLIP_COUNT);
+
+    anim_cache_destroy();
+}
+
+void test_clips_are_freed_with_last_reference(void) {
+    assert(anim_cache_init(CLIP_BYTES * CLIP_COUNT * 4) == 0);
+
+    struct anim first;
+    struct anim second;
+    assert(init_anim(&first, CLIP_PATHS[2], 1) == 0);
+    assert(init_anim(&second, CLIP_PATHS[2], 2) == 0);
+    assert(first.clip == second.clip);
+    assert(anim_cache_preload(first.clip) == 0);
+
+    // Playback state is per animation, frames are not.
+    update_anim(&first);
+    update_anim(&second);
+    assert(first.current_frame == 1);
+    assert(second.current_frame == 0);
+    assert(anim_cache_get_loaded_count() == 1);
+
+    unload_anim(&first);
+    assert(first.clip == nullptr);
+    assert(second.clip->is_loaded);
+    assert(anim_cache_get_loaded_count() == 1);
+
+    struct anim_clip* clip = second.clip;
+    unload_anim(&second);
+    assert(anim_cache_get_loaded_count() == 0);
+    assert(anim_cache_get_resident_bytes() == 0);
+    assert(anim_cache_release(clip) == -ENOENT);
+    assert(anim_cache_release(nullptr) == -EINVAL);
+
+    anim_cache_destroy();
+}
+
+int main(void) {
+    InitWindow(100, 100, "Animation Cache Test");
+    write_clips();
+
+    puts("Starting anim_cache tests.\n");
+
+    RUN_TEST(test_clips_load_on_first_use);
+    RUN_TEST(test_least_recently_used_clip_is_evicted);
+    RUN_TEST(test_pinned_clips_are_never_evicted);
+    RUN_TEST(test_preload_all_decodes_every_clip);
+    RUN_TEST(test_clips_are_freed_with_last_reference);
+
+    puts("\nAll anim_cache tests passed successfully!");
+
+    remove_clips();
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
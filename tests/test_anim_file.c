@@ -0,0 +1,120 @@
+#include "game/anim_file.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static const char* TEST_PATH = "test_anim_file.anim";
+
+static Image make_strip(int width, int height, int frame_count) {
+    return (Image){
+        .data = calloc((size_t)width * height * frame_count, sizeof(Color)),
+        .width = width,
+        .height = height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+}
+
+static void set_pixel(Image image, int frame, int x, int y, Color color) {
+    Color* pixels = (Color*)image.data + (frame * image.width * image.height);
+    pixels[(y * image.width) + x] = color;
+}
+
+static void write_bytes(const char* path, const void* data, size_t size) {
+    FILE* out = fopen(path, "wb");
+    assert(out);
+    assert(fwrite(data, 1, size, out) == size);
+    assert(fclose(out) == 0);
+}
+
+void test_write_and_open(void) {
+    Image strip = make_strip(16, 8, 3);
+    set_pixel(strip, 0, 3, 2, (Color){1, 2, 3, 255});
+    set_pixel(strip, 0, 5, 4, (Color){4, 5, 6, 128});
+    set_pixel(strip, 2, 15, 7, (Color){7, 8, 9, 255});
+
+    const int delays[] = {40, 0, 120};
+    assert(anim_file_write(TEST_PATH, strip, 3, delays) == 0);
+    UnloadImage(strip);
+
+    struct anim_file file;
+    assert(anim_file_open(&file, TEST_PATH) == 0);
+    assert(file.header->canvas_width == 16);
+    assert(file.header->canvas_height == 8);
+    assert(file.header->frame_count == 3);
+
+    const struct anim_file_frame* frame = &file.frames[0];
+    assert(frame->x == 3 && frame->y == 2);
+    assert(frame->width == 3 && frame->height == 3);
+    assert(frame->delay_ms == 40);
+
+    const Color* pixels = anim_file_get_pixels(&file, 0);
+    assert(pixels);
+    assert(pixels[0].r == 1 && pixels[0].a == 255);
+    assert(pixels[(2 * 3) + 2].r == 4 && pixels[(2 * 3) + 2].a == 128);
+    assert(pixels[1].a == 0);
+
+    assert(file.frames[1].width == 0 && file.frames[1].height == 0);
+    assert(anim_file_get_pixels(&file, 1) == nullptr);
+
+    frame = &file.frames[2];
+    assert(frame->x == 15 && frame->y == 7);
+    assert(frame->delay_ms == 120);
+    assert(anim_file_get_pixels(&file, 2)->b == 9);
+    assert(anim_file_get_pixels(&file, 3) == nullptr);
+
+    anim_file_close(&file);
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_open_rejects_invalid_files(void) {
+    struct anim_file file;
+    assert(anim_file_open(&file, "missing.anim") == -ENOENT);
+
+    const char garbage[] = "definitely not an animation file";
+    write_bytes(TEST_PATH, garbage, sizeof(garbage));
+    assert(anim_file_open(&file, TEST_PATH) == -EINVAL);
+
+    Image strip = make_strip(4, 4, 1);
+    set_pixel(strip, 0, 1, 1, WHITE);
+    assert(anim_file_write(TEST_PATH, strip, 1, nullptr) == 0);
+    UnloadImage(strip);
+
+    assert(anim_file_open(&file, TEST_PATH) == 0);
+    size_t size = file.size;
+    unsigned char* copy = malloc(size);
+    memcpy(copy, file.data, size);
+    anim_file_close(&file);
+
+    write_bytes(TEST_PATH, copy, size - 1);
+    assert(anim_file_open(&file, TEST_PATH) == -EINVAL);
+
+    ((struct anim_file_header*)copy)->version = ANIM_FILE_VERSION + 1;
+    write_bytes(TEST_PATH, copy, size);
+    assert(anim_file_open(&file, TEST_PATH) == -EINVAL);
+
+    free(copy);
+    assert(remove(TEST_PATH) == 0);
+}
+
+int main(void) {
+    puts("Starting anim_file tests.\n");
+
+    RUN_TEST(test_write_and_open);
+    RUN_TEST(test_open_rejects_invalid_files);
+
+    puts("\nAll anim_file tests passed successfully!");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,254 @@
+#include "game/atlas.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+
+#include "game/sprite_batch.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static Image make_strip(int width, int height, int frame_count) {
+    return (Image){
+        .data = calloc((size_t)width * height * frame_count, sizeof(Color)),
+        .width = width,
+        .height = height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+}
+
+static void fill_rect(Image image,
+                      int frame,
+                      int x,
+                      int y,
+                      int width,
+                      int height) {
+    Color* pixels = (Color*)image.data + (frame * image.width * image.height);
+    for (int row = y; row < y + height; row++) {
+        for (int col = x; col < x + width; col++) {
+            pixels[(row * image.width) + col] = WHITE;
+        }
+    }
+}
+
+static bool rects_overlap(Rectangle a, Rectangle b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+void test_frames_are_trimmed(void) {
+    struct atlas atlas;
+    assert(atlas_init(&atlas, 0) == 0);
+
+    Image strip = make_strip(16, 8, 3);
+    fill_rect(strip, 0, 3, 2, 4, 3);
+    fill_rect(strip, 2, 15, 7, 1, 1);
+
+    int first = -1;
+    assert(atlas_add_frames(&atlas, strip, 3, &first) == 0);
+    UnloadImage(strip);
+    assert(first == 0);
+    assert(atlas.frame_count == 3);
+    assert(atlas.canvas_width == 16 && atlas.canvas_height == 8);
+
+    assert(atlas_build(&atlas) == 0);
+    assert(atlas.page_count == 1);
+
+    const struct atlas_frame* frame = &atlas.frames[0];
+    assert(frame->page == 0);
+    assert(frame->offset.x == 3.0F && frame->offset.y == 2.0F);
+    assert(frame->source.width == 4.0F && frame->source.height == 3.0F);
+
+    assert(atlas.frames[1].page == -1);
+    assert(atlas.frames[1].source.width == 0.0F);
+
+    frame = &atlas.frames[2];
+    assert(frame->offset.x == 15.0F && frame->offset.y == 7.0F);
+    assert(frame->source.width == 1.0F && frame->source.height == 1.0F);
+
+    atlas_destroy(&atlas);
+}
+
+void test_frames_spill_onto_pages(void) {
+    struct atlas atlas;
+    assert(atlas_init(&atlas, 32) == 0);
+
+    enum { FRAMES = 24 };
+    Image strip = make_strip(20, 20, FRAMES);
+    for (int i = 0; i < FRAMES; i++) {
+        fill_rect(strip, i, i % 5, i % 3, 6 + (i % 7), 5 + (i % 11));
+    }
+
+    int first = -1;
+    assert(atlas_add_frames(&atlas, strip, FRAMES, &first) == 0);
+    UnloadImage(strip);
+    assert(atlas_build(&atlas) == 0);
+    assert(atlas.page_count > 1);
+
+    for (int i = 0; i < FRAMES; i++) {
+        const struct atlas_frame* frame = &atlas.frames[i];
+        assert(frame->page >= 0 && frame->page < atlas.page_count);
+        assert(frame->source.width == (float)(6 + (i % 7)));
+        assert(frame->source.height == (float)(5 + (i % 11)));
+        assert(frame->source.x + frame->source.width <= 32.0F);
+        assert(frame->source.y + frame->source.height <= 32.0F);
+
+        for (int j = 0; j < i; j++) {
+            const struct atlas_frame* other = &atlas.frames[j];
+            assert(other->page != frame->page ||
+                   !rects_overlap(other->source, frame->source));
+        }
+    }
+
+    atlas_destroy(&atlas);
+}
+
+void test_duplicate_frames_share_pixels(void) {
+    struct atlas atlas;
+    assert(atlas_init(&atlas, 0) == 0);
+
+    Image strip = make_strip(16, 16, 4);
+    fill_rect(strip, 0, 1, 1, 4, 3);
+    fill_rect(strip, 1, 9, 6, 4, 3);
+    fill_rect(strip, 2, 1, 1, 3, 4);
+    fill_rect(strip, 3, 1, 1, 4, 3);
+
+    assert(atlas_add_frames(&atlas, strip, 4, nullptr) == 0);
+    UnloadImage(strip);
+    assert(atlas.pixels[0] && atlas.pixels[2]);
+    assert(!atlas.pixels[1] && !atlas.pixels[3]);
+
+    assert(atlas_build(&atlas) == 0);
+    const struct atlas_frame* frames = atlas.frames;
+    for (int i = 1; i < 4; i += 2) {
+        assert(frames[i].page == frames[0].page);
+        assert(frames[i].source.x == frames[0].source.x);
+        assert(frames[i].source.y == frames[0].source.y);
+        assert(frames[i].source.width == frames[0].source.width);
+    }
+    assert(frames[1].offset.x == 9.0F && frames[1].offset.y == 6.0F);
+    assert(!rects_overlap(frames[0].source, frames[2].source));
+
+    atlas_destroy(&atlas);
+}
+
+void test_invalid_frames_are_rejected(void) {
+    struct atlas atlas;
+    assert(atlas_init(&atlas, -1) == -EINVAL);
+    assert(atlas_init(&atlas, 8) == 0);
+
+    Image strip = make_strip(16, 16, 1);
+    fill_rect(strip, 0, 0, 0, 16, 16);
+    assert(atlas_add_frames(&atlas, strip, 0, nullptr) == -EINVAL);
+    assert(atlas_add_frames(&atlas, strip, 1, nullptr) == 0);
+    UnloadImage(strip);
+
+    Image other = make_strip(8, 8, 1);
+    assert(atlas_add_frames(&atlas, other, 1, nullptr) == -EINVAL);
+    assert(atlas_build(&atlas) == -ENOSPC);
+    atlas_destroy(&atlas);
+
+    assert(atlas_init(&atlas, 0) == 0);
+    fill_rect(other, 0, 1, 1, 2, 2);
+    assert(atlas_add_frames(&atlas, other, 1, nullptr) == 0);
+    assert(atlas_build(&atlas) == 0);
+    assert(atlas_add_frames(&atlas, other, 1, nullptr) == -EBUSY);
+    assert(atlas_build(&atlas) == -EBUSY);
+    UnloadImage(other);
+    atlas_destroy(&atlas);
+}
+
+static Image make_colored_strip(int width, int height, int color_count) {
+    Image strip = make_strip(width, height, 1);
+    Color* pixels = strip.data;
+    for (int i = 0; i < width * height; i++) {
+        int color = i % color_count;
+        pixels[i] = (Color){(unsigned char)color, (unsigned char)(color >> 8),
+                            0x80, 255};
+    }
+    // Transparent pixels keep their color channels, as in decoded GIFs.
+    pixels[0] = (Color){12, 34, 56, 0};
+
+    return strip;
+}
+
+void test_indexed_pages_match_rgba_pixels(void) {
+    struct atlas atlas;
+    assert(atlas_init(&atlas, 0) == 0);
+
+    Image strip = make_colored_strip(32, 16, ATLAS_PALETTE_SIZE - 1);
+    assert(atlas_add_frames(&atlas, strip, 1, nullptr) == 0);
+    assert(atlas_pack(&atlas) == 0);
+    assert(atlas.is_indexed);
+
+    const Image* page = &atlas.packed_pages[0];
+    assert(page->format == PIXELFORMAT_UNCOMPRESSED_GRAYSCALE);
+    const unsigned char* slots = page->data;
+    const Color* palette = atlas.packed_palette.data;
+    const Color* pixels = strip.data;
+    const struct atlas_frame* frame = &atlas.frames[0];
+
+    for (int y = 0; y < (int)frame->source.height; y++) {
+        for (int x = 0; x < (int)frame->source.width; x++) {
+            int canvas_x = (int)frame->offset.x + x;
+            int canvas_y = (int)frame->offset.y + y;
+            int page_x = (int)frame->source.x + x;
+            int page_y = (int)frame->source.y + y;
+            Color expected = pixels[(canvas_y * strip.width) + canvas_x];
+            Color actual = palette[slots[(page_y * page->width) + page_x]];
+            if (expected.a == 0) {
+                assert(actual.a == 0);
+            } else {
+                assert(memcmp(&expected, &actual, sizeof(Color)) == 0);
+            }
+        }
+    }
+
+    assert(atlas_upload(&atlas) == 0);
+    assert(atlas.page_count == 1);
+    assert(atlas_get_texture_bytes(&atlas) ==
+           ((size_t)atlas.pages[0].width * atlas.pages[0].height) +
+               (ATLAS_PALETTE_SIZE * sizeof(Color)));
+    atlas_destroy(&atlas);
+    UnloadImage(strip);
+
+    // One color more than the palette holds keeps the pages in RGBA.
+    assert(atlas_init(&atlas, 0) == 0);
+    strip = make_colored_strip(32, 16, ATLAS_PALETTE_SIZE);
+    assert(atlas_add_frames(&atlas, strip, 1, nullptr) == 0);
+    UnloadImage(strip);
+    assert(atlas_build(&atlas) == 0);
+    assert(!atlas.is_indexed);
+    assert(atlas_get_texture_bytes(&atlas) ==
+           (size_t)atlas.pages[0].width * atlas.pages[0].height *
+               sizeof(Color));
+    atlas_destroy(&atlas);
+}
+
+int main(void) {
+    InitWindow(100, 100, "Atlas Test");
+    assert(sprite_batch_init() == 0);
+
+    puts("Starting atlas tests.\n");
+
+    RUN_TEST(test_frames_are_trimmed);
+    RUN_TEST(test_frames_spill_onto_pages);
+    RUN_TEST(test_duplicate_frames_share_pixels);
+    RUN_TEST(test_invalid_frames_are_rejected);
+    RUN_TEST(test_indexed_pages_match_rgba_pixels);
+
+    puts("\nAll atlas tests passed successfully!");
+
+    sprite_batch_destroy();
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
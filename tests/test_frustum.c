@@ -0,0 +1,72 @@
+#include "game/frustum.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static struct frustum make_frustum(Vector3 position, Vector3 target) {
+    Matrix view = MatrixLookAt(position, target, (Vector3){0.0F, 1.0F, 0.0F});
+    Matrix projection = MatrixPerspective(60.0 * DEG2RAD, 1.0, 0.1, 100.0);
+    return frustum_from_matrix(MatrixMultiply(view, projection));
+}
+
+static BoundingBox make_box(Vector3 center, float half_size) {
+    return (BoundingBox){
+        .min = {center.x - half_size, center.y - half_size,
+                center.z - half_size},
+        .max = {center.x + half_size, center.y + half_size,
+                center.z + half_size},
+    };
+}
+
+void test_boxes_in_view_intersect(void) {
+    struct frustum frustum =
+        make_frustum((Vector3){0.0F, 0.0F, 10.0F}, (Vector3){0});
+
+    assert(frustum_intersects_box(&frustum, make_box((Vector3){0}, 1.0F)));
+    assert(frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, 0.0F, -80.0F}, 1.0F)));
+
+    // A box around the camera reaches into the frustum.
+    assert(frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, 0.0F, 10.0F}, 5.0F)));
+}
+
+void test_boxes_out_of_view_are_rejected(void) {
+    struct frustum frustum =
+        make_frustum((Vector3){0.0F, 0.0F, 10.0F}, (Vector3){0});
+
+    // Behind the camera, beyond the far plane, and off to each side.
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, 0.0F, 20.0F}, 1.0F)));
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, 0.0F, -200.0F}, 1.0F)));
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){50.0F, 0.0F, 0.0F}, 1.0F)));
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){-50.0F, 0.0F, 0.0F}, 1.0F)));
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, 50.0F, 0.0F}, 1.0F)));
+    assert(!frustum_intersects_box(
+        &frustum, make_box((Vector3){0.0F, -50.0F, 0.0F}, 1.0F)));
+}
+
+int main(void) {
+    puts("Starting frustum tests.\n");
+
+    RUN_TEST(test_boxes_in_view_intersect);
+    RUN_TEST(test_boxes_out_of_view_are_rejected);
+
+    puts("\nAll frustum tests passed successfully!");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "game/profiler.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        profiler_reset();                       \
+        test();                                 \
+    } while (0)
+
+void test_zone_time_is_recorded(void) {
+    profiler_begin("slow");
+    WaitTime(0.005);
+    profiler_end("slow");
+
+    profiler_begin("fast");
+    profiler_end("fast");
+
+    profiler_end_frame();
+
+    assert(profiler_get_zone_ms("slow") >= 4.0);
+    assert(profiler_get_zone_ms("fast") < profiler_get_zone_ms("slow"));
+    assert(profiler_get_zone_ms("unknown") == 0.0);
+}
+
+void test_zones_accumulate_per_frame(void) {
+    for (int i = 0; i < 3; i++) {
+        profiler_begin("repeated");
+        WaitTime(0.002);
+        profiler_end("repeated");
+    }
+    profiler_end_frame();
+    assert(profiler_get_zone_ms("repeated") >= 5.0);
+
+    profiler_end_frame();
+    assert(profiler_get_zone_ms("repeated") == 0.0);
+}
+
+void test_frame_time(void) {
+    profiler_end_frame();
+    assert(profiler_get_frame_ms() == 0.0);
+
+    WaitTime(0.005);
+    profiler_end_frame();
+    assert(profiler_get_frame_ms() >= 4.0);
+
+    for (int i = 0; i < PROFILER_HISTORY * 2; i++) {
+        profiler_end_frame();
+    }
+    assert(profiler_get_frame_ms() < 4.0);
+}
+
+void test_average_skips_frames_without_duration(void) {
+    profiler_end_frame();
+    assert(profiler_get_average_frame_ms() == 0.0);
+
+    for (int i = 0; i < 4; i++) {
+        profiler_begin("steady");
+        WaitTime(0.004);
+        profiler_end("steady");
+        profiler_end_frame();
+    }
+
+    // Four frames of about 4 ms; counting the empty first frame would put
+    // the average at about 3.2 ms.
+    assert(profiler_get_average_frame_ms() >= 3.8);
+    assert(profiler_get_average_zone_ms("steady") >= 3.8);
+    assert(profiler_get_average_zone_ms("unknown") == 0.0);
+}
+
+void test_unbalanced_calls_are_ignored(void) {
+    profiler_end("never_started");
+    profiler_begin(nullptr);
+    profiler_end(nullptr);
+    profiler_end_frame();
+    assert(profiler_get_zone_ms("never_started") == 0.0);
+
+    char names[PROFILER_MAX_ZONES + 1][16];
+    for (int i = 0; i <= PROFILER_MAX_ZONES; i++) {
+        (void)snprintf(names[i], sizeof(names[i]), "zone_%d", i);
+        profiler_begin(names[i]);
+        WaitTime(0.001);
+        profiler_end(names[i]);
+    }
+    profiler_end_frame();
+    assert(profiler_get_zone_ms(names[0]) > 0.0);
+    assert(profiler_get_zone_ms(names[PROFILER_MAX_ZONES]) == 0.0);
+}
+
+int main(void) {
+    InitWindow(100, 100, "Profiler Test");
+
+    puts("Starting profiler tests.\n");
+
+    RUN_TEST(test_zone_time_is_recorded);
+    RUN_TEST(test_zones_accumulate_per_frame);
+    RUN_TEST(test_frame_time);
+    RUN_TEST(test_average_skips_frames_without_duration);
+    RUN_TEST(test_unbalanced_calls_are_ignored);
+
+    puts("\nAll profiler tests passed successfully!");
+
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
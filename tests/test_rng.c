@@ -74,6 +74,85 @@ void test_single_value_range(void) {
     }
 }
 
+void test_context_matches_global(void) {
+    struct rng rng;
+    rng_init_r(&rng, 12345);
+    rng_init(12345);
+
+    for (int i = 0; i < 100; i++) {
+        assert(rng_next_u64_r(&rng) == rng_next_u64());
+        assert(rng_get_range_r(&rng, -5, 5) == rng_get_range(-5, 5));
+    }
+}
+
+void test_contexts_are_independent(void) {
+    struct rng first;
+    struct rng second;
+    rng_init_r(&first, 7);
+    rng_init_r(&second, 7);
+
+    uint64_t expected = rng_next_u64_r(&first);
+    for (int i = 0; i < 10; i++) {
+        (void)rng_next_u64();
+    }
+    assert(rng_next_u64_r(&second) == expected);
+}
+
+void test_jump_splits_streams(void) {
+    struct rng base;
+    rng_init_r(&base, 2024);
+
+    struct rng jumped = base;
+    rng_jump(&jumped);
+    struct rng long_jumped = base;
+    rng_long_jump(&long_jumped);
+    struct rng jumped_again = base;
+    rng_jump(&jumped_again);
+
+    bool jump_differs = false;
+    bool long_jump_differs = false;
+    for (int i = 0; i < 100; i++) {
+        uint64_t a = rng_next_u64_r(&base);
+        uint64_t b = rng_next_u64_r(&jumped);
+        uint64_t c = rng_next_u64_r(&long_jumped);
+        assert(rng_next_u64_r(&jumped_again) == b);
+        jump_differs |= a != b;
+        long_jump_differs |= b != c;
+    }
+    assert(jump_differs);
+    assert(long_jump_differs);
+}
+
+void test_stream_is_pure(void) {
+    uint64_t key = rng_hash_coords(42, 3, -7);
+    assert(key == rng_hash_coords(42, 3, -7));
+    assert(key != rng_hash_coords(42, -7, 3));
+    assert(key != rng_hash_coords(43, 3, -7));
+
+    rng_init(1);
+    uint64_t first = rng_stream_u64(key, 5);
+    rng_init(2);
+    (void)rng_next_u64();
+    assert(rng_stream_u64(key, 5) == first);
+    assert(rng_stream_u64(key, 6) != first);
+}
+
+void test_stream_range_bounds(void) {
+    uint64_t key = rng_hash_coords(999, 0, 0);
+    uint64_t counter = 0;
+    const int min = -10;
+    const int max = 10;
+
+    for (int i = 0; i < 10000; i++) {
+        int val = rng_stream_range(key, &counter, min, max);
+        assert(val >= min && val <= max);
+    }
+    assert(counter >= 10000);
+
+    counter = 0;
+    assert(rng_stream_range(key, &counter, 5, 5) == 5);
+}
+
 int main(void) {
     puts("Starting rng tests.\n");
 
@@ -81,6 +160,11 @@ int main(void) {
     RUN_TEST(test_different_seeds_produce_different_sequences);
     RUN_TEST(test_range_bounds);
     RUN_TEST(test_single_value_range);
+    RUN_TEST(test_context_matches_global);
+    RUN_TEST(test_contexts_are_independent);
+    RUN_TEST(test_jump_splits_streams);
+    RUN_TEST(test_stream_is_pure);
+    RUN_TEST(test_stream_range_bounds);
 
     puts("\nAll rng tests passed successfully!");
 
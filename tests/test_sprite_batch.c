@@ -0,0 +1,265 @@
+#include "game/sprite_batch.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static const Camera3D camera = {
+    .position = {0.0F, 10.0F, 10.0F},
+    .target = {0.0F, 0.0F, 0.0F},
+    .up = {0.0F, 1.0F, 0.0F},
+    .fovy = 45.0F,
+    .projection = CAMERA_PERSPECTIVE,
+};
+
+static Texture2D load_texture(Color color) {
+    Image image = GenImageColor(8, 8, color);
+    Texture2D texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    return texture;
+}
+
+static struct sprite make_sprite(Texture2D texture, float z, Color tint) {
+    return (struct sprite){
+        .texture = texture,
+        .source = {0.0F, 0.0F, 8.0F, 8.0F},
+        .position = {0.0F, 0.0F, z},
+        .size = {1.0F, 1.0F},
+        .origin = {0.5F, 0.5F},
+        .tint = tint,
+    };
+}
+
+void test_sprites_are_grouped_by_texture(void) {
+    Texture2D first = load_texture(RED);
+    Texture2D second = load_texture(BLUE);
+
+    sprite_batch_begin(camera);
+    for (int i = 0; i < 4; i++) {
+        struct sprite sprite =
+            make_sprite(i % 2 == 0 ? first : second, (float)i, WHITE);
+        assert(sprite_batch_add(&sprite) == 0);
+    }
+    sprite_batch_end();
+
+    assert(sprite_batch_get_sprite_count() == 4);
+    assert(sprite_batch_get_batch_count() == 2);
+
+    // Translucent sprites are drawn back to front, so alternating textures
+    // at alternating depths cannot be merged.
+    Color faded = Fade(WHITE, 0.5F);
+    sprite_batch_begin(camera);
+    for (int i = 0; i < 4; i++) {
+        struct sprite sprite =
+            make_sprite(i % 2 == 0 ? first : second, (float)i, faded);
+        assert(sprite_batch_add(&sprite) == 0);
+    }
+    sprite_batch_end();
+
+    assert(sprite_batch_get_sprite_count() == 4);
+    assert(sprite_batch_get_batch_count() == 4);
+
+    UnloadTexture(first);
+    UnloadTexture(second);
+}
+
+void test_palettes_split_batches(void) {
+    if (!sprite_batch_has_palette_shader()) {
+        return;
+    }
+
+    Texture2D page = load_texture(WHITE);
+    Texture2D first_palette = load_texture(RED);
+    Texture2D second_palette = load_texture(BLUE);
+
+    sprite_batch_begin(camera);
+    for (int i = 0; i < 6; i++) {
+        struct sprite sprite = make_sprite(page, (float)i, WHITE);
+        sprite.palette = i % 2 == 0 ? first_palette : second_palette;
+        assert(sprite_batch_add(&sprite) == 0);
+    }
+    sprite_batch_end();
+
+    assert(sprite_batch_get_sprite_count() == 6);
+    assert(sprite_batch_get_batch_count() == 2);
+
+    UnloadTexture(page);
+    UnloadTexture(first_palette);
+    UnloadTexture(second_palette);
+}
+
+void test_palette_survives_batch_flushes(void) {
+    if (!sprite_batch_has_palette_shader()) {
+        return;
+    }
+
+    // More textures than rlgl has draw calls, so it submits the batch on its
+    // own partway through. Every page holds slot 0, which the palette maps
+    // to red.
+    enum { PAGE_COUNT = RL_DEFAULT_BATCH_DRAWCALLS + 8 };
+    Texture2D pages[PAGE_COUNT];
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        pages[i] = load_texture(BLACK);
+    }
+    Texture2D palette = load_texture(RED);
+
+    // Sprites are drawn in texture order, so only the last one drawn, well
+    // after the flush, is put in view.
+    int last = 0;
+    for (int i = 1; i < PAGE_COUNT; i++) {
+        if (pages[i].id > pages[last].id) {
+            last = i;
+        }
+    }
+    RenderTexture2D target = LoadRenderTexture(64, 64);
+    BeginTextureMode(target);
+    ClearBackground(BLUE);
+    BeginMode3D(camera);
+    sprite_batch_begin(camera);
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        struct sprite sprite = make_sprite(pages[i], 0.0F, WHITE);
+        sprite.palette = palette;
+        sprite.size = (Vector2){4.0F, 4.0F};
+        sprite.origin = (Vector2){2.0F, 2.0F};
+        if (i != last) {
+            sprite.position.x = 1000.0F;
+        }
+        assert(sprite_batch_add(&sprite) == 0);
+    }
+    sprite_batch_end();
+    EndMode3D();
+    EndTextureMode();
+
+    assert(sprite_batch_get_batch_count() == PAGE_COUNT);
+
+    Image image = LoadImageFromTexture(target.texture);
+    Color center = GetImageColor(image, 32, 32);
+    assert(center.r == RED.r && center.g == RED.g && center.b == RED.b);
+    UnloadImage(image);
+
+    UnloadRenderTexture(target);
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        UnloadTexture(pages[i]);
+    }
+    UnloadTexture(palette);
+}
+
+void test_skipped_first_sprite_keeps_sprite_shader(void) {
+    if (!sprite_batch_has_palette_shader()) {
+        return;
+    }
+
+    Texture2D page = load_texture(WHITE);
+    Texture2D palette = load_texture(RED);
+    Texture2D clear = load_texture(BLANK);
+    Texture2D solid = load_texture(RED);
+
+    // With palettes off, the opaque indexed sprite sorted first is skipped.
+    // The clear sprite in front of the solid one must still be drawn with
+    // the sprite shader, which discards its texels instead of writing depth
+    // that would hide the solid sprite.
+    sprite_batch_set_palette_enabled(false);
+    assert(!sprite_batch_has_palette_shader());
+
+    RenderTexture2D target = LoadRenderTexture(64, 64);
+    BeginTextureMode(target);
+    ClearBackground(BLUE);
+    BeginMode3D(camera);
+
+    sprite_batch_begin(camera);
+    struct sprite indexed = make_sprite(page, 0.0F, WHITE);
+    indexed.palette = palette;
+    indexed.position.x = 1000.0F;
+    assert(sprite_batch_add(&indexed) == 0);
+    struct sprite front = make_sprite(clear, 0.0F, Fade(WHITE, 0.5F));
+    front.position = (Vector3){0.0F, 3.0F, 3.0F};
+    front.size = (Vector2){6.0F, 6.0F};
+    front.origin = (Vector2){3.0F, 3.0F};
+    assert(sprite_batch_add(&front) == 0);
+    sprite_batch_end();
+
+    sprite_batch_begin(camera);
+    struct sprite back = make_sprite(solid, 0.0F, WHITE);
+    back.size = (Vector2){6.0F, 6.0F};
+    back.origin = (Vector2){3.0F, 3.0F};
+    assert(sprite_batch_add(&back) == 0);
+    sprite_batch_end();
+
+    EndMode3D();
+    EndTextureMode();
+    sprite_batch_set_palette_enabled(true);
+
+    Image image = LoadImageFromTexture(target.texture);
+    Color center = GetImageColor(image, 32, 32);
+    assert(center.r == RED.r && center.g == RED.g && center.b == RED.b);
+    UnloadImage(image);
+
+    UnloadRenderTexture(target);
+    UnloadTexture(page);
+    UnloadTexture(palette);
+    UnloadTexture(clear);
+    UnloadTexture(solid);
+}
+
+void test_batch_grows_past_initial_capacity(void) {
+    Texture2D texture = load_texture(RED);
+
+    sprite_batch_begin(camera);
+    for (int i = 0; i < 1000; i++) {
+        struct sprite sprite = make_sprite(texture, (float)(i % 17), WHITE);
+        assert(sprite_batch_add(&sprite) == 0);
+    }
+    sprite_batch_end();
+
+    assert(sprite_batch_get_sprite_count() == 1000);
+    assert(sprite_batch_get_batch_count() == 1);
+
+    UnloadTexture(texture);
+}
+
+void test_sprites_outside_a_batch_are_rejected(void) {
+    Texture2D texture = load_texture(RED);
+    struct sprite sprite = make_sprite(texture, 0.0F, WHITE);
+
+    assert(sprite_batch_add(&sprite) == -ECANCELED);
+
+    sprite_batch_begin(camera);
+    assert(sprite_batch_add(nullptr) == -EINVAL);
+    sprite_batch_end();
+    assert(sprite_batch_get_sprite_count() == 0);
+    assert(sprite_batch_get_batch_count() == 0);
+
+    assert(sprite_batch_add(&sprite) == -ECANCELED);
+
+    UnloadTexture(texture);
+}
+
+int main(void) {
+    InitWindow(100, 100, "Sprite Batch Test");
+    assert(sprite_batch_init() == 0);
+
+    puts("Starting sprite_batch tests.\n");
+
+    RUN_TEST(test_sprites_are_grouped_by_texture);
+    RUN_TEST(test_palettes_split_batches);
+    RUN_TEST(test_palette_survives_batch_flushes);
+    RUN_TEST(test_skipped_first_sprite_keeps_sprite_shader);
+    RUN_TEST(test_batch_grows_past_initial_capacity);
+    RUN_TEST(test_sprites_outside_a_batch_are_rejected);
+
+    puts("\nAll sprite_batch tests passed successfully!");
+
+    sprite_batch_destroy();
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
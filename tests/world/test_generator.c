@@ -5,8 +5,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "game/rng.h"
 #include "game/world/grid.h"
 #include "game/world/room_def.h"
+#include "game/world/world_file.h"
 
 #if defined(_WIN32)
 #include <direct.h>
@@ -111,11 +113,343 @@ void test_generation_is_deterministic(void) {
     assert(strcmp(path_seed42, path_seed_random) != 0);
 }
 
+enum { SNAPSHOT_RADIUS = 8, SNAPSHOT_SIDE = (2 * SNAPSHOT_RADIUS) + 1 };
+
+static const int32_t WALK_PATH[][2] = {
+    {0, -1}, {0, -2}, {0, -3}, {1, -3}, {2, -3}, {2, -2},
+    {-1, -3}, {-2, -3}, {-2, -4}, {0, -4}, {0, -5}, {1, -5},
+};
+
+static void snapshot_layout(char snapshot[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64]) {
+    for (int32_t y = -SNAPSHOT_RADIUS; y <= SNAPSHOT_RADIUS; y++) {
+        for (int32_t x = -SNAPSHOT_RADIUS; x <= SNAPSHOT_RADIUS; x++) {
+            char* slot = snapshot[y + SNAPSHOT_RADIUS][x + SNAPSHOT_RADIUS];
+            struct world_cell* cell = grid_get_cell(x, y);
+            slot[0] = '\0';
+            if (cell) {
+                strncpy(slot, cell->template->model_path, 63);
+                slot[63] = '\0';
+            }
+        }
+    }
+}
+
+void test_worker_matches_synchronous_generation(void) {
+    static char expected[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    static char actual[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    const size_t steps = sizeof(WALK_PATH) / sizeof(WALK_PATH[0]);
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(expected);
+
+    teardown_full_environment();
+    setup_full_environment();
+
+    assert(generator_init(2024) == 0);
+    assert(generator_start_worker() == 0);
+    for (size_t i = 0; i < steps; i++) {
+        assert(generator_request_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    generator_flush();
+    generator_stop_worker();
+    snapshot_layout(actual);
+
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+}
+
+void test_rooms_appear_only_after_commit(void) {
+    assert(generator_init(7) == 0);
+    assert(generator_start_worker() == 0);
+
+    assert(generator_request_chunk(0, -1) == 0);
+    assert(grid_get_cell(0, -2) == nullptr);
+
+    generator_flush();
+    generator_stop_worker();
+    assert(grid_get_cell(0, -2) != nullptr);
+}
+
+void test_coordinate_mode_ignores_global_rng(void) {
+    static char expected[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    static char actual[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    const size_t steps = sizeof(WALK_PATH) / sizeof(WALK_PATH[0]);
+
+    generator_set_rng_mode(GENERATOR_RNG_COORDINATE);
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(expected);
+
+    teardown_full_environment();
+    setup_full_environment();
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < steps; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            (void)rng_next_u64();
+        }
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(actual);
+
+    generator_set_rng_mode(GENERATOR_RNG_SEQUENTIAL);
+
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+}
+
+// Pages out every region, as if the player had gone far away.
+static void evict_everything(void) {
+    assert(grid_page_out(INT32_MAX / 2, INT32_MAX / 2, 0) > 0);
+    assert(generator_page_out(INT32_MAX / 2, INT32_MAX / 2, 0) == 0);
+    assert(grid_get_resident_count() == 0);
+}
+
+void test_eviction_does_not_change_coordinate_generation(void) {
+    static char expected[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    static char actual[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    const size_t steps = sizeof(WALK_PATH) / sizeof(WALK_PATH[0]);
+    const size_t evicted_steps = steps / 2;
+
+    generator_set_rng_mode(GENERATOR_RNG_COORDINATE);
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(expected);
+
+    // Evicted rooms come back from their paged-out records rather than
+    // being generated again, so the rooms generated next to them, and the
+    // evicted rooms themselves, are the same as without the eviction.
+    teardown_full_environment();
+    setup_full_environment();
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < evicted_steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    evict_everything();
+    for (size_t i = evicted_steps; i < steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(actual);
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+
+    // The worker reads evicted rooms from the same records once it has
+    // forgotten its own copies.
+    teardown_full_environment();
+    setup_full_environment();
+
+    assert(generator_init(2024) == 0);
+    assert(generator_start_worker() == 0);
+    for (size_t i = 0; i < evicted_steps; i++) {
+        assert(generator_request_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    generator_flush();
+    evict_everything();
+    for (size_t i = evicted_steps; i < steps; i++) {
+        assert(generator_request_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    generator_flush();
+    generator_stop_worker();
+    snapshot_layout(actual);
+
+    generator_set_rng_mode(GENERATOR_RNG_SEQUENTIAL);
+
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+}
+
+static int save_room(int32_t x,
+                     int32_t y,
+                     const struct room_def* room_template,
+                     void* context) {
+    struct world_file_entry** next = context;
+    **next = (struct world_file_entry){x, y, room_template->id};
+    (*next)++;
+    return 0;
+}
+
+void test_saved_state_continues_generation(void) {
+    static const char* const PATH = "test_generator_save.world";
+    static char expected[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    static char actual[SNAPSHOT_SIDE][SNAPSHOT_SIDE][64];
+    const size_t steps = sizeof(WALK_PATH) / sizeof(WALK_PATH[0]);
+    const size_t saved_steps = steps / 2;
+
+    assert(generator_init(2024) == 0);
+    for (size_t i = 0; i < saved_steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+
+    // Templates keep their ids across both runs, so the names are only
+    // there to satisfy the format.
+    const char* names[8];
+    const struct room_def* templates[8];
+    size_t template_count = 0;
+    while (room_def_get_by_id((uint16_t)template_count)) {
+        templates[template_count] =
+            room_def_get_by_id((uint16_t)template_count);
+        names[template_count] = templates[template_count]->model_path;
+        template_count++;
+    }
+
+    struct world_file_entry rooms[SNAPSHOT_SIDE * SNAPSHOT_SIDE];
+    struct world_file_entry* next = rooms;
+    assert(grid_for_each_room(save_room, &next) == 0);
+
+    struct generator_state state;
+    generator_get_state(&state);
+    struct world_file_info info = {
+        .seed = state.seed,
+        .rng_mode = state.mode,
+        .names = names,
+        .template_count = template_count,
+    };
+    memcpy(info.rng_state, state.rng.s, sizeof(info.rng_state));
+    assert(world_file_write(PATH, &info, rooms, (size_t)(next - rooms)) == 0);
+
+    for (size_t i = saved_steps; i < steps; i++) {
+        assert(generator_create_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    snapshot_layout(expected);
+
+    teardown_full_environment();
+    setup_full_environment();
+
+    for (size_t id = 0; id < template_count; id++) {
+        templates[id] = room_def_get_by_id((uint16_t)id);
+    }
+
+    struct world_file file;
+    assert(world_file_open(&file, PATH) == 0);
+    assert(grid_attach_save(&file, templates) == 0);
+
+    // A different seed shows that everything comes from the save.
+    assert(generator_init(1) == 0);
+    state.seed = file.header->seed;
+    memcpy(state.rng.s, file.header->rng_state, sizeof(state.rng.s));
+    generator_set_state(&state);
+
+    assert(generator_start_worker() == 0);
+    for (size_t i = saved_steps; i < steps; i++) {
+        assert(generator_request_chunk(WALK_PATH[i][0], WALK_PATH[i][1]) == 0);
+    }
+    generator_flush();
+    generator_stop_worker();
+    snapshot_layout(actual);
+
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+
+    grid_destroy();
+    world_file_close(&file);
+    assert(remove(PATH) == 0);
+}
+
+enum { LONG_WALK_STEPS = 300, LONG_WALK_DISTANCE = 8 };
+
+static const struct {
+    uint8_t door;
+    int32_t dx;
+    int32_t dy;
+} WALK_DOORS[] = {
+    {DOOR_NORTH, 0, 1},
+    {DOOR_SOUTH, 0, -1},
+    {DOOR_EAST, 1, 0},
+    {DOOR_WEST, -1, 0},
+};
+
+static int32_t walk_span(int32_t x, int32_t y) {
+    return abs(x) + abs(y);
+}
+
+// Steps through the door that leads furthest from the origin. Every test
+// template keeps a way onwards, so the walk never turns back.
+static void take_step(int32_t* x, int32_t* y) {
+    const struct room_def* room_template = grid_get_saved_template(*x, *y);
+    assert(room_template != nullptr);
+
+    int32_t best_x = *x;
+    int32_t best_y = *y;
+    for (size_t i = 0; i < sizeof(WALK_DOORS) / sizeof(WALK_DOORS[0]); i++) {
+        int32_t next_x = *x + WALK_DOORS[i].dx;
+        int32_t next_y = *y + WALK_DOORS[i].dy;
+        if ((room_template->door_mask & WALK_DOORS[i].door) &&
+            walk_span(next_x, next_y) > walk_span(best_x, best_y)) {
+            best_x = next_x;
+            best_y = next_y;
+        }
+    }
+
+    assert(walk_span(best_x, best_y) > walk_span(*x, *y));
+    assert(grid_get_saved_template(best_x, best_y) != nullptr);
+    *x = best_x;
+    *y = best_y;
+}
+
+void test_shadow_stays_bounded_after_long_walk(void) {
+    static int32_t path[LONG_WALK_STEPS][2];
+    const size_t bound = (size_t)((2 * (LONG_WALK_DISTANCE + 2)) + 1) *
+                         (size_t)((2 * (LONG_WALK_DISTANCE + 2)) + 1);
+
+    assert(generator_init(99) == 0);
+    assert(generator_start_worker() == 0);
+
+    int32_t x = 0;
+    int32_t y = 0;
+    for (size_t i = 0; i < LONG_WALK_STEPS; i++) {
+        take_step(&x, &y);
+        path[i][0] = x;
+        path[i][1] = y;
+
+        assert(generator_request_chunk(x, y) == 0);
+        generator_flush();
+        assert(grid_page_out(x, y, LONG_WALK_DISTANCE) >= 0);
+        assert(generator_page_out(x, y, LONG_WALK_DISTANCE) == 0);
+        generator_flush();
+        assert(generator_get_shadow_count() <= bound);
+    }
+
+    assert(grid_get_paged_count() > 0);
+    assert(grid_get_resident_count() + grid_get_paged_count() > bound);
+    generator_stop_worker();
+
+    // Rooms the worker forgot were read back from the paged-out records, so
+    // the layout matches a synchronous run along the same path.
+    static uint16_t expected[LONG_WALK_STEPS];
+    for (size_t i = 0; i < LONG_WALK_STEPS; i++) {
+        expected[i] = grid_get_saved_template(path[i][0], path[i][1])->id;
+    }
+
+    teardown_full_environment();
+    setup_full_environment();
+
+    assert(generator_init(99) == 0);
+    for (size_t i = 0; i < LONG_WALK_STEPS; i++) {
+        assert(generator_create_chunk(path[i][0], path[i][1]) == 0);
+    }
+    for (size_t i = 0; i < LONG_WALK_STEPS; i++) {
+        struct world_cell* cell = grid_get_cell(path[i][0], path[i][1]);
+        assert(cell != nullptr);
+        assert(cell->template->id == expected[i]);
+    }
+}
+
 int main(void) {
     puts("Starting generator tests.\n");
 
     RUN_TEST(test_init_places_start_room_and_chunk);
     RUN_TEST(test_generation_is_deterministic);
+    RUN_TEST(test_worker_matches_synchronous_generation);
+    RUN_TEST(test_rooms_appear_only_after_commit);
+    RUN_TEST(test_coordinate_mode_ignores_global_rng);
+    RUN_TEST(test_eviction_does_not_change_coordinate_generation);
+    RUN_TEST(test_saved_state_continues_generation);
+    RUN_TEST(test_shadow_stays_bounded_after_long_walk);
 
     puts("\nAll generator tests passed successfully!");
 
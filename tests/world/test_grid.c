@@ -2,8 +2,13 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "game/world/model_cache.h"
+#include "game/world/world_file.h"
 
 #define RUN_TEST(test)                          \
     do {                                        \
@@ -73,6 +78,47 @@ void test_model_loading_and_unloading(void) {
     grid_destroy();
 }
 
+void test_cells_share_template_model(void) {
+    grid_init();
+    grid_place_room(0, 0, &mock_template_1);
+    grid_place_room(0, 1, &mock_template_1);
+    struct world_cell* first = grid_get_cell(0, 0);
+    struct world_cell* second = grid_get_cell(0, 1);
+
+    grid_load_model(first);
+    grid_load_model(second);
+    assert(first->model.meshes == second->model.meshes);
+
+    grid_unload_model(first);
+    assert(second->is_model_loaded == true);
+    assert(second->model.meshCount > 0);
+
+    grid_destroy();
+}
+
+void test_request_model_streams_in(void) {
+    grid_init();
+    grid_place_room(3, 3, &mock_template_1);
+    struct world_cell* cell = grid_get_cell(3, 3);
+
+    assert(grid_request_model(cell) == 0);
+    assert(cell->is_model_requested == true);
+
+    for (int i = 0; i < 1000 && !cell->is_model_loaded; i++) {
+        model_cache_update(1.0);
+        assert(grid_request_model(cell) == 0);
+        WaitTime(0.001);
+    }
+    assert(cell->is_model_loaded == true);
+    assert(cell->model.meshCount > 0);
+
+    grid_unload_model(cell);
+    assert(cell->is_model_requested == false);
+    assert(cell->is_model_loaded == false);
+
+    grid_destroy();
+}
+
 void test_destroy_unloads_models(void) {
     grid_init();
     grid_place_room(-2, -2, &mock_template_1);
@@ -84,12 +130,159 @@ void test_destroy_unloads_models(void) {
     grid_destroy();
 }
 
+void test_far_idle_model_is_evicted_first(void) {
+    assert(grid_init() == 0);
+    model_cache_set_budget(SIZE_MAX);
+
+    assert(grid_place_room(-3, 0, &mock_template_1) == 0);
+    assert(grid_place_room(3, 0, &mock_template_2) == 0);
+    struct world_cell* west = grid_get_cell(-3, 0);
+    struct world_cell* east = grid_get_cell(3, 0);
+    assert(grid_load_model(west) == 0);
+    assert(grid_load_model(east) == 0);
+
+    // Both are released equally far from the viewer, the west one first.
+    grid_update_model_distances(0, 0);
+    assert(grid_unload_model(west) == 0);
+    assert(grid_unload_model(east) == 0);
+
+    // Walking west brings the older model nearer, which outweighs recency.
+    grid_update_model_distances(-2, 0);
+    model_cache_set_budget(model_cache_get_resident_bytes() - 1);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_bounds(&mock_template_1, &(BoundingBox){0}));
+
+    model_cache_set_budget(0);
+    grid_destroy();
+}
+
+void test_far_regions_are_paged_out_and_restored(void) {
+    assert(grid_init() == 0);
+    assert(room_def_load_all("assets/models/rooms") > 1);
+    const struct room_def* near_template = room_def_get_by_id(0);
+    const struct room_def* far_template = room_def_get_by_id(1);
+    const int32_t far_x = 3 * GRID_REGION_SIZE;
+
+    // Region (-1, 0) holds the first two rooms, region (3, -1) the rest.
+    assert(grid_place_room(-1, 0, near_template) == 0);
+    assert(grid_place_room(-GRID_REGION_SIZE, 0, near_template) == 0);
+    for (int32_t x = far_x; x < far_x + 4; x++) {
+        assert(grid_place_room(x, -1, far_template) == 0);
+    }
+    // A template the catalog does not know cannot be paged out.
+    assert(grid_place_room(far_x, -2, &mock_template_1) == 0);
+
+    assert(grid_page_out(0, 0, GRID_REGION_SIZE) == 4);
+    assert(grid_get_resident_count() == 3);
+    assert(grid_get_paged_count() == 4);
+
+    // Touching one coordinate of the region brings all of its rooms back.
+    struct world_cell* cell = grid_get_cell(far_x + 2, -1);
+    assert(cell != nullptr);
+    assert(cell->template == far_template);
+    assert(cell->grid_x == far_x + 2 && cell->grid_y == -1);
+    assert(grid_get_resident_count() == 7);
+    assert(grid_get_paged_count() == 0);
+
+    // Paging out releases models, and a paged-out room is not overwritten.
+    assert(grid_load_model(cell) == 0);
+    assert(grid_page_out(0, 0, GRID_REGION_SIZE) == 4);
+    assert(grid_place_room(far_x + 2, -1, near_template) == 0);
+    cell = grid_get_cell(far_x + 2, -1);
+    assert(cell->template == far_template);
+    assert(cell->is_model_loaded == false);
+
+    // Regions are rounded toward negative infinity, so both rooms west of
+    // the origin share one and are paged out together.
+    assert(grid_page_out(2 * GRID_REGION_SIZE, 0, GRID_REGION_SIZE) == 2);
+    assert(grid_get_cell(-1, 0) != nullptr);
+    assert(grid_get_paged_count() == 0);
+
+    assert(grid_page_out(0, 0, -1) == -EINVAL);
+
+    grid_destroy();
+    room_def_unload_all();
+}
+
+static int count_room(int32_t x,
+                      int32_t y,
+                      const struct room_def* room_template,
+                      void* context) {
+    (void)x;
+    (void)y;
+    (void)room_template;
+    (*(size_t*)context)++;
+    return 0;
+}
+
+void test_saved_regions_fault_in_on_demand(void) {
+    static const char* const PATH = "test_grid_save.world";
+    static const char* const NAMES[] = {"hallway_0.glb", "missing.glb"};
+    struct world_file_entry rooms[] = {
+        {.x = 0, .y = 0, .template_index = 0},
+        {.x = 1, .y = 0, .template_index = 0},
+        {.x = 2, .y = 0, .template_index = 1},
+        {.x = -5, .y = 40, .template_index = 0},
+    };
+    struct world_file_info info = {.names = NAMES, .template_count = 2};
+    assert(world_file_write(PATH, &info, rooms, 4) == 0);
+
+    assert(grid_init() == 0);
+    assert(room_def_load_all("assets/models/rooms") > 0);
+    struct world_file file;
+    assert(world_file_open(&file, PATH) == 0);
+
+    const struct room_def* hallway = nullptr;
+    for (uint16_t id = 0; room_def_get_by_id(id); id++) {
+        if (strstr(room_def_get_by_id(id)->model_path, "hallway_0.glb")) {
+            hallway = room_def_get_by_id(id);
+        }
+    }
+    assert(hallway != nullptr);
+    const struct room_def* templates[] = {hallway, nullptr};
+    assert(grid_attach_save(&file, templates) == 0);
+    assert(grid_attach_save(&file, templates) == -EBUSY);
+
+    // Nothing is read until a region is touched.
+    assert(grid_get_resident_count() == 0);
+    assert(grid_get_saved_template(-5, 40) == hallway);
+    assert(grid_get_saved_template(2, 0) == nullptr);
+    assert(grid_get_resident_count() == 0);
+
+    size_t visited = 0;
+    assert(grid_for_each_room(count_room, &visited) == 0);
+    assert(visited == 3);
+
+    // A room with an unknown template is dropped, and a placed room does not
+    // replace a saved one.
+    assert(grid_place_room(1, 0, &mock_template_1) == 0);
+    assert(grid_get_resident_count() == 2);
+    assert(grid_get_cell(1, 0)->template == hallway);
+    assert(grid_get_cell(2, 0) == nullptr);
+
+    // A faulted-in region is paged out and restored from memory from then
+    // on.
+    assert(grid_page_out(0, 1000, 0) == 2);
+    visited = 0;
+    assert(grid_for_each_room(count_room, &visited) == 0);
+    assert(visited == 3);
+    assert(grid_get_cell(0, 0)->template == hallway);
+    assert(grid_get_cell(-5, 40)->template == hallway);
+    assert(grid_get_resident_count() == 3);
+
+    grid_destroy();
+    room_def_unload_all();
+    world_file_close(&file);
+    assert(remove(PATH) == 0);
+}
+
 void test_invalid_arguments(void) {
     assert(grid_init() == 0);
 
     assert(grid_place_room(1, 1, nullptr) == -EINVAL);
 
     assert(grid_load_model(nullptr) == -EINVAL);
+    assert(grid_request_model(nullptr) == -EINVAL);
     assert(grid_unload_model(nullptr) == -EINVAL);
 
     grid_destroy();
@@ -105,7 +298,12 @@ int main(void) {
     RUN_TEST(test_get_non_existent_cell);
     RUN_TEST(test_place_on_existing_cell_is_ignored);
     RUN_TEST(test_model_loading_and_unloading);
+    RUN_TEST(test_cells_share_template_model);
+    RUN_TEST(test_request_model_streams_in);
     RUN_TEST(test_destroy_unloads_models);
+    RUN_TEST(test_far_idle_model_is_evicted_first);
+    RUN_TEST(test_far_regions_are_paged_out_and_restored);
+    RUN_TEST(test_saved_regions_fault_in_on_demand);
     RUN_TEST(test_invalid_arguments);
 
     puts("\nAll grid tests passed successfully!");
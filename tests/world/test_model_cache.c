@@ -0,0 +1,327 @@
+#include "game/world/model_cache.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static struct room_def mock_template_1 = {
+    .model_path = "assets/models/rooms/hallway_0.glb",
+    .door_mask = 0};
+static struct room_def mock_template_2 = {
+    .model_path = "assets/models/rooms/cube_room_0.glb",
+    .door_mask = 0};
+
+#define MULTI_MESH_PATH "test_model_cache_multi_mesh.glb"
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+/** Writes a .glb file with three nodes that each get their own mesh. */
+static void write_multi_mesh_model(void) {
+    static const char json[] =
+        "{\"nodes\":[{\"mesh\":0},{\"mesh\":0},{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0}}]}],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,"
+        "\"count\":3,\"type\":\"VEC3\"}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteLength\":36}],"
+        "\"buffers\":[{\"byteLength\":36}]}";
+    const float triangle[9] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    size_t json_size = (sizeof(json) - 1 + 3) & ~(size_t)3;
+    size_t size = 12 + 8 + json_size + 8 + sizeof(triangle);
+
+    unsigned char* data = calloc(1, size);
+    assert(data);
+    put_u32(data, 0x46546C67);
+    put_u32(data + 4, 2);
+    put_u32(data + 8, (uint32_t)size);
+    put_u32(data + 12, (uint32_t)json_size);
+    put_u32(data + 16, 0x4E4F534A);
+    memset(data + 20, ' ', json_size);
+    memcpy(data + 20, json, sizeof(json) - 1);
+    put_u32(data + 20 + json_size, sizeof(triangle));
+    put_u32(data + 24 + json_size, 0x004E4942);
+    memcpy(data + 28 + json_size, triangle, sizeof(triangle));
+
+    FILE* file = fopen(MULTI_MESH_PATH, "wb");
+    assert(file);
+    assert(fwrite(data, 1, size, file) == size);
+    assert(fclose(file) == 0);
+    free(data);
+}
+
+void test_init_and_destroy(void) {
+    assert(model_cache_init() == 0);
+    assert(model_cache_init() == 0);
+    assert(model_cache_get_count() == 0);
+    model_cache_destroy();
+    assert(model_cache_get_count() == 0);
+}
+
+void test_acquire_shares_model(void) {
+    assert(model_cache_init() == 0);
+
+    Model first = {0};
+    Model second = {0};
+    assert(model_cache_acquire(&mock_template_1, &first) == 0);
+    assert(model_cache_acquire(&mock_template_1, &second) == 0);
+
+    assert(first.meshCount > 0);
+    assert(first.meshes == second.meshes);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_refcount(&mock_template_1) == 2);
+
+    model_cache_destroy();
+}
+
+void test_distinct_templates_get_distinct_models(void) {
+    assert(model_cache_init() == 0);
+
+    Model first = {0};
+    Model second = {0};
+    assert(model_cache_acquire(&mock_template_1, &first) == 0);
+    assert(model_cache_acquire(&mock_template_2, &second) == 0);
+
+    assert(first.meshes != second.meshes);
+    assert(model_cache_get_count() == 2);
+
+    model_cache_destroy();
+}
+
+void test_release_unloads_after_last_reference(void) {
+    assert(model_cache_init() == 0);
+
+    Model model = {0};
+    assert(model_cache_acquire(&mock_template_1, &model) == 0);
+    assert(model_cache_acquire(&mock_template_1, &model) == 0);
+
+    assert(model_cache_release(&mock_template_1) == 0);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_refcount(&mock_template_1) == 1);
+
+    assert(model_cache_release(&mock_template_1) == 0);
+    assert(model_cache_get_count() == 0);
+    assert(model_cache_get_refcount(&mock_template_1) == 0);
+
+    assert(model_cache_release(&mock_template_1) == -ENOENT);
+
+    model_cache_destroy();
+}
+
+static bool wait_until_ready(const struct room_def* def, Model* out_model) {
+    for (int i = 0; i < 1000; i++) {
+        model_cache_update(1.0);
+        if (model_cache_get(def, out_model)) {
+            return true;
+        }
+        WaitTime(0.001);
+    }
+    return false;
+}
+
+void test_request_streams_model(void) {
+    assert(model_cache_init() == 0);
+
+    Model model = {0};
+    assert(model_cache_request(&mock_template_1) == 0);
+    assert(model_cache_get_refcount(&mock_template_1) == 1);
+
+    assert(wait_until_ready(&mock_template_1, &model));
+    assert(model.meshCount > 0);
+
+    Model acquired = {0};
+    assert(model_cache_acquire(&mock_template_1, &acquired) == 0);
+    assert(acquired.meshes == model.meshes);
+    assert(model_cache_get_refcount(&mock_template_1) == 2);
+
+    model_cache_destroy();
+}
+
+void test_wait_finishes_pending_request(void) {
+    assert(model_cache_init() == 0);
+
+    Model model = {0};
+    assert(model_cache_request(&mock_template_2) == 0);
+    assert(model_cache_wait(&mock_template_2, &model) == 0);
+    assert(model.meshCount > 0);
+    assert(model_cache_get(&mock_template_2, &model));
+
+    assert(model_cache_wait(&mock_template_1, &model) == -ENOENT);
+
+    model_cache_destroy();
+}
+
+void test_update_uploads_one_mesh_at_a_time(void) {
+    write_multi_mesh_model();
+    struct room_def def = {.model_path = MULTI_MESH_PATH};
+    assert(model_cache_init() == 0);
+
+    // Give the worker time to parse the file, so the first update already
+    // has meshes to upload.
+    assert(model_cache_request(&def) == 0);
+    WaitTime(0.1);
+
+    // Without any time budget, every update uploads a single mesh.
+    Model model = {0};
+    int updates = 0;
+    while (!model_cache_get(&def, &model)) {
+        assert(updates < 1000);
+        model_cache_update(0.0);
+        updates++;
+        WaitTime(0.001);
+    }
+    assert(updates >= 3);
+    assert(model.meshCount == 3);
+
+    model_cache_destroy();
+    assert(remove(MULTI_MESH_PATH) == 0);
+}
+
+void test_release_cancels_pending_request(void) {
+    assert(model_cache_init() == 0);
+
+    Model model = {0};
+    assert(model_cache_request(&mock_template_1) == 0);
+    assert(model_cache_release(&mock_template_1) == 0);
+    assert(model_cache_get_count() == 0);
+
+    for (int i = 0; i < 10; i++) {
+        model_cache_update(1.0);
+        WaitTime(0.001);
+    }
+    assert(!model_cache_get(&mock_template_1, &model));
+    assert(model_cache_get_count() == 0);
+
+    model_cache_destroy();
+}
+
+void test_idle_models_stay_within_budget(void) {
+    assert(model_cache_init() == 0);
+    model_cache_set_budget(SIZE_MAX);
+
+    Model first = {0};
+    assert(model_cache_acquire(&mock_template_1, &first) == 0);
+    size_t bytes = model_cache_get_resident_bytes();
+    assert(bytes > 0);
+
+    // Releasing the last reference keeps the model for the next user.
+    assert(model_cache_release(&mock_template_1) == 0);
+    assert(model_cache_release(&mock_template_1) == -ENOENT);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_refcount(&mock_template_1) == 0);
+    assert(model_cache_get_resident_bytes() == bytes);
+
+    Model second = {0};
+    assert(model_cache_acquire(&mock_template_1, &second) == 0);
+    assert(second.meshes == first.meshes);
+    assert(model_cache_release(&mock_template_1) == 0);
+
+    model_cache_set_budget(0);
+    assert(model_cache_get_count() == 0);
+    assert(model_cache_get_resident_bytes() == 0);
+
+    model_cache_destroy();
+}
+
+void test_furthest_idle_model_is_evicted_first(void) {
+    assert(model_cache_init() == 0);
+    model_cache_set_budget(SIZE_MAX);
+
+    Model model = {0};
+    assert(model_cache_acquire(&mock_template_1, &model) == 0);
+    assert(model_cache_acquire(&mock_template_2, &model) == 0);
+    model_cache_set_distance(&mock_template_1, 1.0F);
+    model_cache_set_distance(&mock_template_2, 3.0F);
+
+    // The nearer model was released last, but distance decides first.
+    assert(model_cache_release(&mock_template_2) == 0);
+    assert(model_cache_release(&mock_template_1) == 0);
+
+    model_cache_set_budget(model_cache_get_resident_bytes() - 1);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_bounds(&mock_template_1, &(BoundingBox){0}));
+
+    // At equal distances, the least recently used model goes first.
+    assert(model_cache_acquire(&mock_template_2, &model) == 0);
+    model_cache_set_budget(SIZE_MAX);
+    model_cache_set_distance(&mock_template_2, 1.0F);
+    assert(model_cache_release(&mock_template_2) == 0);
+
+    model_cache_set_budget(model_cache_get_resident_bytes() - 1);
+    assert(model_cache_get_count() == 1);
+    assert(model_cache_get_bounds(&mock_template_2, &(BoundingBox){0}));
+
+    model_cache_set_budget(0);
+    model_cache_destroy();
+}
+
+void test_bounds_are_cached_with_model(void) {
+    assert(model_cache_init() == 0);
+
+    BoundingBox bounds = {0};
+    assert(!model_cache_get_bounds(&mock_template_1, &bounds));
+
+    Model model = {0};
+    assert(model_cache_acquire(&mock_template_1, &model) == 0);
+    assert(model_cache_get_bounds(&mock_template_1, &bounds));
+    assert(bounds.min.x < bounds.max.x);
+    assert(bounds.min.z < bounds.max.z);
+
+    assert(model_cache_release(&mock_template_1) == 0);
+    assert(!model_cache_get_bounds(&mock_template_1, &bounds));
+
+    model_cache_destroy();
+}
+
+void test_invalid_arguments(void) {
+    Model model = {0};
+
+    assert(model_cache_acquire(&mock_template_1, &model) == -ECANCELED);
+    assert(model_cache_request(&mock_template_1) == -ECANCELED);
+
+    assert(model_cache_init() == 0);
+
+    assert(model_cache_acquire(nullptr, &model) == -EINVAL);
+    assert(model_cache_acquire(&mock_template_1, nullptr) == -EINVAL);
+    assert(model_cache_request(nullptr) == -EINVAL);
+    assert(model_cache_wait(nullptr, &model) == -EINVAL);
+    assert(model_cache_release(nullptr) == -EINVAL);
+
+    model_cache_destroy();
+}
+
+int main(void) {
+    InitWindow(100, 100, "Model Cache Test");
+
+    puts("Starting model cache tests.\n");
+
+    RUN_TEST(test_init_and_destroy);
+    RUN_TEST(test_acquire_shares_model);
+    RUN_TEST(test_distinct_templates_get_distinct_models);
+    RUN_TEST(test_release_unloads_after_last_reference);
+    RUN_TEST(test_request_streams_model);
+    RUN_TEST(test_wait_finishes_pending_request);
+    RUN_TEST(test_update_uploads_one_mesh_at_a_time);
+    RUN_TEST(test_release_cancels_pending_request);
+    RUN_TEST(test_idle_models_stay_within_budget);
+    RUN_TEST(test_furthest_idle_model_is_evicted_first);
+    RUN_TEST(test_bounds_are_cached_with_model);
+    RUN_TEST(test_invalid_arguments);
+
+    puts("\nAll model cache tests passed successfully!");
+
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
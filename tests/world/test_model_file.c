@@ -0,0 +1,231 @@
+#include "game/world/model_file.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static const char* ROOM_PATH = "assets/models/rooms/L_room_0.glb";
+
+// One triangle with a normal per vertex, positions first.
+static const float TRIANGLE[] = {
+    0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
+};
+
+static unsigned char* read_bytes(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    assert(file);
+    assert(fseek(file, 0, SEEK_END) == 0);
+    long length = ftell(file);
+    assert(length > 0);
+    rewind(file);
+
+    unsigned char* data = malloc((size_t)length);
+    assert(data);
+    assert(fread(data, 1, (size_t)length, file) == (size_t)length);
+    (void)fclose(file);
+
+    *size = (size_t)length;
+    return data;
+}
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+/** Packs a JSON document and a binary chunk into a .glb file. */
+static unsigned char* make_glb(const char* json,
+                               const void* bin,
+                               size_t bin_size,
+                               size_t* size) {
+    size_t json_size = (strlen(json) + 3) & ~(size_t)3;
+    size_t padded_bin_size = (bin_size + 3) & ~(size_t)3;
+    *size = 12 + 8 + json_size + 8 + padded_bin_size;
+
+    unsigned char* data = calloc(1, *size);
+    assert(data);
+    put_u32(data, 0x46546C67);
+    put_u32(data + 4, 2);
+    put_u32(data + 8, (uint32_t)*size);
+
+    unsigned char* chunk = data + 12;
+    put_u32(chunk, (uint32_t)json_size);
+    put_u32(chunk + 4, 0x4E4F534A);
+    memset(chunk + 8, ' ', json_size);
+    memcpy(chunk + 8, json, strlen(json));
+
+    chunk += 8 + json_size;
+    put_u32(chunk, (uint32_t)padded_bin_size);
+    put_u32(chunk + 4, 0x004E4942);
+    memcpy(chunk + 8, bin, bin_size);
+
+    return data;
+}
+
+static bool is_near(float a, float b) {
+    return fabsf(a - b) < 1e-4F;
+}
+
+void test_parses_room_model(void) {
+    size_t size = 0;
+    unsigned char* data = read_bytes(ROOM_PATH, &size);
+
+    Model model = {0};
+    assert(model_file_parse(data, size, &model) == 0);
+    free(data);
+
+    // One primitive with 161 vertices and 504 indices, see the file.
+    assert(model.meshCount == 1);
+    const Mesh* mesh = &model.meshes[0];
+    assert(mesh->vertexCount == 161);
+    assert(mesh->triangleCount == 168);
+    assert(mesh->normals && mesh->texcoords && mesh->indices);
+    assert(mesh->vaoId == 0);
+    for (int i = 0; i < mesh->triangleCount * 3; i++) {
+        assert(mesh->indices[i] < mesh->vertexCount);
+    }
+
+    Vector3 min = {INFINITY, INFINITY, INFINITY};
+    Vector3 max = {-INFINITY, -INFINITY, -INFINITY};
+    for (int i = 0; i < mesh->vertexCount; i++) {
+        const float* vertex = &mesh->vertices[i * 3];
+        min = (Vector3){fminf(min.x, vertex[0]), fminf(min.y, vertex[1]),
+                        fminf(min.z, vertex[2])};
+        max = (Vector3){fmaxf(max.x, vertex[0]), fmaxf(max.y, vertex[1]),
+                        fmaxf(max.z, vertex[2])};
+    }
+    assert(is_near(min.x, -1) && is_near(min.y, -0.5F) && is_near(min.z, -2));
+    assert(is_near(max.x, 2) && is_near(max.y, 0.5F) && is_near(max.z, 1));
+
+    // The default material comes first, then the file's green one.
+    assert(model.materialCount == 2);
+    assert(model.meshMaterial[0] == 1);
+    Color color = model.materials[1].maps[MATERIAL_MAP_ALBEDO].color;
+    assert(color.r == 0 && color.g == 204 && color.b == 0 && color.a == 255);
+
+    UnloadModel(model);
+}
+
+void test_applies_node_transforms(void) {
+    // The mesh node is scaled by 2 and turned 90 degrees about Z, inside a
+    // parent moved 10 along X.
+    const char* json =
+        "{\"asset\":{\"version\":\"2.0\"},"
+        "\"nodes\":[{\"children\":[1],\"translation\":[10,0,0]},"
+        "{\"mesh\":0,\"scale\":[2,2,2],"
+        "\"rotation\":[0,0,0.70710678,0.70710678]}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":"
+        "{\"POSITION\":0,\"NORMAL\":1}}]}],"
+        "\"accessors\":["
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":3,"
+        "\"type\":\"VEC3\"},"
+        "{\"bufferView\":0,\"byteOffset\":36,\"componentType\":5126,"
+        "\"count\":3,\"type\":\"VEC3\"}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteLength\":72}],"
+        "\"buffers\":[{\"byteLength\":72}]}";
+
+    size_t size = 0;
+    unsigned char* data = make_glb(json, TRIANGLE, sizeof(TRIANGLE), &size);
+
+    Model model = {0};
+    assert(model_file_parse(data, size, &model) == 0);
+    free(data);
+
+    assert(model.meshCount == 1);
+    const Mesh* mesh = &model.meshes[0];
+    assert(mesh->vertexCount == 3);
+    assert(mesh->triangleCount == 1);
+    assert(!mesh->indices && !mesh->texcoords);
+
+    // (1, 0, 0) becomes (2, 0, 0), then (0, 2, 0), then (10, 2, 0).
+    const float* vertex = &mesh->vertices[3];
+    assert(is_near(vertex[0], 10) && is_near(vertex[1], 2) &&
+           is_near(vertex[2], 0));
+
+    // Normals turn with the node but keep unit length.
+    const float* normal = &mesh->normals[0];
+    assert(is_near(normal[0], 0) && is_near(normal[1], 1) &&
+           is_near(normal[2], 0));
+
+    // Without materials in the file, only the default one exists.
+    assert(model.materialCount == 1);
+    assert(model.meshMaterial[0] == 0);
+
+    UnloadModel(model);
+}
+
+void test_rejects_invalid_files(void) {
+    Model model = {0};
+    const unsigned char garbage[32] = "not a glb file at all";
+    assert(model_file_parse(garbage, sizeof(garbage), &model) == -EINVAL);
+    assert(model_file_parse(nullptr, 0, &model) == -EINVAL);
+
+    size_t size = 0;
+    unsigned char* data = read_bytes(ROOM_PATH, &size);
+    assert(model_file_parse(data, size / 2, &model) == -EINVAL);
+    assert(model.meshCount == 0 && !model.meshes && !model.materials);
+    free(data);
+
+    // An index past the last vertex.
+    const char* json =
+        "{\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},"
+        "\"indices\":1}]}],"
+        "\"accessors\":["
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":3,"
+        "\"type\":\"VEC3\"},"
+        "{\"bufferView\":0,\"byteOffset\":36,\"componentType\":5121,"
+        "\"count\":3,\"type\":\"SCALAR\"}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteLength\":72}],"
+        "\"buffers\":[{\"byteLength\":72}]}";
+    float bin[18];
+    memcpy(bin, TRIANGLE, sizeof(bin));
+    const unsigned char indices[] = {0, 1, 3};
+    memcpy(&bin[9], indices, sizeof(indices));
+
+    data = make_glb(json, bin, sizeof(bin), &size);
+    assert(model_file_parse(data, size, &model) == -EINVAL);
+    assert(!model.meshes && !model.materials);
+    free(data);
+
+    // An accessor reaching past the end of its buffer view.
+    const char* out_of_view =
+        "{\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0}}]}],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,"
+        "\"count\":7,\"type\":\"VEC3\"}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteLength\":72}],"
+        "\"buffers\":[{\"byteLength\":72}]}";
+    data = make_glb(out_of_view, TRIANGLE, sizeof(TRIANGLE), &size);
+    assert(model_file_parse(data, size, &model) == -EINVAL);
+    free(data);
+}
+
+int main(void) {
+    InitWindow(100, 100, "Model File Test");
+
+    puts("Starting model file tests.\n");
+
+    RUN_TEST(test_parses_room_model);
+    RUN_TEST(test_applies_node_transforms);
+    RUN_TEST(test_rejects_invalid_files);
+
+    puts("\nAll model file tests passed successfully!");
+
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+#include "game/world/portal.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+enum { MAX_VISIBLE = 25 };
+
+static const float CELL_SIZE = 20.0F;
+
+static struct room_def north_south_room = {
+    .model_path = "assets/models/rooms/hallway_0.glb",
+    .door_mask = DOOR_NORTH | DOOR_SOUTH};
+static struct room_def north_east_room = {
+    .model_path = "assets/models/rooms/L_room_0.glb",
+    .door_mask = DOOR_NORTH | DOOR_EAST};
+static struct room_def closed_room = {
+    .model_path = "assets/models/rooms/cube_room_0.glb",
+    .door_mask = 0};
+static struct room_def open_closed_room = {
+    .model_path = "assets/models/rooms/cube_room_0.glb",
+    .door_mask = 0,
+    .is_open_topped = true};
+
+static bool contains(struct world_cell* const* cells,
+                     size_t count,
+                     int32_t x,
+                     int32_t y) {
+    for (size_t i = 0; i < count; i++) {
+        if (cells[i]->grid_x == x && cells[i]->grid_y == y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_walls_block_visibility(void) {
+    assert(grid_init() == 0);
+
+    // The east neighbor has no door back, and the south neighbor faces a
+    // wall of the origin.
+    assert(grid_place_room(0, 0, &north_east_room) == 0);
+    assert(grid_place_room(0, 1, &north_south_room) == 0);
+    assert(grid_place_room(1, 0, &closed_room) == 0);
+    assert(grid_place_room(0, -1, &north_south_room) == 0);
+
+    struct portal_view view = {
+        .origin_x = 0,
+        .origin_y = 0,
+        .radius = 2,
+        .cell_size = CELL_SIZE,
+        .cell_height = CELL_SIZE,
+        .walls_occlude = true,
+    };
+    struct world_cell* cells[MAX_VISIBLE];
+    size_t count = portal_find_visible(&view, cells, MAX_VISIBLE);
+
+    assert(count == 2);
+    assert(cells[0] == grid_get_cell(0, 0));
+    assert(contains(cells, count, 0, 1));
+
+    grid_destroy();
+}
+
+void test_flood_fill_stops_at_radius(void) {
+    assert(grid_init() == 0);
+
+    for (int32_t y = -5; y <= 5; y++) {
+        assert(grid_place_room(0, y, &north_south_room) == 0);
+    }
+
+    struct portal_view view = {
+        .origin_x = 0,
+        .origin_y = 0,
+        .radius = 2,
+        .cell_size = CELL_SIZE,
+        .cell_height = CELL_SIZE,
+        .walls_occlude = true,
+    };
+    struct world_cell* cells[MAX_VISIBLE];
+    size_t count = portal_find_visible(&view, cells, MAX_VISIBLE);
+
+    assert(count == 5);
+    for (int32_t y = -2; y <= 2; y++) {
+        assert(contains(cells, count, 0, y));
+    }
+
+    // A full buffer ends the pass early, and a second pass starts afresh.
+    assert(portal_find_visible(&view, cells, 3) == 3);
+    assert(portal_find_visible(&view, cells, MAX_VISIBLE) == 5);
+
+    view.origin_y = 10;
+    assert(portal_find_visible(&view, cells, MAX_VISIBLE) == 0);
+
+    grid_destroy();
+}
+
+void test_doorways_out_of_view_are_skipped(void) {
+    assert(grid_init() == 0);
+
+    for (int32_t y = -2; y <= 2; y++) {
+        assert(grid_place_room(0, y, &north_south_room) == 0);
+    }
+
+    // Standing in the origin room and looking south, the north doorway is
+    // behind the camera.
+    Matrix camera_view = MatrixLookAt((Vector3){0.0F, 0.0F, 5.0F},
+                                      (Vector3){0.0F, 0.0F, -20.0F},
+                                      (Vector3){0.0F, 1.0F, 0.0F});
+    Matrix projection = MatrixPerspective(60.0 * DEG2RAD, 1.0, 0.1, 1000.0);
+    struct frustum frustum =
+        frustum_from_matrix(MatrixMultiply(camera_view, projection));
+
+    struct portal_view view = {
+        .origin_x = 0,
+        .origin_y = 0,
+        .radius = 2,
+        .cell_size = CELL_SIZE,
+        .cell_height = CELL_SIZE,
+        .frustum = &frustum,
+        .walls_occlude = true,
+    };
+    struct world_cell* cells[MAX_VISIBLE];
+    size_t count = portal_find_visible(&view, cells, MAX_VISIBLE);
+
+    assert(count == 3);
+    assert(contains(cells, count, 0, 0));
+    assert(contains(cells, count, 0, -1));
+    assert(contains(cells, count, 0, -2));
+
+    grid_destroy();
+}
+
+void test_open_topped_rooms_are_seen_over_walls(void) {
+    assert(grid_init() == 0);
+
+    // No room has a door towards the origin. Only the open-topped ones can
+    // be seen, and only where they are in front of the camera.
+    assert(grid_place_room(0, 0, &north_east_room) == 0);
+    assert(grid_place_room(-1, 0, &closed_room) == 0);
+    assert(grid_place_room(-1, -1, &open_closed_room) == 0);
+    assert(grid_place_room(1, -2, &open_closed_room) == 0);
+    assert(grid_place_room(0, 2, &open_closed_room) == 0);
+
+    // Looking south from the origin room, as in
+    // test_doorways_out_of_view_are_skipped.
+    Matrix camera_view = MatrixLookAt((Vector3){0.0F, 0.0F, 5.0F},
+                                      (Vector3){0.0F, 0.0F, -20.0F},
+                                      (Vector3){0.0F, 1.0F, 0.0F});
+    Matrix projection = MatrixPerspective(60.0 * DEG2RAD, 1.0, 0.1, 1000.0);
+    struct frustum frustum =
+        frustum_from_matrix(MatrixMultiply(camera_view, projection));
+
+    struct portal_view view = {
+        .origin_x = 0,
+        .origin_y = 0,
+        .radius = 2,
+        .cell_size = CELL_SIZE,
+        .cell_height = CELL_SIZE,
+        .frustum = &frustum,
+        .walls_occlude = true,
+    };
+    struct world_cell* cells[MAX_VISIBLE];
+    size_t count = portal_find_visible(&view, cells, MAX_VISIBLE);
+
+    assert(count == 3);
+    assert(cells[0] == grid_get_cell(0, 0));
+    assert(contains(cells, count, -1, -1));
+    assert(contains(cells, count, 1, -2));
+
+    // Without a room to stand in, open-topped rooms are still seen.
+    view.origin_x = 5;
+    view.origin_y = -1;
+    view.radius = 4;
+    count = portal_find_visible(&view, cells, MAX_VISIBLE);
+    assert(count == 1);
+    assert(contains(cells, count, 1, -2));
+
+    grid_destroy();
+}
+
+void test_open_rooms_ignore_doors(void) {
+    assert(grid_init() == 0);
+
+    // The same layout as in test_walls_block_visibility, plus a room beyond
+    // the radius.
+    assert(grid_place_room(0, 0, &north_east_room) == 0);
+    assert(grid_place_room(0, 1, &north_south_room) == 0);
+    assert(grid_place_room(1, 0, &closed_room) == 0);
+    assert(grid_place_room(0, -1, &north_south_room) == 0);
+    assert(grid_place_room(3, 0, &closed_room) == 0);
+
+    struct portal_view view = {
+        .origin_x = 0,
+        .origin_y = 0,
+        .radius = 2,
+        .cell_size = CELL_SIZE,
+        .cell_height = CELL_SIZE,
+        .walls_occlude = false,
+    };
+    struct world_cell* cells[MAX_VISIBLE];
+    size_t count = portal_find_visible(&view, cells, MAX_VISIBLE);
+
+    // Rooms without a door towards the origin are returned all the same.
+    assert(count == 4);
+    assert(cells[0] == grid_get_cell(0, 0));
+    assert(contains(cells, count, 0, 1));
+    assert(contains(cells, count, 1, 0));
+    assert(contains(cells, count, 0, -1));
+
+    // Neither does the viewer's cell have to exist.
+    view.origin_x = 2;
+    count = portal_find_visible(&view, cells, MAX_VISIBLE);
+    assert(count == 5);
+    assert(portal_find_visible(&view, cells, 2) == 2);
+
+    grid_destroy();
+}
+
+int main(void) {
+    InitWindow(100, 100, "Portal Test");
+
+    puts("Starting portal tests.\n");
+
+    RUN_TEST(test_walls_block_visibility);
+    RUN_TEST(test_flood_fill_stops_at_radius);
+    RUN_TEST(test_doorways_out_of_view_are_skipped);
+    RUN_TEST(test_open_topped_rooms_are_seen_over_walls);
+    RUN_TEST(test_open_rooms_ignore_doors);
+
+    puts("\nAll portal tests passed successfully!");
+
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "game/world/room_batch.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game/world/model_cache.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static struct room_def mock_template_1 = {
+    .model_path = "assets/models/rooms/hallway_0.glb",
+    .door_mask = 0};
+static struct room_def mock_template_2 = {
+    .model_path = "assets/models/rooms/cube_room_0.glb",
+    .door_mask = 0};
+
+void test_rooms_are_grouped_by_template(void) {
+    assert(model_cache_init() == 0);
+
+    Model first = {0};
+    Model second = {0};
+    assert(model_cache_acquire(&mock_template_1, &first) == 0);
+    assert(model_cache_acquire(&mock_template_2, &second) == 0);
+
+    // Interleave the templates so that grouping has to reorder the rooms.
+    room_batch_begin();
+    for (int i = 0; i < 6; i++) {
+        Vector3 position = {(float)i * 20.0F, 0.0F, 0.0F};
+        if (i % 3 == 0) {
+            assert(room_batch_add(&mock_template_2, second, position, 5.0F) ==
+                   0);
+        } else {
+            assert(room_batch_add(&mock_template_1, first, position, 5.0F) ==
+                   0);
+        }
+    }
+    room_batch_end();
+
+    assert(room_batch_get_room_count() == 6);
+    if (room_batch_is_instanced()) {
+        assert(room_batch_get_draw_count() ==
+               (size_t)(first.meshCount + second.meshCount));
+    } else {
+        assert(room_batch_get_draw_count() ==
+               (size_t)((4 * first.meshCount) + (2 * second.meshCount)));
+    }
+
+    model_cache_destroy();
+}
+
+void test_batch_grows_past_initial_capacity(void) {
+    assert(model_cache_init() == 0);
+
+    Model model = {0};
+    assert(model_cache_acquire(&mock_template_1, &model) == 0);
+
+    room_batch_begin();
+    for (int y = 0; y < 20; y++) {
+        for (int x = 0; x < 20; x++) {
+            Vector3 position = {(float)x * 20.0F, 0.0F, (float)y * 20.0F};
+            assert(room_batch_add(&mock_template_1, model, position, 5.0F) ==
+                   0);
+        }
+    }
+    room_batch_end();
+
+    assert(room_batch_get_room_count() == 400);
+    if (room_batch_is_instanced()) {
+        assert(room_batch_get_draw_count() == (size_t)model.meshCount);
+    }
+
+    model_cache_destroy();
+}
+
+void test_invalid_arguments(void) {
+    Model model = {0};
+    Vector3 position = {0};
+
+    assert(room_batch_add(&mock_template_1, model, position, 1.0F) ==
+           -ECANCELED);
+
+    room_batch_begin();
+    assert(room_batch_add(nullptr, model, position, 1.0F) == -EINVAL);
+    room_batch_end();
+    assert(room_batch_get_room_count() == 0);
+    assert(room_batch_get_draw_count() == 0);
+}
+
+int main(void) {
+    InitWindow(100, 100, "Room Batch Test");
+    assert(room_batch_init() == 0);
+
+    puts("Starting room batch tests.\n");
+
+    RUN_TEST(test_rooms_are_grouped_by_template);
+    RUN_TEST(test_batch_grows_past_initial_capacity);
+    RUN_TEST(test_invalid_arguments);
+
+    puts("\nAll room batch tests passed successfully!");
+
+    room_batch_destroy();
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
@@ -101,6 +101,29 @@ void test_load_and_unload(void) {
     assert(room_def_get_count() == 0);
 }
 
+void test_roofed_rooms_are_marked(void) {
+    char full_path[256];
+    (void)snprintf(full_path, sizeof(full_path), "%s/%s", TEST_DIR,
+                   ROOMS_SUBDIR);
+    char roofed_path[256];
+    (void)snprintf(roofed_path, sizeof(roofed_path),
+                   "%s/%s/hallway_90_roofed.glb", TEST_DIR, ROOMS_SUBDIR);
+    create_dummy_file(roofed_path);
+
+    assert(room_def_load_all(full_path) == 4);
+    for (size_t i = 0; i < room_def_get_count(); i++) {
+        const struct room_def* temp = room_def_get_by_index(i);
+        bool is_roofed = strstr(temp->model_path, "_roofed") != nullptr;
+        assert(temp->is_open_topped == !is_roofed);
+        if (is_roofed) {
+            assert(temp->door_mask == (DOOR_EAST | DOOR_WEST));
+        }
+    }
+
+    room_def_unload_all();
+    (void)remove(roofed_path);
+}
+
 void test_double_load_and_unload(void) {
     char full_path[256];
     (void)snprintf(full_path, sizeof(full_path), "%s/%s", TEST_DIR,
@@ -194,13 +217,85 @@ void test_remove_room_def(void) {
     room_def_unload_all();
 }
 
+void test_ids_survive_removal(void) {
+    char full_path[256];
+    (void)snprintf(full_path, sizeof(full_path), "%s/%s", TEST_DIR,
+                   ROOMS_SUBDIR);
+    room_def_load_all(full_path);
+
+    for (uint16_t id = 0; id < 3; id++) {
+        assert(room_def_get_by_id(id)->id == id);
+    }
+    assert(room_def_get_by_id(3) == nullptr);
+
+    const struct room_def* removed = room_def_get_by_index(0);
+    room_def_remove(removed);
+    assert(room_def_get_by_id(removed->id) == removed);
+
+    room_def_unload_all();
+    assert(room_def_get_by_id(0) == nullptr);
+}
+
+void test_find_constrained_mask_bits(void) {
+    char full_path[256];
+    (void)snprintf(full_path, sizeof(full_path), "%s/%s", TEST_DIR,
+                   ROOMS_SUBDIR);
+    room_def_load_all(full_path);
+    rng_init(7);
+
+    assert(room_def_find_constrained(DOOR_SOUTH | 0x10U, 0) == nullptr);
+
+    const struct room_def* match =
+        room_def_find_constrained(DOOR_SOUTH, DOOR_NORTH | 0xF0U);
+    assert(match != nullptr);
+    assert((match->door_mask & DOOR_NORTH) == 0);
+
+    room_def_unload_all();
+    assert(room_def_find_constrained(DOOR_SOUTH, 0) == nullptr);
+}
+
+void test_remove_updates_constraints(void) {
+    char full_path[256];
+    (void)snprintf(full_path, sizeof(full_path), "%s/%s", TEST_DIR,
+                   ROOMS_SUBDIR);
+    room_def_load_all(full_path);
+    rng_init(42);
+
+    const struct room_def* removed = nullptr;
+    for (size_t i = 0; i < room_def_get_count(); i++) {
+        const struct room_def* temp = room_def_get_by_index(i);
+        if (strstr(temp->model_path, "L_room_270.glb")) {
+            removed = temp;
+            break;
+        }
+    }
+    assert(removed != nullptr);
+
+    room_def_remove(removed);
+
+    for (int i = 0; i < 100; i++) {
+        const struct room_def* match =
+            room_def_find_constrained(DOOR_SOUTH, DOOR_NORTH);
+        assert(match != nullptr);
+        assert(match != removed);
+        assert(strstr(match->model_path, "deadend_0.glb"));
+    }
+    assert(room_def_find_constrained(DOOR_WEST, 0) == nullptr);
+
+    room_def_unload_all();
+}
+
 int main(void) {
     puts("Starting room_def tests.\n");
 
     RUN_TEST(test_load_and_unload);
+    RUN_TEST(test_roofed_rooms_are_marked);
     RUN_TEST(test_double_load_and_unload);
     RUN_TEST(test_find_constrained);
     RUN_TEST(test_remove_room_def);
+    RUN_TEST(test_ids_survive_removal);
+    RUN_TEST(test_find_constrained_mask_bits);
+    RUN_TEST(test_remove_updates_constraints);
 
     puts("\nAll room_def tests passed successfully!");
     return EXIT_SUCCESS;
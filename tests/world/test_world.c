@@ -26,6 +26,13 @@ int main(void) {
     while (!WindowShouldClose()) {
         UpdateCamera(&camera, CAMERA_FREE);
 
+        if (IsKeyPressed(KEY_EQUAL)) {
+            world_set_load_radius(world_get_load_radius() + 1);
+        }
+        if (IsKeyPressed(KEY_MINUS)) {
+            world_set_load_radius(world_get_load_radius() - 1);
+        }
+
         world_update(camera.position);
 
         BeginDrawing();
@@ -41,6 +48,8 @@ int main(void) {
         DrawFPS(10, 10);
         DrawText("Free camera controls: Move (W,A,S,D), Look (Mouse)", 10, 40,
                  20, DARKGRAY);
+        DrawText(TextFormat("Load radius (+/-): %d", world_get_load_radius()),
+                 10, 70, 20, DARKGRAY);
 
         EndDrawing();
     }
@@ -0,0 +1,155 @@
+#include "game/world/world_file.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game/world/grid.h"
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static const char* TEST_PATH = "test_world_file.world";
+static const char* const NAMES[] = {"starting_room.glb", "hallway_0.glb",
+                                    "cross_room_0.glb"};
+
+static struct world_file_info make_info(void) {
+    return (struct world_file_info){
+        .seed = 42,
+        .rng_state = {1, 2, 3, 4},
+        .rng_mode = 1,
+        .names = NAMES,
+        .template_count = 3,
+    };
+}
+
+static void write_bytes(const char* path, const void* data, size_t size) {
+    FILE* out = fopen(path, "wb");
+    assert(out);
+    assert(fwrite(data, 1, size, out) == size);
+    assert(fclose(out) == 0);
+}
+
+void test_write_and_open(void) {
+    struct world_file_entry rooms[] = {
+        {.x = GRID_REGION_SIZE + 1, .y = 0, .template_index = 1},
+        {.x = 0, .y = 0, .template_index = 0},
+        {.x = -1, .y = -1, .template_index = 2},
+        {.x = 3, .y = 2, .template_index = 1},
+        {.x = 2, .y = 3, .template_index = 2},
+    };
+    struct world_file_info info = make_info();
+    assert(world_file_write(TEST_PATH, &info, rooms, 5) == 0);
+
+    struct world_file file;
+    assert(world_file_open(&file, TEST_PATH) == 0);
+    assert(file.header->seed == 42);
+    assert(file.header->rng_state[3] == 4);
+    assert(file.header->rng_mode == 1);
+    assert(file.header->region_count == 3);
+    assert(file.header->room_count == 5);
+    assert(strcmp(world_file_get_name(&file, 1), "hallway_0.glb") == 0);
+    assert(world_file_get_name(&file, 3) == nullptr);
+
+    // Regions are sorted by (y, x); (-1, -1) comes first.
+    assert(file.regions[0].x == -1 && file.regions[0].y == -1);
+    const struct world_file_room* room =
+        world_file_get_rooms(&file, &file.regions[0]);
+    assert(room[0].offset_x == GRID_REGION_SIZE - 1);
+    assert(room[0].offset_y == GRID_REGION_SIZE - 1);
+    assert(room[0].template_index == 2);
+
+    // Rooms of a region are sorted by (offset_y, offset_x).
+    const struct world_file_region* region =
+        world_file_find_region(&file, 0, 0);
+    assert(region && region->room_count == 3);
+    room = world_file_get_rooms(&file, region);
+    assert(room[0].offset_x == 0 && room[0].offset_y == 0);
+    assert(room[1].offset_x == 3 && room[1].offset_y == 2);
+    assert(room[2].offset_x == 2 && room[2].offset_y == 3);
+
+    region = world_file_find_region(&file, 1, 0);
+    assert(region && region->room_count == 1);
+    assert(world_file_get_rooms(&file, region)[0].offset_x == 1);
+
+    assert(world_file_find_region(&file, 0, -1) == nullptr);
+    assert(world_file_find_region(&file, 2, 0) == nullptr);
+
+    // A mapping stays valid while the file is written over.
+    assert(world_file_write(TEST_PATH, &info, rooms, 1) == 0);
+    assert(file.header->room_count == 5);
+    world_file_close(&file);
+
+    assert(world_file_open(&file, TEST_PATH) == 0);
+    assert(file.header->room_count == 1);
+    world_file_close(&file);
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_write_rejects_invalid_rooms(void) {
+    struct world_file_entry rooms[] = {{.x = 0, .y = 0, .template_index = 3}};
+    struct world_file_info info = make_info();
+    assert(world_file_write(TEST_PATH, &info, rooms, 1) == -EINVAL);
+
+    char long_name[WORLD_FILE_NAME_SIZE + 1];
+    memset(long_name, 'a', WORLD_FILE_NAME_SIZE);
+    long_name[WORLD_FILE_NAME_SIZE] = '\0';
+    const char* const names[] = {long_name};
+    info.names = names;
+    info.template_count = 1;
+    assert(world_file_write(TEST_PATH, &info, nullptr, 0) == -EINVAL);
+
+    struct world_file file;
+    assert(world_file_open(&file, TEST_PATH) == -ENOENT);
+}
+
+void test_open_rejects_invalid_files(void) {
+    struct world_file file;
+    assert(world_file_open(&file, "missing.world") == -ENOENT);
+
+    const char garbage[] = "definitely not a world file";
+    write_bytes(TEST_PATH, garbage, sizeof(garbage));
+    assert(world_file_open(&file, TEST_PATH) == -EINVAL);
+
+    struct world_file_entry rooms[] = {{.x = 5, .y = -5, .template_index = 0}};
+    struct world_file_info info = make_info();
+    assert(world_file_write(TEST_PATH, &info, rooms, 1) == 0);
+
+    assert(world_file_open(&file, TEST_PATH) == 0);
+    size_t size = file.size;
+    unsigned char* copy = malloc(size);
+    memcpy(copy, file.data, size);
+    world_file_close(&file);
+
+    write_bytes(TEST_PATH, copy, size - 1);
+    assert(world_file_open(&file, TEST_PATH) == -EINVAL);
+
+    ((struct world_file_header*)copy)->version = WORLD_FILE_VERSION + 1;
+    write_bytes(TEST_PATH, copy, size);
+    assert(world_file_open(&file, TEST_PATH) == -EINVAL);
+
+    ((struct world_file_header*)copy)->version = WORLD_FILE_VERSION;
+    ((struct world_file_header*)copy)->region_size = GRID_REGION_SIZE * 2;
+    write_bytes(TEST_PATH, copy, size);
+    assert(world_file_open(&file, TEST_PATH) == -EINVAL);
+
+    free(copy);
+    assert(remove(TEST_PATH) == 0);
+}
+
+int main(void) {
+    puts("Starting world_file tests.\n");
+
+    RUN_TEST(test_write_and_open);
+    RUN_TEST(test_write_rejects_invalid_rooms);
+    RUN_TEST(test_open_rejects_invalid_files);
+
+    puts("\nAll world_file tests passed successfully!");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include "game/world/world.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#define MKDIR(path) _mkdir(path)
+#define RMDIR(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define MKDIR(path) mkdir(path, 0755)
+#define RMDIR(path) rmdir(path)
+#endif
+
+#define RUN_TEST(test)                          \
+    do {                                        \
+        printf("Running test: %s...\n", #test); \
+        test();                                 \
+    } while (0)
+
+static const char* TEST_PATH = "test_world_load.world";
+static const char* ROOMS_PATH = "assets/models/rooms";
+#define NO_START_DIR "test_world_load_assets"
+
+static void write_save(void) {
+    assert(world_init(7, ROOMS_PATH) == 0);
+    assert(world_save(TEST_PATH) == 0);
+    world_destroy();
+}
+
+static long read_save(unsigned char** data) {
+    FILE* file = fopen(TEST_PATH, "rb");
+    assert(file != nullptr);
+    assert(fseek(file, 0, SEEK_END) == 0);
+    long size = ftell(file);
+    assert(size > 0);
+    rewind(file);
+
+    *data = malloc((size_t)size);
+    assert(*data != nullptr);
+    assert(fread(*data, 1, (size_t)size, file) == (size_t)size);
+    (void)fclose(file);
+
+    return size;
+}
+
+static void rewrite_save(const unsigned char* data, long size) {
+    FILE* file = fopen(TEST_PATH, "wb");
+    assert(file != nullptr);
+    assert(fwrite(data, 1, (size_t)size, file) == (size_t)size);
+    (void)fclose(file);
+}
+
+// A failed load must leave nothing behind, so a new world can start.
+static void assert_falls_back_to_new_world(void) {
+    assert(world_load(TEST_PATH, ROOMS_PATH) != 0);
+    assert(world_update((Vector3){0}) == -EINVAL);
+    assert(world_get_cell_for_position((Vector3){0}) == nullptr);
+
+    assert(world_init(7, ROOMS_PATH) == 0);
+    assert(world_get_cell_for_position((Vector3){0}) != nullptr);
+    world_destroy();
+}
+
+void test_valid_save_loads(void) {
+    write_save();
+
+    assert(world_load(TEST_PATH, ROOMS_PATH) == 0);
+    assert(world_get_cell_for_position((Vector3){0}) != nullptr);
+    world_destroy();
+
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_truncated_save_falls_back(void) {
+    write_save();
+
+    unsigned char* data = nullptr;
+    long size = read_save(&data);
+    rewrite_save(data, size / 2);
+    free(data);
+
+    assert_falls_back_to_new_world();
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_bad_magic_falls_back(void) {
+    write_save();
+
+    unsigned char* data = nullptr;
+    long size = read_save(&data);
+    data[0] ^= 0xFFU;
+    rewrite_save(data, size);
+    free(data);
+
+    assert_falls_back_to_new_world();
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_failure_after_opening_save_falls_back(void) {
+    write_save();
+
+    // The save opens, but without a starting room the generator cannot
+    // start, so the mapped save has to be released again.
+    MKDIR(NO_START_DIR);
+    FILE* file = fopen(NO_START_DIR "/hallway_0.glb", "w");
+    assert(file != nullptr);
+    (void)fclose(file);
+
+    assert(world_load(TEST_PATH, NO_START_DIR) != 0);
+    assert(world_get_cell_for_position((Vector3){0}) == nullptr);
+
+    (void)remove(NO_START_DIR "/hallway_0.glb");
+    RMDIR(NO_START_DIR);
+
+    assert(world_load(TEST_PATH, ROOMS_PATH) == 0);
+    assert(world_get_cell_for_position((Vector3){0}) != nullptr);
+    world_destroy();
+
+    assert(remove(TEST_PATH) == 0);
+}
+
+void test_missing_save_falls_back(void) {
+    (void)remove(TEST_PATH);
+    assert_falls_back_to_new_world();
+}
+
+int main(void) {
+    InitWindow(100, 100, "World Load Test");
+
+    puts("Starting world load tests.\n");
+
+    RUN_TEST(test_valid_save_loads);
+    RUN_TEST(test_truncated_save_falls_back);
+    RUN_TEST(test_bad_magic_falls_back);
+    RUN_TEST(test_failure_after_opening_save_falls_back);
+    RUN_TEST(test_missing_save_falls_back);
+
+    puts("\nAll world load tests passed successfully!");
+
+    CloseWindow();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/**
+ * Converts a GIF animation into the preprocessed .anim format read by
+ * anim_file_open(). The frames are decoded with raylib, trimmed, and stored
+ * raw together with the frame delays, which raylib does not expose and are
+ * therefore read from the GIF's graphic control extensions directly.
+ *
+ * Usage: anim_convert <input.gif> <output.anim>
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raylib.h"
+
+#include "game/anim_file.h"
+
+enum {
+    GIF_HEADER_SIZE = 13,
+    GIF_DESCRIPTOR_SIZE = 9,
+    GIF_EXTENSION = 0x21,
+    GIF_IMAGE = 0x2C,
+    GIF_TRAILER = 0x3B,
+    GIF_GRAPHIC_CONTROL = 0xF9,
+    GIF_COLOR_TABLE_FLAG = 0x80,
+};
+
+static int read_gif_delays(const unsigned char* data,
+                           int size,
+                           int* delays_ms,
+                           int max_frames);
+static int skip_sub_blocks(const unsigned char* data, int size, int* pos);
+static int color_table_size(unsigned char packed);
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        (void)fprintf(stderr, "usage: %s <input.gif> <output.anim>\n",
+                      argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    int frame_count = 0;
+    Image frames = LoadImageAnim(argv[1], &frame_count);
+    if (!frames.data) {
+        (void)fprintf(stderr, "anim_convert: cannot load %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    int* delays_ms = calloc(frame_count, sizeof(int));
+    int data_size = 0;
+    unsigned char* data = LoadFileData(argv[1], &data_size);
+    if (delays_ms && data &&
+        read_gif_delays(data, data_size, delays_ms, frame_count) < 0) {
+        (void)fprintf(stderr, "anim_convert: no frame delays in %s\n",
+                      argv[1]);
+    }
+    UnloadFileData(data);
+
+    int ret = anim_file_write(argv[2], frames, frame_count, delays_ms);
+    free(delays_ms);
+    UnloadImage(frames);
+
+    if (ret != 0) {
+        (void)fprintf(stderr, "anim_convert: cannot write %s: %s\n", argv[2],
+                      strerror(-ret));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Walks the GIF block structure and records the delay of every image, in
+ * milliseconds. Returns the number of images found, or -EINVAL if the data
+ * is not a well-formed GIF.
+ */
+static int read_gif_delays(const unsigned char* data,
+                           int size,
+                           int* delays_ms,
+                           int max_frames) {
+    if (size < GIF_HEADER_SIZE || memcmp(data, "GIF", 3) != 0) {
+        return -EINVAL;
+    }
+
+    int pos = GIF_HEADER_SIZE + color_table_size(data[10]);
+    int frame = 0;
+    int pending_delay = 0;
+
+    while (pos < size) {
+        unsigned char block = data[pos++];
+
+        if (block == GIF_TRAILER) {
+            return frame;
+        }
+
+        if (block == GIF_EXTENSION) {
+            if (pos >= size) {
+                return -EINVAL;
+            }
+            unsigned char label = data[pos++];
+            if (label == GIF_GRAPHIC_CONTROL && pos + 4 < size &&
+                data[pos] == 4) {
+                pending_delay = (data[pos + 2] | (data[pos + 3] << 8)) * 10;
+            }
+        } else if (block == GIF_IMAGE) {
+            if (pos + GIF_DESCRIPTOR_SIZE >= size) {
+                return -EINVAL;
+            }
+            pos += GIF_DESCRIPTOR_SIZE +
+                   color_table_size(data[pos + GIF_DESCRIPTOR_SIZE - 1]);
+            pos++;  // LZW minimum code size
+
+            if (frame < max_frames) {
+                delays_ms[frame] = pending_delay;
+            }
+            frame++;
+            pending_delay = 0;
+        } else {
+            return -EINVAL;
+        }
+
+        if (skip_sub_blocks(data, size, &pos) != 0) {
+            return -EINVAL;
+        }
+    }
+
+    return -EINVAL;
+}
+
+static int skip_sub_blocks(const unsigned char* data, int size, int* pos) {
+    while (*pos < size) {
+        int length = data[(*pos)++];
+        if (length == 0) {
+            return 0;
+        }
+        *pos += length;
+    }
+
+    return -EINVAL;
+}
+
+static int color_table_size(unsigned char packed) {
+    if (!(packed & GIF_COLOR_TABLE_FLAG)) {
+        return 0;
+    }
+
+    return 3 * (1 << ((packed & 0x07) + 1));
+}